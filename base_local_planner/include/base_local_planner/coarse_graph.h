@@ -0,0 +1,118 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the Willow Garage nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+#ifndef TRAJECTORY_ROLLOUT_COARSE_GRAPH_H_
+#define TRAJECTORY_ROLLOUT_COARSE_GRAPH_H_
+
+#include <cstddef>
+#include <vector>
+#include <utility>
+#include <costmap_2d/costmap_2d.h>
+
+namespace base_local_planner {
+  /**
+   * @class CoarseGraph
+   * @brief The free space of a costmap at a coarse resolution, for distances far from the robot. The free cells within
+   * a coarse cell that are connected to each other form a node, so a coarse cell cut by a thin wall becomes one node per
+   * side while a corridor narrower than it stays open. Neighboring nodes are linked where free cells of both touch.
+   * The graph only depends on the costmap, so all distance grids of a planning cycle share one.
+   */
+  class CoarseGraph {
+    public:
+      static const unsigned int NO_NODE = 0xffffffff; ///< @brief The node of a cell that is an obstacle
+
+      /**
+       * @brief  Creates an empty graph
+       */
+      CoarseGraph();
+
+      /**
+       * @brief  Rebuild the graph, reusing the memory of the last one
+       * @param costmap The costmap, its lethal, inscribed and unknown cells belong to no node
+       * @param factor The number of cells per coarse cell along each axis
+       */
+      void update(const costmap_2d::Costmap2D& costmap, unsigned int factor);
+
+      unsigned int getFactor() const { return factor_; }
+
+      unsigned int getNumNodes() const { return num_nodes_; }
+
+      /**
+       * @brief  The node of a cell, NO_NODE for an obstacle
+       */
+      inline unsigned int getNode(unsigned int x, unsigned int y) const {
+        return node_[size_x_ * y + x];
+      }
+
+      /**
+       * @brief  Where the neighbors of a node start in the links, they end where those of the next node start
+       */
+      inline unsigned int linkStart(unsigned int node) const {
+        return link_start_[node];
+      }
+
+      /**
+       * @brief  A neighbor of a node, by its index in the links
+       */
+      inline unsigned int link(unsigned int index) const {
+        return links_[index];
+      }
+
+      /**
+       * @brief  The heap memory the graph holds, reserved capacity included
+       */
+      size_t getMemoryUsage() const;
+
+      unsigned int size_x_, size_y_; ///< @brief The dimensions of the costmap the graph was built for
+
+    private:
+      /**
+       * @brief  Link the nodes on both sides of a coarse cell border
+       * @param start The index of the first cell on the near side of the border
+       * @param step The index difference of consecutive cells along the border
+       * @param across The index difference of a cell and the cell across the border from it
+       * @param length The number of cells along the border
+       */
+      void addLinks(unsigned int start, unsigned int step, unsigned int across, unsigned int length);
+
+      unsigned int factor_; ///< @brief Cells per coarse cell along each axis
+      unsigned int num_nodes_;
+      std::vector<unsigned int> node_; ///< @brief The node of each cell, NO_NODE for obstacles
+      std::vector<unsigned int> link_start_; ///< @brief Where the neighbors of each node start in links_
+      std::vector<unsigned int> links_; ///< @brief The neighboring nodes of all nodes, one after another
+      std::vector<unsigned int> fill_; ///< @brief The cells waiting to join the node being grown
+      std::vector<std::pair<unsigned int, unsigned int> > pairs_; ///< @brief Both directions of every link, before sorting
+  };
+};
+
+#endif
@@ -0,0 +1,147 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the Willow Garage nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef TRAJECTORY_ROLLOUT_COST_BOUNDS_GRID_H_
+#define TRAJECTORY_ROLLOUT_COST_BOUNDS_GRID_H_
+
+#include <cstddef>
+#include <vector>
+#include <costmap_2d/costmap_2d.h>
+
+namespace base_local_planner {
+  /**
+   * @class CostBoundsGrid
+   * @brief Holds, for every cell of a costmap, the maximum and the minimum cost within a square
+   * window around it. If the window covers the circumscribed circle of the robot, these bound the
+   * cost of every footprint cell for a robot centered on that cell, whatever its orientation.
+   */
+  class CostBoundsGrid {
+    public:
+      /**
+       * @brief  Creates an empty grid, with window radius 0
+       */
+      CostBoundsGrid();
+
+      /**
+       * @brief  Set the half size of the windows
+       * @param radius The number of cells the windows extend to each side of their center cell
+       */
+      void setRadius(unsigned int radius);
+
+      /**
+       * @brief  Compute the window radius in cells needed to cover a footprint in any orientation
+       * @param footprint The footprint of the robot, relative to its center
+       * @param resolution The resolution of the costmap
+       * @return The window radius, 0 for footprints with less than 3 points which are treated as a point robot
+       */
+      static unsigned int footprintRadius(const std::vector<geometry_msgs::Point>& footprint, double resolution);
+
+      /**
+       * @brief  The cost a window maximum has to stay below for a footprint centered on the window to be legal
+       * @param footprint The footprint of the robot, relative to its center
+       * @return LETHAL_OBSTACLE for polygons, whose outline may cross inscribed cells, and INSCRIBED_INFLATED_OBSTACLE
+       * for footprints with less than 3 points, whose center cell may not be inscribed
+       */
+      static unsigned char legalCostLimit(const std::vector<geometry_msgs::Point>& footprint);
+
+      /**
+       * @brief  Recompute the bounds of all cells from the costmap
+       * @param costmap The costmap to compute the bounds for
+       */
+      void update(const costmap_2d::Costmap2D& costmap);
+
+      /**
+       * @brief  Recompute only the bounds a change of costs within a region can affect, falls back
+       * to a full update when the size of the costmap or the window radius changed since the last one.
+       * An empty region, x0 > x1, only does that fall back if needed.
+       * @param costmap The costmap to compute the bounds for
+       * @param x0 The lower x coordinate of the changed cells
+       * @param y0 The lower y coordinate of the changed cells
+       * @param x1 The upper x coordinate of the changed cells, inclusive
+       * @param y1 The upper y coordinate of the changed cells, inclusive
+       */
+      void updateRegion(const costmap_2d::Costmap2D& costmap, unsigned int x0, unsigned int y0, unsigned int x1, unsigned int y1);
+
+      /**
+       * @brief  The heap memory the bounds and their scratch space hold, reserved capacity included
+       */
+      size_t getMemoryUsage() const;
+
+      /**
+       * @brief  Get the maximum cost within the window around a cell
+       * @param mx The x coordinate of the cell
+       * @param my The y coordinate of the cell
+       * @param cost Will be set to the maximum cost
+       * @return False if the window is not completely inside the map, in which case cost is not a bound
+       */
+      inline bool maxCost(unsigned int mx, unsigned int my, unsigned char& cost) const {
+        if (mx < radius_ || my < radius_ || mx + radius_ >= size_x_ || my + radius_ >= size_y_) {
+          return false;
+        }
+        cost = max_cost_[my * size_x_ + mx];
+        return true;
+      }
+
+      /**
+       * @brief  Get the minimum cost within the window around a cell, the parts of the window outside the map are ignored.
+       * The window is the same circumscribed square as for maxCost: a polygon footprint is only checked along its outline,
+       * which may lie anywhere in that square, so only a minimum over all of it bounds the cost of the outline.
+       * @param mx The x coordinate of the cell
+       * @param my The y coordinate of the cell
+       * @return The minimum cost
+       */
+      inline unsigned char minCost(unsigned int mx, unsigned int my) const {
+        return min_cost_[my * size_x_ + mx];
+      }
+
+    private:
+      /**
+       * @brief  Running maximum or minimum over one row or column, using the van Herk/Gil-Werman
+       * algorithm so the cost per cell does not depend on the window size
+       */
+      void filterLine(const unsigned char* in, unsigned char* out, unsigned int n, unsigned int stride, bool take_max);
+
+      unsigned int size_x_, size_y_; ///< @brief The size of the grid in cells
+      unsigned int radius_; ///< @brief The half size of the windows in cells
+      unsigned int computed_radius_; ///< @brief The radius the bounds were last fully computed with
+      bool computed_; ///< @brief True once the bounds were fully computed
+
+      std::vector<unsigned char> max_cost_; ///< @brief The maximum cost around each cell
+      std::vector<unsigned char> min_cost_; ///< @brief The minimum cost around each cell
+      std::vector<unsigned char> max_rows_, min_rows_; ///< @brief Row pass results, kept so a region update only redoes the rows it changed
+      std::vector<unsigned char> prefix_, suffix_; ///< @brief Scratch space for filterLine
+  };
+};
+
+#endif
@@ -0,0 +1,141 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the Willow Garage nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef TRAJECTORY_ROLLOUT_COSTMAP_MIRROR_H_
+#define TRAJECTORY_ROLLOUT_COSTMAP_MIRROR_H_
+
+#include <vector>
+#include <costmap_2d/costmap_2d.h>
+#include <nav_msgs/OccupancyGrid.h>
+#include <map_msgs/OccupancyGridUpdate.h>
+
+namespace base_local_planner {
+  /**
+   * @class CostmapMirror
+   * @brief A costmap owned by the planner, kept up to date from full maps and bounded patches
+   * instead of sharing the costmap of move_base, so the planner can run in a process of its own.
+   * The mirror remembers the bounds of the cells that changed since they were last taken, which
+   * lets the structures derived from the costmap recompute only what the updates touched.
+   *
+   * The updates lock the mutex of the mirrored costmap, whoever reads it holds that mutex
+   * for as long as it does, like move_base does with its own costmap.
+   */
+  class CostmapMirror {
+    public:
+      /**
+       * @brief  Creates an empty mirror, the first full map sets its size
+       */
+      CostmapMirror();
+
+      /**
+       * @brief  Replace the whole costmap, resizing it if the geometry of the map changed
+       * @param size_x The width of the map in cells
+       * @param size_y The height of the map in cells
+       * @param resolution The resolution of the map in meters per cell
+       * @param origin_x The x coordinate of the map origin
+       * @param origin_y The y coordinate of the map origin
+       * @param costs size_x * size_y costs, row by row
+       */
+      void setMap(unsigned int size_x, unsigned int size_y, double resolution,
+          double origin_x, double origin_y, const unsigned char* costs);
+
+      /**
+       * @brief  Copy costs into a rectangle of the map, the parts outside the map are dropped
+       * @param x0 The x coordinate of the lower left cell of the patch
+       * @param y0 The y coordinate of the lower left cell of the patch
+       * @param width The width of the patch in cells
+       * @param height The height of the patch in cells
+       * @param costs width * height costs, row by row
+       * @return False if the patch does not overlap the map
+       */
+      bool applyPatch(int x0, int y0, unsigned int width, unsigned int height, const unsigned char* costs);
+
+      /**
+       * @brief  Replace the whole costmap from a map published by a costmap_2d publisher
+       * @param map The map, with costs translated to occupancy values
+       */
+      void setMap(const nav_msgs::OccupancyGrid& map);
+
+      /**
+       * @brief  Apply an update published by a costmap_2d publisher
+       * @param update The bounded patch, with costs translated to occupancy values
+       * @return False if the patch is malformed or does not overlap the map
+       */
+      bool applyUpdate(const map_msgs::OccupancyGridUpdate& update);
+
+      /**
+       * @brief  Take the bounds of the cells changed since the last call
+       * @param x0 Will be set to the lower x coordinate of the changed cells
+       * @param y0 Will be set to the lower y coordinate of the changed cells
+       * @param x1 Will be set to the upper x coordinate of the changed cells, inclusive
+       * @param y1 Will be set to the upper y coordinate of the changed cells, inclusive
+       * @param resized Will be set to true if the map was replaced with one of another size, resolution or origin,
+       * in which case the bounds cover the whole map but nothing derived from the old map is valid
+       * @return False if no cell changed
+       */
+      bool takeChanges(unsigned int& x0, unsigned int& y0, unsigned int& x1, unsigned int& y1, bool& resized);
+
+      /**
+       * @brief  The number of maps and patches applied so far
+       */
+      unsigned int getRevision() const { return revision_; }
+
+      /**
+       * @brief  The mirrored costmap, to construct the planner and its world model on
+       */
+      costmap_2d::Costmap2D& getCostmap() { return costmap_; }
+
+      /**
+       * @brief  Invert the translation of costs to occupancy values costmap_2d publishers apply
+       * @param value The occupancy value, -1 for unknown
+       * @return The highest cost that translates to the value, so a mirror never underestimates a cost
+       */
+      static unsigned char occupancyToCost(int value);
+
+    private:
+      /**
+       * @brief  Grow the changed bounds by a rectangle of cells, must be called with the costmap locked
+       */
+      void markChanged(unsigned int x0, unsigned int y0, unsigned int x1, unsigned int y1);
+
+      costmap_2d::Costmap2D costmap_; ///< @brief The mirrored costmap
+      bool changed_; ///< @brief True if a cell changed since the changes were last taken
+      bool resized_; ///< @brief True if the map geometry changed since the changes were last taken
+      unsigned int changed_x0_, changed_y0_, changed_x1_, changed_y1_; ///< @brief The bounds of the changed cells, inclusive
+      unsigned int revision_; ///< @brief The number of maps and patches applied
+      std::vector<unsigned char> costs_; ///< @brief Scratch space for translated occupancy values
+  };
+};
+
+#endif
@@ -38,6 +38,7 @@
 #define TRAJECTORY_ROLLOUT_COSTMAP_MODEL_
 
 #include <base_local_planner/world_model.h>
+#include <base_local_planner/footprint_set.h>
 // For obstacle data access
 #include <costmap_2d/costmap_2d.h>
 
@@ -73,6 +74,15 @@ namespace base_local_planner {
       virtual double footprintCost(const geometry_msgs::Point& position, const std::vector<geometry_msgs::Point>& footprint,
           double inscribed_radius, double circumscribed_radius);
 
+      /**
+       * @brief  Checks the cells of a precomputed footprint outline for collisions, without rasterizing the polygon
+       * @param  cell_x The x position of the robot center in cell coordinates
+       * @param  cell_y The y position of the robot center in cell coordinates
+       * @param  outline The outline cells relative to the robot center, for the heading of the robot
+       * @return The highest cost under the outline, negative if it hits an obstacle or leaves the map
+       */
+      double outlineCost(unsigned int cell_x, unsigned int cell_y, const FootprintOutline& outline) const;
+
       /**
        * @brief  Rasterizes a line in the costmap grid and checks for collisions
        * @param x0 The x position of the first cell in grid coordinates
@@ -0,0 +1,113 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the Willow Garage nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+#ifndef BASE_LOCAL_PLANNER_FOOTPRINT_SET_H_
+#define BASE_LOCAL_PLANNER_FOOTPRINT_SET_H_
+
+#include <cstddef>
+#include <vector>
+#include <geometry_msgs/Point.h>
+
+namespace base_local_planner {
+  /**
+   * @brief The cells the outline of a footprint covers, relative to the cell of the robot center, for one range of headings
+   */
+  struct FootprintOutline {
+    FootprintOutline() : min_dx(0), max_dx(0), min_dy(0), max_dy(0) {}
+
+    std::vector<int> dx, dy; ///< @brief The cell offsets, duplicates removed
+    int min_dx, max_dx, min_dy, max_dy; ///< @brief The bounds of the offsets, to check the whole outline against the map at once
+  };
+
+  /**
+   * @class FootprintSet
+   * @brief A footprint with everything the planner derives from it, computed once when the
+   * footprint is registered so that switching to it during planning costs nothing
+   */
+  class FootprintSet {
+    public:
+      /**
+       * @brief  Compute the derived data of a footprint
+       * @param footprint The footprint of the robot, relative to its center
+       * @param resolution The resolution of the costmap the footprint will be checked in
+       * @param heading_bins The number of heading ranges to build outline tables for, 0 for none
+       */
+      FootprintSet(const std::vector<geometry_msgs::Point>& footprint, double resolution, unsigned int heading_bins = 0);
+
+      const std::vector<geometry_msgs::Point>& getFootprint() const { return footprint_; }
+
+      double getInscribedRadius() const { return inscribed_radius_; }
+
+      double getCircumscribedRadius() const { return circumscribed_radius_; }
+
+      /**
+       * @brief  The window radius in cells that covers the footprint in any orientation, see CostBoundsGrid::footprintRadius
+       * @param resolution The resolution of the costmap, only recomputed if it is not the one the set was built for
+       */
+      unsigned int getCellRadius(double resolution) const;
+
+      unsigned int getHeadingBins() const { return outlines_.size(); }
+
+      /**
+       * @brief  Whether outline tables were built, and for this resolution
+       */
+      bool hasOutlines(double resolution) const { return !outlines_.empty() && resolution == resolution_; }
+
+      /**
+       * @brief  The outline cells for the heading range a heading falls into. They hold every cell rasterizing the polygon can
+       * touch for a heading in the range and the robot center anywhere in its cell, so checking them is at least as strict.
+       * @param theta The heading of the robot
+       */
+      const FootprintOutline& getOutline(double theta) const;
+
+      /**
+       * @brief  The heap memory the footprint and its outline tables hold
+       */
+      size_t getMemoryUsage() const;
+
+    private:
+      /**
+       * @brief  Rasterize the outline over one heading range, every pair of cells the ends of an edge can fall into
+       */
+      void buildOutline(double min_theta, double max_theta, FootprintOutline& outline) const;
+
+
+      std::vector<geometry_msgs::Point> footprint_;
+      double inscribed_radius_, circumscribed_radius_;
+      double resolution_; ///< @brief The resolution cell_radius_ is computed for
+      unsigned int cell_radius_;
+      std::vector<FootprintOutline> outlines_; ///< @brief One outline per heading range, the first centered on heading 0
+  };
+};
+
+#endif
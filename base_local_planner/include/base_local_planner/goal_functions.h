@@ -52,6 +52,7 @@
 
 #include <angles/angles.h>
 #include <costmap_2d/costmap_2d.h>
+#include <base_local_planner/shared_plan.h>
 
 namespace base_local_planner {
 
@@ -89,6 +90,14 @@ namespace base_local_planner {
    */
   void prunePlan(const tf::Stamped<tf::Pose>& global_pose, std::vector<geometry_msgs::PoseStamped>& plan, std::vector<geometry_msgs::PoseStamped>& global_plan);
 
+  /**
+   * @brief  Trim off parts of the global plan that are far enough behind the robot, without erasing poses of the global plan
+   * @param global_pose The pose of the robot in the global frame
+   * @param plan The plan to be pruned
+   * @param global_plan The view on the plan in the frame of the planner, its start is moved past the pruned poses
+   */
+  void prunePlan(const tf::Stamped<tf::Pose>& global_pose, std::vector<geometry_msgs::PoseStamped>& plan, SharedPlan& global_plan);
+
   /**
    * @brief  Transforms the global plan of the robot from the planner frame to the frame of the costmap,
    * selects only the (first) part of the plan that is within the costmap area.
@@ -106,6 +115,22 @@ namespace base_local_planner {
       const std::string& global_frame,
       std::vector<geometry_msgs::PoseStamped>& transformed_plan);
 
+  /**
+   * @brief  Transforms the part of a shared global plan that is within the costmap area to the frame of the costmap
+   * @param tf A reference to a transform listener
+   * @param global_plan The plan to be transformed
+   * @param robot_pose The pose of the robot in the global frame (same as costmap)
+   * @param costmap A reference to the costmap being used so the window size for transforming can be computed
+   * @param global_frame The frame to transform the plan to
+   * @param transformed_plan Populated with the transformed plan, the poses it held are reused
+   */
+  bool transformGlobalPlan(const tf::TransformListener& tf,
+      const SharedPlan& global_plan,
+      const tf::Stamped<tf::Pose>& global_robot_pose,
+      const costmap_2d::Costmap2D& costmap,
+      const std::string& global_frame,
+      std::vector<geometry_msgs::PoseStamped>& transformed_plan);
+
   /**
      * @brief  Returns last pose in plan
      * @param tf A reference to a transform listener
@@ -119,6 +144,19 @@ namespace base_local_planner {
   		  const std::string& global_frame,
   		  tf::Stamped<tf::Pose> &goal_pose);
 
+  /**
+   * @brief  Returns last pose in a shared plan
+   * @param tf A reference to a transform listener
+   * @param global_plan The plan being followed
+   * @param global_frame The global frame of the local planner
+   * @param goal_pose the pose to copy into
+   * @return True if achieved, false otherwise
+   */
+  bool getGoalPose(const tf::TransformListener& tf,
+      const SharedPlan& global_plan,
+      const std::string& global_frame,
+      tf::Stamped<tf::Pose> &goal_pose);
+
   /**
    * @brief  Check if the goal pose has been achieved
    * @param tf A reference to a transform listener
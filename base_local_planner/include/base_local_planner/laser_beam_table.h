@@ -0,0 +1,84 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the Willow Garage nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+#ifndef BASE_LOCAL_PLANNER_LASER_BEAM_TABLE_H_
+#define BASE_LOCAL_PLANNER_LASER_BEAM_TABLE_H_
+
+#include <cmath>
+#include <vector>
+
+namespace base_local_planner {
+  /**
+   * @class LaserBeamTable
+   * @brief The directions of the beams of a laser scanner, computed once for its geometry
+   * and reused for every scan with the same angles and number of beams
+   */
+  class LaserBeamTable {
+    public:
+      LaserBeamTable() : angle_min_(0.0), angle_increment_(0.0) {}
+
+      /**
+       * @brief  Recompute the table if the geometry of the scanner changed
+       * @param  angle_min The angle of the first beam, in the frame of the scanner
+       * @param  angle_increment The angle between two beams
+       * @param  num_beams The number of beams in a scan
+       * @return True if the table was recomputed
+       */
+      bool update(double angle_min, double angle_increment, unsigned int num_beams){
+        if(num_beams == cos_.size() && angle_min == angle_min_ && angle_increment == angle_increment_)
+          return false;
+
+        angle_min_ = angle_min;
+        angle_increment_ = angle_increment;
+        cos_.resize(num_beams);
+        sin_.resize(num_beams);
+        for(unsigned int i = 0; i < num_beams; ++i){
+          double angle = angle_min + i * angle_increment;
+          cos_[i] = std::cos(angle);
+          sin_[i] = std::sin(angle);
+        }
+        return true;
+      }
+
+      inline double cos(unsigned int i) const { return cos_[i]; }
+      inline double sin(unsigned int i) const { return sin_[i]; }
+      inline unsigned int size() const { return cos_.size(); }
+      inline double angleMin() const { return angle_min_; }
+      inline double angleIncrement() const { return angle_increment_; }
+
+    private:
+      double angle_min_, angle_increment_;
+      std::vector<double> cos_, sin_;
+  };
+};
+#endif
@@ -65,7 +65,7 @@ public:
       geometry_msgs::Twist& cmd_vel,
       Eigen::Vector3f acc_lim,
       double sim_period,
-      base_local_planner::LocalPlannerLimits& limits,
+      const base_local_planner::LocalPlannerLimits& limits,
       boost::function<bool (Eigen::Vector3f pos,
                             Eigen::Vector3f vel,
                             Eigen::Vector3f vel_samples)> obstacle_check);
@@ -0,0 +1,96 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the Willow Garage nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef TRAJECTORY_ROLLOUT_LATENCY_HISTOGRAM_H_
+#define TRAJECTORY_ROLLOUT_LATENCY_HISTOGRAM_H_
+
+#include <vector>
+#include <string>
+
+namespace base_local_planner {
+  /**
+   * @class LatencyHistogram
+   * @brief Counts how old an input of the controller is when it is used, in buckets whose upper
+   * bounds double from one to the next, so both millisecond jitter and stalls of seconds show up.
+   */
+  class LatencyHistogram {
+    public:
+      /**
+       * @brief  Creates an empty histogram
+       * @param name The name of the input whose age is recorded
+       * @param first_bound The upper bound of the first bucket in seconds
+       * @param num_buckets The number of buckets, the last one has no upper bound
+       */
+      LatencyHistogram(const std::string& name = "", double first_bound = 0.001, unsigned int num_buckets = 12);
+
+      /**
+       * @brief  Record one age
+       * @param seconds The age in seconds, negative ages from unsynchronized clocks count as 0
+       */
+      void addSample(double seconds);
+
+      /**
+       * @brief  Forget all recorded ages
+       */
+      void reset();
+
+      const std::string& getName() const { return name_; }
+
+      /**
+       * @brief  The upper bound of every bucket but the last in seconds
+       */
+      const std::vector<double>& getBucketBounds() const { return bounds_; }
+
+      /**
+       * @brief  The number of ages recorded in each bucket
+       */
+      const std::vector<unsigned int>& getCounts() const { return counts_; }
+
+      double getLast() const { return last_; }
+
+      double getMax() const { return max_; }
+
+      unsigned int getNumSamples() const { return num_samples_; }
+
+    private:
+      std::string name_; ///< @brief The name of the input
+      std::vector<double> bounds_; ///< @brief The upper bounds of the buckets
+      std::vector<unsigned int> counts_; ///< @brief The counts of the buckets, one more than bounds_
+      double last_; ///< @brief The latest age
+      double max_; ///< @brief The largest age
+      unsigned int num_samples_; ///< @brief The number of ages recorded
+  };
+};
+
+#endif
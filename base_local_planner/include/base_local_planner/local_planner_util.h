@@ -41,12 +41,14 @@
 #include <nav_core/base_local_planner.h>
 
 #include <boost/thread.hpp>
+#include <boost/shared_ptr.hpp>
 
 #include <costmap_2d/costmap_2d.h>
 #include <tf/transform_datatypes.h>
 #include <tf/transform_listener.h>
 
 #include <base_local_planner/local_planner_limits.h>
+#include <base_local_planner/shared_plan.h>
 
 
 namespace base_local_planner {
@@ -66,15 +68,20 @@ private:
   tf::TransformListener* tf_;
 
 
-  std::vector<geometry_msgs::PoseStamped> global_plan_;
+  SharedPlan global_plan_; ///< @brief stored once per plan, pruning only moves its start
 
 
   boost::mutex limits_configuration_mutex_;
   bool setup_;
   LocalPlannerLimits default_limits_;
-  LocalPlannerLimits limits_;
+  boost::shared_ptr<const LocalPlannerLimits> limits_; ///< @brief replaced, never modified, on reconfiguration
   bool initialized_;
 
+  // the goal of the plan in the global frame, recomputed when the plan or the transform to its frame changes
+  tf::Stamped<tf::Pose> goal_pose_;
+  bool goal_pose_valid_;
+  ros::Time goal_transform_stamp_;
+
 public:
 
   /**
@@ -82,7 +89,7 @@ public:
    */
   void reconfigureCB(LocalPlannerLimits &config, bool restore_defaults);
 
-  LocalPlannerUtil() : initialized_(false) {}
+  LocalPlannerUtil() : limits_(new LocalPlannerLimits()), initialized_(false), goal_pose_valid_(false) {}
 
   ~LocalPlannerUtil() {
   }
@@ -91,6 +98,11 @@ public:
       costmap_2d::Costmap2D* costmap,
       std::string global_frame);
 
+  /**
+   * @brief  Get the last pose of the plan in the global frame. It is only transformed again when the plan
+   * or the transform to its frame changed, and then with the latest transform, so this does not wait on tf
+   * once the goal was found. Waits up to 0.5s for the transform if it was never available for this plan.
+   */
   bool getGoal(tf::Stamped<tf::Pose>& goal_pose);
 
   bool setPlan(const std::vector<geometry_msgs::PoseStamped>& orig_global_plan);
@@ -101,6 +113,12 @@ public:
 
   LocalPlannerLimits getCurrentLimits();
 
+  /**
+   * @brief  Get the current limits without copying them, they stay the same for the holder of the
+   * pointer even if the limits are reconfigured meanwhile, so one snapshot serves a whole cycle
+   */
+  boost::shared_ptr<const LocalPlannerLimits> getLimitsSnapshot();
+
   std::string getGlobalFrame(){ return global_frame_; }
 };
 
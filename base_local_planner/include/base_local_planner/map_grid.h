@@ -34,6 +34,7 @@
 #ifndef TRAJECTORY_ROLLOUT_MAP_GRID_H_
 #define TRAJECTORY_ROLLOUT_MAP_GRID_H_
 
+#include <cstddef>
 #include <vector>
 #include <iostream>
 #include <base_local_planner/trajectory_inc.h>
@@ -41,6 +42,7 @@
 #include <ros/ros.h>
 
 #include <base_local_planner/map_cell.h>
+#include <base_local_planner/coarse_graph.h>
 #include <costmap_2d/costmap_2d.h>
 #include <geometry_msgs/PoseStamped.h>
 
@@ -51,6 +53,8 @@ namespace base_local_planner{
    */
   class MapGrid{
     public:
+      static const unsigned int DISTANCE_UNITS = 16; ///< @brief Steps of the cost weighted wavefront per cell, its distances are multiples of their inverse
+
       /**
        * @brief  Creates a 0x0 map by default
        */
@@ -88,6 +92,14 @@ namespace base_local_planner{
         return map_[size_x_ * y + x];
       }
 
+      /**
+       * @brief  Returns the cells in row major order, to read their distances without copying them
+       * @return A pointer to the first cell, NULL if the grid is empty
+       */
+      inline const MapCell* getCells() const {
+        return map_.empty() ? NULL : &map_[0];
+      }
+
       /**
        * @brief  Destructor for a MapGrid
        */
@@ -145,6 +157,11 @@ namespace base_local_planner{
         return map_.size() + 1;
       }
 
+      /**
+       * @brief  The heap memory the grid holds, reserved capacity included
+       */
+      size_t getMemoryUsage() const;
+
       /**
        * @brief  Used to update the distance of a cell in path distance computation
        * @param  current_cell The cell we're currently in 
@@ -175,6 +192,29 @@ namespace base_local_planner{
        */
       void computeGoalDistance(std::queue<MapCell*>& dist_queue, const costmap_2d::Costmap2D& costmap);
 
+      /**
+       * @brief  Restrict the full resolution wavefront to a region of interest, e.g. the area the rollouts can reach.
+       * Outside of it, distances are computed on a coarse graph of the costmap. The coarse distances of the cells
+       * bordering the region then seed the full resolution wavefront inside of it. The graph does not know about the
+       * cells within the robot, which lie inside the region.
+       * @param x0 The lowest x coordinate of the region
+       * @param y0 The lowest y coordinate of the region
+       * @param x1 The highest x coordinate of the region
+       * @param y1 The highest y coordinate of the region
+       * @param coarse_graph The coarse graph of the costmap the distances are computed on, updated before they are.
+       * NULL, or a graph of another size, computes full resolution distances everywhere. It is not copied, and can be shared by several grids.
+       */
+      void setRegionOfInterest(unsigned int x0, unsigned int y0, unsigned int x1, unsigned int y1, const CoarseGraph* coarse_graph);
+
+      /**
+       * @brief  Weigh the distances by the costs of the cells they pass, instead of counting cells. Stepping into a cell
+       * then costs one cell plus weight cells scaled by its cost relative to the highest cost below INSCRIBED_INFLATED_OBSTACLE,
+       * so paths through inflation count as longer. The costs are quantised to integers and expanded with a bucket queue.
+       * Distances on the coarse grid outside of the region of interest still count cells.
+       * @param weight The extra distance in cells of stepping into a cell of the highest cost, 0 to count cells
+       */
+      void setCostWeight(double weight);
+
       /**
        * @brief Update what cells are considered path based on the global plan 
        */
@@ -192,8 +232,59 @@ namespace base_local_planner{
 
     private:
 
+      /**
+       * @brief  Whether the wavefront treats a cell as an obstacle
+       */
+      inline bool isObstacle(unsigned int x, unsigned int y, const costmap_2d::Costmap2D& costmap){
+        unsigned char cost = costmap.getCost(x, y);
+        return ! getCell(x, y).within_robot &&
+            (cost == costmap_2d::LETHAL_OBSTACLE ||
+             cost == costmap_2d::INSCRIBED_INFLATED_OBSTACLE ||
+             cost == costmap_2d::NO_INFORMATION);
+      }
+
+      /**
+       * @brief  Run the wavefront from the marked cells in dist_queue, which all have the same distance,
+       * and from the marked cells in sources, which are sorted by increasing distance
+       */
+      void propagateDistance(std::queue<MapCell*>& dist_queue, const std::vector<MapCell*>& sources,
+          const costmap_2d::Costmap2D& costmap);
+
+      /**
+       * @brief  propagateDistance with cost weighted steps: Dial's algorithm, the integer distances of the cells
+       * waiting to be expanded span at most one step, so a ring of buckets one step wide replaces the heap
+       */
+      void propagateWeightedDistance(std::queue<MapCell*>& dist_queue, const std::vector<MapCell*>& sources,
+          const costmap_2d::Costmap2D& costmap);
+
+      /**
+       * @brief  Offer a neighbor of an expanded cell a weighted distance, obstacles get obstacleCosts instead
+       */
+      inline void relaxWeightedCell(MapCell* check_cell, unsigned int dist, const unsigned char* costs, unsigned int& pending);
+
+      /**
+       * @brief  Compute distances on the coarse grid everywhere and at full resolution inside the region of interest
+       * @param dist_queue A queue of the initial cells, all at distance 0
+       */
+      void computeTargetDistanceMultiResolution(std::queue<MapCell*>& dist_queue, const costmap_2d::Costmap2D& costmap);
+
+      /**
+       * @brief  Compute distances with the region of interest if one is set, else at full resolution
+       */
+      void computeDistances(std::queue<MapCell*>& dist_queue, const costmap_2d::Costmap2D& costmap);
+
       std::vector<MapCell> map_; ///< @brief Storage for the MapCells
 
+      unsigned int roi_x0_, roi_y0_, roi_x1_, roi_y1_; ///< @brief The region of interest, inclusive
+      const CoarseGraph* coarse_graph_; ///< @brief The coarse graph outside of the region of interest, NULL if there is none
+      std::vector<unsigned int> coarse_dist_; ///< @brief Distances on the coarse graph, in coarse cells, per node
+      std::vector<MapCell*> coarse_sources_; ///< @brief The cells bordering the region of interest that seed the wavefront inside of it
+
+      double cost_weight_; ///< @brief Extra distance of stepping into a cell of the highest cost, 0 to count cells
+      std::vector<unsigned int> step_costs_; ///< @brief Integer distance of stepping into a cell of each cost
+      std::vector<unsigned int> weighted_dist_; ///< @brief Integer distances of the cost weighted wavefront
+      std::vector<std::vector<MapCell*> > buckets_; ///< @brief The ring of buckets of the cost weighted wavefront
+
   };
 };
 
@@ -0,0 +1,68 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the Willow Garage nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+#ifndef BASE_LOCAL_PLANNER_MEMORY_USAGE_H_
+#define BASE_LOCAL_PLANNER_MEMORY_USAGE_H_
+
+#include <stdint.h>
+#include <cstddef>
+#include <vector>
+
+namespace base_local_planner {
+  /**
+   * @brief  Whether this build counts heap allocations. Counting replaces the global operator new and
+   * delete, so it is only compiled in with the COUNT_ALLOCATIONS CMake option, for debug and profiling builds.
+   */
+  bool allocationsCounted();
+
+  /**
+   * @brief  The heap allocations of the whole process so far, both stay 0 if allocations are not counted
+   * @param count Will be set to the number of allocations
+   * @param bytes Will be set to the number of bytes they requested
+   */
+  void getAllocationCount(uint64_t& count, uint64_t& bytes);
+
+  /**
+   * @brief  The heap memory a vector holds, its reserved capacity included
+   */
+  template <typename T>
+  inline size_t vectorBytes(const std::vector<T>& v) {
+    return v.capacity() * sizeof(T);
+  }
+
+  inline size_t vectorBytes(const std::vector<bool>& v) {
+    return v.capacity() / 8;
+  }
+};
+
+#endif
@@ -59,12 +59,19 @@ public:
   bool prepare();
   double scoreTrajectory(Trajectory &traj);
 
+  bool isStreaming() {return true;};
+  void beginStream(Trajectory &traj);
+  double scorePose(Trajectory &traj, double x, double y, double th);
+  double endStream(Trajectory &traj);
+
   void setSumScores(bool score_sums){ sum_scores_=score_sums; }
 
   void setParams(double max_trans_vel, double max_scaling_factor, double scaling_speed);
   void setFootprint(std::vector<geometry_msgs::Point> footprint_spec);
 
   // helper functions, made static for easy unit testing
+  // getScalingFactor only reads the velocities of traj, but the critic is not velocity-only since the
+  // scaled footprint is checked at every pose. beginStream computes the scale before the first pose is simulated.
   static double getScalingFactor(Trajectory &traj, double scaling_speed, double max_trans_vel, double max_scaling_factor);
   static double footprintCost(
       const double& x,
@@ -83,6 +90,9 @@ private:
   bool sum_scores_;
   //footprint scaling with velocity;
   double max_scaling_factor_, scaling_speed_;
+
+  // state of the trajectory currently being streamed
+  double stream_scale_, stream_cost_;
 };
 
 } /* namespace base_local_planner */
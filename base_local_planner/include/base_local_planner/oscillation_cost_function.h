@@ -52,6 +52,8 @@ public:
 
   bool prepare() {return true;};
 
+  bool isVelocityOnly() {return true;};
+
   /**
    * @brief  Reset the oscillation flags for the local planner
    */
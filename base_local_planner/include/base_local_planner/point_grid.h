@@ -42,6 +42,8 @@
 #include <geometry_msgs/Point.h>
 #include <costmap_2d/observation.h>
 #include <base_local_planner/world_model.h>
+#include <base_local_planner/laser_beam_table.h>
+#include <sensor_msgs/LaserScan.h>
 
 #include <pcl/point_types.h>
 #include <pcl/point_cloud.h>
@@ -105,6 +107,16 @@ namespace base_local_planner {
       void updateWorld(const std::vector<geometry_msgs::Point>& footprint, 
           const std::vector<costmap_2d::Observation>& observations, const std::vector<PlanarLaserScan>& laser_scans);
 
+      /**
+       * @brief  Clears and inserts the points of a planar scan straight from its ranges, without projecting it into a cloud first
+       * @param footprint The footprint of the robot in its current location
+       * @param scan The scan, its ranges are read in the frame of the scanner
+       * @param sensor_origin The position of the scanner in the frame of the grid
+       * @param sensor_yaw The heading of the scanner in the frame of the grid, the scanner is assumed to be level
+       */
+      void updateWorld(const std::vector<geometry_msgs::Point>& footprint, const sensor_msgs::LaserScan& scan,
+          const geometry_msgs::Point& sensor_origin, double sensor_yaw);
+
       /**
        * @brief  Convert from world coordinates to grid coordinates
        * @param  pt A point in world space 
@@ -336,12 +348,28 @@ namespace base_local_planner {
        */
       bool ptInScan(const pcl::PointXYZ& pt, const PlanarLaserScan& laser_scan);
 
+      /**
+       * @brief  Checks to see if a point is closer to the scanner than what the beams around it saw
+       * @param pt The point to check
+       * @param scan The scan the clear ranges were filled from
+       * @param sensor_origin The position of the scanner in the frame of the grid
+       * @param sensor_yaw The heading of the scanner in the frame of the grid
+       * @return True if the point is in free space seen by the scan, false otherwise
+       */
+      bool ptInScan(const pcl::PointXYZ& pt, const sensor_msgs::LaserScan& scan,
+          const geometry_msgs::Point& sensor_origin, double sensor_yaw);
+
       /**
        * @brief  Get the points in the point grid
        * @param  cloud The point cloud to insert the points into
        */
       void getPoints(pcl::PointCloud<pcl::PointXYZ>& cloud);
 
+      /**
+       * @brief  The heap memory of the cells and the points in them
+       */
+      size_t getMemoryUsage();
+
     private:
       double resolution_; ///< @brief The resolution of the grid in meters/cell
       geometry_msgs::Point origin_; ///< @brief The origin point of the grid
@@ -352,6 +380,9 @@ namespace base_local_planner {
       double sq_obstacle_range_;  ///< @brief The square distance at which we no longer add obstacles to the grid
       double sq_min_separation_;  ///< @brief The minimum square distance required between points in the grid
       std::vector< std::list<pcl::PointXYZ>* > points_;  ///< @brief The lists of points returned by a range search, made a member to save on memory allocation
+      LaserBeamTable beams_; ///< @brief The beam directions of the last scanner geometry seen
+      std::vector<double> clear_ranges_; ///< @brief How far each beam of the current scan saw free space, reused between scans
+      std::vector<pcl::PointXYZ> scan_hits_; ///< @brief The hits of the current scan waiting to be inserted, reused between scans
   };
 };
 #endif
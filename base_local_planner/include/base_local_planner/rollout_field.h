@@ -0,0 +1,123 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the Willow Garage nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+#ifndef TRAJECTORY_ROLLOUT_ROLLOUT_FIELD_H_
+#define TRAJECTORY_ROLLOUT_ROLLOUT_FIELD_H_
+
+#include <cstddef>
+#include <vector>
+#include <costmap_2d/costmap_2d.h>
+#include <base_local_planner/map_grid.h>
+
+namespace base_local_planner {
+  /**
+   * @class RolloutCell
+   * @brief Everything a rollout step reads about a cell, packed into 8 bytes so that a step touches a single cache line
+   */
+  struct RolloutCell {
+    unsigned short path_dist; ///< @brief Path distance in MapGrid::DISTANCE_UNITS per cell, RolloutField::IMPOSSIBLE_DIST if the path can not be reached
+    unsigned short goal_dist; ///< @brief Goal distance in MapGrid::DISTANCE_UNITS per cell, RolloutField::IMPOSSIBLE_DIST if the goal can not be reached
+    unsigned char cost; ///< @brief The costmap value of the cell
+    unsigned char flags; ///< @brief Combination of RolloutField::CellFlags
+    unsigned short reserved; ///< @brief Pads the record to 8 bytes, so records never straddle a cache line
+  };
+
+  /**
+   * @class RolloutField
+   * @brief An interleaved copy of the path distance, goal distance and cost grids, built once per planning cycle
+   */
+  class RolloutField {
+    public:
+      enum {
+        MAX_DIST = 0xFFFE, ///< @brief Larger distances are saturated to this value, a little over 4095 cells
+        IMPOSSIBLE_DIST = 0xFFFF ///< @brief Marks obstacle and unreachable cells of the distance grids
+      };
+
+      enum CellFlags {
+        IN_TUBE = 1, ///< @brief The cell is within path_distance_max of the path
+        LETHAL = 2, ///< @brief The cell is a lethal obstacle
+        UNKNOWN = 4 ///< @brief Nothing is known about the cell
+      };
+
+      /**
+       * @brief  Creates an empty field
+       */
+      RolloutField();
+
+      /**
+       * @brief  Rebuild the field from the costmap and the distance grids of this cycle
+       * @param costmap The costmap the distance grids were computed on
+       * @param path_map The grid holding the distances to the path
+       * @param goal_map The grid holding the distances to the local goal
+       * @param path_distance_max The distance to the path within which cells are flagged IN_TUBE, disabled if not positive
+       */
+      void update(const costmap_2d::Costmap2D& costmap, MapGrid& path_map, MapGrid& goal_map, double path_distance_max);
+
+      /**
+       * @brief  The heap memory the field holds, reserved capacity included
+       */
+      size_t getMemoryUsage() const;
+
+      /**
+       * @brief  Scale a path_dist or goal_dist of a record back to cells
+       * @param dist The stored distance
+       * @param impossible_dist The distance to return for IMPOSSIBLE_DIST
+       * @return The distance in cells
+       */
+      static inline double distance(unsigned short dist, double impossible_dist) {
+        return dist == IMPOSSIBLE_DIST ? impossible_dist : double(dist) / MapGrid::DISTANCE_UNITS;
+      }
+
+      /**
+       * @brief  Returns the record of a cell accessed by (col, row)
+       * @param x The x coordinate of the cell
+       * @param y The y coordinate of the cell
+       * @return A reference to the record
+       */
+      inline const RolloutCell& operator() (unsigned int x, unsigned int y) const {
+        return cells_[size_x_ * y + x];
+      }
+
+      unsigned int size_x_, size_y_; ///< @brief The dimensions of the field
+
+    private:
+      /**
+       * @brief  Quantise a distance of a MapGrid to MapGrid::DISTANCE_UNITS per cell
+       */
+      static unsigned short quantise(double dist, double impossible_dist);
+
+      std::vector<RolloutCell> cells_; ///< @brief Storage for the records
+  };
+};
+
+#endif
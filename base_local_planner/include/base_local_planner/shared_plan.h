@@ -0,0 +1,94 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the Willow Garage nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+#ifndef BASE_LOCAL_PLANNER_SHARED_PLAN_H_
+#define BASE_LOCAL_PLANNER_SHARED_PLAN_H_
+
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include <geometry_msgs/PoseStamped.h>
+
+namespace base_local_planner {
+  /**
+   * @class SharedPlan
+   * @brief A view on a global plan that is stored once and never modified. Copies of the view
+   * share the poses, and pruning the plan moves the start of the view instead of erasing poses.
+   */
+  class SharedPlan {
+    public:
+      typedef std::vector<geometry_msgs::PoseStamped>::const_iterator const_iterator;
+
+      /**
+       * @brief  An empty plan
+       */
+      SharedPlan() : begin_(0) {}
+
+      /**
+       * @brief  Copies the poses into a new buffer, the only copy made of them
+       * @param poses The poses of the plan
+       */
+      explicit SharedPlan(const std::vector<geometry_msgs::PoseStamped>& poses)
+        : poses_(new std::vector<geometry_msgs::PoseStamped>(poses)), begin_(0) {}
+
+      unsigned int size() const { return poses_ ? poses_->size() - begin_ : 0; }
+
+      bool empty() const { return size() == 0; }
+
+      const geometry_msgs::PoseStamped& operator[](unsigned int i) const { return (*poses_)[begin_ + i]; }
+
+      const geometry_msgs::PoseStamped& front() const { return (*poses_)[begin_]; }
+
+      const geometry_msgs::PoseStamped& back() const { return poses_->back(); }
+
+      const_iterator begin() const { return poses_->begin() + begin_; }
+
+      const_iterator end() const { return poses_->end(); }
+
+      /**
+       * @brief  Drop poses from the start of the view, the buffer is left untouched
+       * @param n The number of poses to drop, at most size()
+       */
+      void advance(unsigned int n) { begin_ += n; }
+
+      /**
+       * @brief  Release the buffer, other views keep it alive
+       */
+      void clear() { poses_.reset(); begin_ = 0; }
+
+    private:
+      boost::shared_ptr<const std::vector<geometry_msgs::PoseStamped> > poses_;
+      unsigned int begin_; ///< @brief Index in the buffer of the first pose of the view
+  };
+};
+
+#endif
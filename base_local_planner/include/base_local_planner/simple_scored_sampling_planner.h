@@ -39,7 +39,10 @@
 #define SIMPLE_SCORED_SAMPLING_PLANNER_H_
 
 #include <vector>
+#include <boost/shared_ptr.hpp>
 #include <base_local_planner/trajectory.h>
+#include <base_local_planner/trajectory_pool.h>
+#include <base_local_planner/task_scheduler.h>
 #include <base_local_planner/trajectory_cost_function.h>
 #include <base_local_planner/trajectory_sample_generator.h>
 #include <base_local_planner/trajectory_search.h>
@@ -60,7 +63,7 @@ public:
 
   ~SimpleScoredSamplingPlanner() {}
 
-  SimpleScoredSamplingPlanner() {}
+  SimpleScoredSamplingPlanner() : trajectory_pool_(new TrajectoryPool()) {}
 
   /**
    * Takes a list of generators and critics. Critics return costs > 0, or negative costs for invalid trajectories.
@@ -80,6 +83,12 @@ public:
    */
   double scoreTrajectory(Trajectory& traj, double best_traj_cost);
 
+  /**
+   * runs only the critics that declare themselves velocity-only, so this
+   * can be called before the trajectory has been simulated
+   */
+  double scoreVelocities(Trajectory& traj, double best_traj_cost);
+
   /**
    * Calls generator until generator has no more samples or max_samples is reached.
    * For each generated traj, calls critics in turn. If any critic returns negative
@@ -87,16 +96,65 @@ public:
    * result. Returns true and sets the traj parameter to the first trajectory with
    * minimal non-negative costs if sampling yields trajectories with non-negative costs,
    * else returns false.
+   * Velocity-only critics are run on the raw sample first, if the generator
+   * can tell the velocities in advance, so that samples they reject are not simulated.
+   * Streaming critics then score the poses while they are simulated, and the first
+   * negative cost stops the simulation of that sample.
    *
    * @param traj The container to write the result to
    * @param all_explored pass NULL or a container to collect all trajectories for debugging (has a penalty)
    */
   bool findBestTrajectory(Trajectory& traj, std::vector<Trajectory>* all_explored = 0);
 
+  /**
+   * Run the preparation of the critics on the control lane of a scheduler, side by side.
+   * Only set one if the critics prepare independently of each other. Planners owning this one
+   * hand it their scheduler, so its work shares their threads.
+   * @param scheduler The scheduler, NULL to prepare the critics one after another
+   */
+  void setScheduler(const boost::shared_ptr<TaskScheduler>& scheduler) { scheduler_ = scheduler; }
+
 
 private:
+  /**
+   * @class PoseStreamScorer
+   * @brief Feeds the poses of a trajectory to the streaming critics while it is simulated
+   */
+  class PoseStreamScorer : public TrajectoryPoseObserver {
+  public:
+    PoseStreamScorer() : stopped(false), stop_cost(0.0) {}
+
+    void startTrajectory(Trajectory &traj);
+
+    bool poseAdded(Trajectory &traj, unsigned int index);
+
+    std::vector<TrajectoryCostFunction*> critics; ///< @brief the streaming critics
+    bool stopped; ///< @brief whether a critic rejected a pose of the current trajectory
+    double stop_cost; ///< @brief the negative cost of the rejected pose
+  };
+
+  /**
+   * accumulates weighted costs of the given critics onto traj_cost, with the
+   * same abort rules as scoreTrajectory
+   * @param streamed if true, streaming critics have seen all poses already and only report their result
+   */
+  double scoreWithCritics(std::vector<TrajectoryCostFunction*>& critics,
+      Trajectory& traj, double traj_cost, double best_traj_cost, bool streamed = false);
+
+  /**
+   * whether a partial cost means the trajectory cannot become the best one anymore
+   */
+  bool isHopeless(double traj_cost, double best_traj_cost) {
+    return traj_cost < 0 || (best_traj_cost > 0 && traj_cost > best_traj_cost);
+  }
+
   std::vector<TrajectorySampleGenerator*> gen_list_;
   std::vector<TrajectoryCostFunction*> critics_;
+  std::vector<TrajectoryCostFunction*> velocity_critics_; ///< @brief subset of critics_ that only look at velocities
+  std::vector<TrajectoryCostFunction*> pose_critics_; ///< @brief remaining critics, which need the simulated poses
+  PoseStreamScorer pose_stream_;
+  boost::shared_ptr<TrajectoryPool> trajectory_pool_; ///< @brief buffers for the search, shared by copies of this planner
+  boost::shared_ptr<TaskScheduler> scheduler_; ///< @brief runs the preparation of the critics, NULL to run it inline
 
   int max_samples_;
 };
@@ -125,6 +125,26 @@ public:
    */
   bool nextTrajectory(Trajectory &traj);
 
+  /**
+   * Create the next trajectory, stopping the simulation as soon as observer rejects a pose
+   */
+  bool nextTrajectory(Trajectory &traj, TrajectoryPoseObserver &observer);
+
+  /**
+   * Sets the velocities of the next sample as generateTrajectory would, without simulating
+   */
+  bool peekNextVelocities(Trajectory &traj);
+
+  /**
+   * Drops the next sample without simulating it
+   */
+  void skipTrajectory();
+
+  /**
+   * The largest number of steps of the samples of this cycle
+   */
+  unsigned int getMaxNumPoints();
+
 
   static Eigen::Vector3f computeNewPositions(const Eigen::Vector3f& pos,
       const Eigen::Vector3f& vel, double dt);
@@ -132,14 +152,30 @@ public:
   static Eigen::Vector3f computeNewVelocities(const Eigen::Vector3f& sample_target_vel,
       const Eigen::Vector3f& vel, Eigen::Vector3f acclimits, double dt);
 
+  /**
+   * @param observer if not NULL, receives every pose right after it is added, and may stop the simulation
+   * @return true if the trajectory has at least one point and was not stopped by the observer
+   */
   bool generateTrajectory(
         Eigen::Vector3f pos,
         Eigen::Vector3f vel,
         Eigen::Vector3f sample_target_vel,
-        base_local_planner::Trajectory& traj);
+        base_local_planner::Trajectory& traj,
+        TrajectoryPoseObserver* observer = NULL);
 
 protected:
 
+  /**
+   * number of simulation steps for the given sample
+   */
+  int computeNumSteps(const Eigen::Vector3f& sample_target_vel);
+
+  /**
+   * velocity reached after the first step of dt, which is the one stored in the trajectory
+   */
+  Eigen::Vector3f computeFirstVelocities(const Eigen::Vector3f& sample_target_vel,
+      const Eigen::Vector3f& vel, double dt);
+
   unsigned int next_sample_index_;
   // to store sample params of each sample between init and generation
   std::vector<Eigen::Vector3f> sample_params_;
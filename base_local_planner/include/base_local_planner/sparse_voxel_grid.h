@@ -0,0 +1,200 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the Willow Garage nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef TRAJECTORY_ROLLOUT_SPARSE_VOXEL_GRID_H_
+#define TRAJECTORY_ROLLOUT_SPARSE_VOXEL_GRID_H_
+
+#include <cstddef>
+#include <algorithm>
+#include <vector>
+#include <stdint.h>
+#include <boost/unordered_map.hpp>
+
+namespace base_local_planner {
+  /**
+   * @brief The cell coordinates of a voxel
+   */
+  struct VoxelCell {
+    unsigned int x, y, z;
+  };
+
+  /**
+   * @class SparseVoxelGrid
+   * @brief A voxel grid that only stores the 8x8x8 bricks of voxels holding marked voxels,
+   * one bit per voxel. Besides a summary word per column its memory grows with the marked volume
+   * instead of the volume of the grid, and its height is not bounded by the width of a column word.
+   */
+  class SparseVoxelGrid {
+    public:
+      /**
+       * @brief  Creates a grid without marked voxels
+       * @param size_x The x size of the grid in cells
+       * @param size_y The y size of the grid in cells
+       * @param size_z The z size of the grid in cells
+       */
+      SparseVoxelGrid(unsigned int size_x, unsigned int size_y, unsigned int size_z);
+
+      /**
+       * @brief  Mark a voxel, voxels outside the grid are ignored
+       */
+      void markVoxel(unsigned int x, unsigned int y, unsigned int z);
+
+      /**
+       * @brief  Clear a voxel, releasing its brick once nothing in it is marked
+       */
+      void clearVoxel(unsigned int x, unsigned int y, unsigned int z);
+
+      /**
+       * @brief  Whether a voxel is marked, voxels outside the grid are not
+       */
+      bool getVoxel(unsigned int x, unsigned int y, unsigned int z) const;
+
+      /**
+       * @brief  Whether any voxel of a column is marked within a range of heights. The layers of the
+       * column are looked up in a per-column summary first, so only a column with marked voxels in
+       * a partly covered layer needs its brick.
+       * @param x The x coordinate of the column
+       * @param y The y coordinate of the column
+       * @param min_z The lowest voxel of the range
+       * @param max_z The highest voxel of the range, clipped to the grid
+       * @return True if a voxel in the range is marked, or the column is outside the grid
+       */
+      bool columnOccupied(unsigned int x, unsigned int y, unsigned int min_z, unsigned int max_z) const;
+
+      /**
+       * @brief  Clear every voxel a ray passes through, both ends included. The ray steps from voxel
+       * to voxel and only looks up the brick when it enters another one, so it crosses free space cheaply.
+       * @param x0 The x coordinate of the start of the ray, in cells
+       * @param y0 The y coordinate of the start of the ray, in cells
+       * @param z0 The z coordinate of the start of the ray, in cells
+       * @param x1 The x coordinate of the end of the ray, in cells
+       * @param y1 The y coordinate of the end of the ray, in cells
+       * @param z1 The z coordinate of the end of the ray, in cells
+       */
+      void clearVoxelLine(double x0, double y0, double z0, double x1, double y1, double z1);
+
+      /**
+       * @brief  Collect every marked voxel, visiting only the stored bricks
+       * @param cells Will be set to the marked voxels
+       */
+      void getMarkedVoxels(std::vector<VoxelCell>& cells) const;
+
+      /**
+       * @brief  Clear all voxels and release all bricks
+       */
+      void reset();
+
+      /**
+       * @brief  Move the marked voxels along with the area the grid covers, voxels that leave the grid are dropped
+       * @param dx The cells the grid moves along x, a voxel at x ends up at x - dx
+       * @param dy The cells the grid moves along y, a voxel at y ends up at y - dy
+       */
+      void shift(int dx, int dy);
+
+      unsigned int sizeX() const { return size_x_; }
+      unsigned int sizeY() const { return size_y_; }
+      unsigned int sizeZ() const { return size_z_; }
+
+      /**
+       * @brief  The number of bricks holding marked voxels
+       */
+      unsigned int numBricks() const { return index_.size(); }
+
+      /**
+       * @brief  The heap memory of the bricks, of their index and of the column summaries, an estimate for the index
+       */
+      size_t getMemoryUsage() const;
+
+    private:
+      static const unsigned int BRICK_SHIFT = 3;
+      static const unsigned int BRICK_MASK = (1 << BRICK_SHIFT) - 1;
+      static const unsigned int NO_BRICK = 0xffffffff;
+
+      /**
+       * @brief  8x8x8 voxels, word y holds the columns of row y of the brick and byte x of it the heights of a column
+       */
+      struct Brick {
+        uint64_t rows[1 << BRICK_SHIFT];
+      };
+
+      static uint64_t brickKey(unsigned int bx, unsigned int by, unsigned int bz) {
+        return ((uint64_t) bz << 42) | ((uint64_t) by << 21) | (uint64_t) bx;
+      }
+
+      static const unsigned int TOP_LAYER = 31;
+
+      /**
+       * @brief  The bit of a layer of bricks in the summary of a column, the top bit stands for every layer above
+       */
+      static uint32_t layerBit(unsigned int bz) {
+        return (uint32_t) 1 << std::min(bz, TOP_LAYER);
+      }
+
+      /**
+       * @brief  The marked heights of a column within a brick, one bit per voxel
+       */
+      static unsigned int columnHeights(const Brick& brick, unsigned int x, unsigned int y) {
+        return (unsigned int) (brick.rows[y & BRICK_MASK] >> ((x & BRICK_MASK) << BRICK_SHIFT)) & 0xff;
+      }
+
+      static uint64_t voxelBit(unsigned int x, unsigned int z) {
+        return (uint64_t) 1 << (((x & BRICK_MASK) << BRICK_SHIFT) | (z & BRICK_MASK));
+      }
+
+      /**
+       * @brief  The index of a brick in bricks_, NO_BRICK if it is not stored
+       */
+      unsigned int findBrick(uint64_t key) const;
+
+      /**
+       * @brief  Release a brick that has no marked voxels left
+       */
+      void releaseBrick(uint64_t key, unsigned int index);
+
+      /**
+       * @brief  Drop the layer of a cleared voxel from the summary of its column once nothing of the column is marked in it
+       */
+      void updateColumnLayers(const Brick& brick, unsigned int x, unsigned int y, unsigned int z);
+
+      static bool isEmpty(const Brick& brick);
+
+      unsigned int size_x_, size_y_, size_z_; ///< @brief The size of the grid in cells
+      std::vector<Brick> bricks_; ///< @brief Storage of the bricks, released ones included
+      std::vector<unsigned int> free_bricks_; ///< @brief Released bricks in bricks_, reused before it grows
+      boost::unordered_map<uint64_t, unsigned int> index_; ///< @brief The index in bricks_ of each stored brick
+      std::vector<uint32_t> column_layers_; ///< @brief Per column the layerBit of each layer holding a marked voxel of it, the top bit may be stale
+  };
+};
+
+#endif
@@ -0,0 +1,195 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the Willow Garage nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+#ifndef BASE_LOCAL_PLANNER_TASK_SCHEDULER_H_
+#define BASE_LOCAL_PLANNER_TASK_SCHEDULER_H_
+
+#include <stdint.h>
+#include <deque>
+#include <vector>
+#include <boost/thread.hpp>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/noncopyable.hpp>
+#include <ros/time.h>
+
+namespace base_local_planner {
+  class TaskGroup;
+
+  /**
+   * @class TaskScheduler
+   * @brief The worker threads all parallel work of the planner runs on. Every worker keeps a queue per lane and
+   * steals from the others when its own are empty. Queued control work always starts before background work,
+   * a running background task is not interrupted though.
+   */
+  class TaskScheduler : private boost::noncopyable {
+    public:
+      enum Lane {
+        CONTROL = 0, ///< @brief Work the velocity command waits for, like distance fields and rollouts
+        BACKGROUND = 1, ///< @brief Work nobody waits for, like visualization
+        NUM_LANES = 2
+      };
+
+      /**
+       * @brief The work done in a lane since the scheduler started
+       */
+      struct LaneStats {
+        LaneStats() : tasks(0), cancelled(0), busy_time(0.0), wait_time(0.0) {}
+
+        uint64_t tasks; ///< @brief Tasks run
+        uint64_t cancelled; ///< @brief Tasks dropped before they started
+        double busy_time; ///< @brief Seconds spent running tasks, summed over threads
+        double wait_time; ///< @brief Seconds tasks were queued before they started, summed over tasks
+      };
+
+      /**
+       * @brief  Start the workers
+       * @param num_threads The number of worker threads, 0 runs every task in the thread that hands it over
+       * @param core_mask The cores the workers may run on, bit i for core i, 0 for any core
+       */
+      TaskScheduler(unsigned int num_threads = 0, uint64_t core_mask = 0);
+
+      /**
+       * @brief  Stop the workers once the queued tasks are done
+       */
+      ~TaskScheduler();
+
+      unsigned int getNumThreads() const { return workers_.size(); }
+
+      uint64_t getCoreMask() const { return core_mask_; }
+
+      /**
+       * @brief  The work done in a lane since the scheduler started
+       */
+      LaneStats getLaneStats(Lane lane);
+
+    private:
+      friend class TaskGroup;
+
+      struct GroupState {
+        GroupState() : pending(0), cancelled(false) {}
+
+        boost::mutex mutex;
+        boost::condition_variable done;
+        unsigned int pending; ///< @brief Tasks handed over and not finished or dropped yet
+        bool cancelled; ///< @brief Tasks that did not start yet are dropped
+      };
+
+      struct Task {
+        boost::function<void ()> function;
+        boost::shared_ptr<GroupState> group;
+        ros::WallTime queued;
+      };
+
+      struct Worker {
+        boost::mutex mutex;
+        std::deque<Task> lanes[NUM_LANES]; ///< @brief The owner takes from the front, thieves from the back
+      };
+
+      /**
+       * @brief  Queue a task, or run it right away without workers
+       */
+      void submit(Lane lane, const Task& task);
+
+      /**
+       * @brief  Take a task of a lane, from the queues of a worker first and then from the others
+       * @param lane The lane to take from
+       * @param first The worker whose queue is tried first
+       * @param task Will be set to the task
+       * @return False if all queues of the lane are empty
+       */
+      bool take(Lane lane, unsigned int first, Task& task);
+
+      /**
+       * @brief  Run a task or drop it if its group was cancelled, and account for it
+       */
+      void execute(Lane lane, Task& task);
+
+      void workerLoop(unsigned int index);
+
+      std::vector<Worker*> workers_;
+      boost::thread_group threads_;
+      uint64_t core_mask_;
+
+      boost::mutex wake_mutex_; ///< @brief Guards queued_ and stop_
+      boost::condition_variable wake_; ///< @brief Signalled when a task is queued or the workers should stop
+      unsigned int queued_; ///< @brief Tasks in all queues
+      bool stop_;
+      unsigned int next_worker_; ///< @brief The worker the next task is queued at, round robin
+
+      boost::mutex stats_mutex_;
+      LaneStats stats_[NUM_LANES];
+  };
+
+  /**
+   * @class TaskGroup
+   * @brief Tasks of one lane that are waited for together. A thread waiting for control tasks runs queued
+   * control tasks itself, so it is never idle while its tasks are stuck behind running background work.
+   */
+  class TaskGroup : private boost::noncopyable {
+    public:
+      /**
+       * @brief  Create an empty group
+       * @param scheduler The scheduler to run the tasks on, NULL runs them in the thread that hands them over
+       * @param lane The lane of all tasks of the group
+       */
+      TaskGroup(TaskScheduler* scheduler, TaskScheduler::Lane lane);
+
+      /**
+       * @brief  Waits for the tasks
+       */
+      ~TaskGroup();
+
+      /**
+       * @brief  Hand a task over, it may run at once in this thread
+       */
+      void run(const boost::function<void ()>& function);
+
+      /**
+       * @brief  Wait until all tasks handed over so far finished or were dropped
+       */
+      void wait();
+
+      /**
+       * @brief  Drop the tasks that did not start yet and wait for the others, the group can be used again afterwards
+       */
+      void cancel();
+
+    private:
+      TaskScheduler* scheduler_;
+      TaskScheduler::Lane lane_;
+      boost::shared_ptr<TaskScheduler::GroupState> state_;
+  };
+};
+
+#endif
@@ -34,6 +34,7 @@
 #ifndef TRAJECTORY_ROLLOUT_TRAJECTORY_H_
 #define TRAJECTORY_ROLLOUT_TRAJECTORY_H_
 
+#include <cstddef>
 #include <vector>
 
 namespace base_local_planner {
@@ -106,12 +107,29 @@ namespace base_local_planner {
        */
       void resetPoints();
 
+      /**
+       * @brief  Make room for a number of points, so that adding up to that many does not allocate
+       * @param num_pts The number of points
+       */
+      void reservePoints(unsigned int num_pts);
+
+      /**
+       * @brief  Exchange the contents of two trajectories without copying their points
+       * @param other The trajectory to exchange contents with
+       */
+      void swap(Trajectory& other);
+
       /**
        * @brief  Return the number of points in the trajectory
        * @return The number of points in the trajectory
        */
       unsigned int getPointsSize() const;
 
+      /**
+       * @brief  The heap memory the points hold, reserved capacity included
+       */
+      size_t getMemoryUsage() const;
+
     private:
       std::vector<double> x_pts_; ///< @brief The x points in the trajectory
       std::vector<double> y_pts_; ///< @brief The y points in the trajectory
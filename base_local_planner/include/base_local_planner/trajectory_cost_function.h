@@ -64,6 +64,45 @@ public:
    */
   virtual double scoreTrajectory(Trajectory &traj) = 0;
 
+  /**
+   * Whether the score only depends on the sampled velocities (xv_, yv_, thetav_)
+   * and not on the simulated poses. Such critics can be run on a sample before
+   * the generator integrates it, so samples they reject are never simulated.
+   * Subclasses may overwrite, the default is pose-dependent.
+   */
+  virtual bool isVelocityOnly() {
+    return false;
+  }
+
+  /**
+   * Whether the critic can score the poses one at a time while the trajectory
+   * is being simulated, using beginStream, scorePose and endStream. A negative
+   * cost from scorePose stops the simulation of that trajectory.
+   * Subclasses may overwrite, the default is to score complete trajectories only.
+   */
+  virtual bool isStreaming() {
+    return false;
+  }
+
+  /**
+   * called once the velocities of traj are set, before any pose is streamed
+   */
+  virtual void beginStream(Trajectory &traj) {}
+
+  /**
+   * return a score for the pose that was just added to traj, negative to reject traj
+   */
+  virtual double scorePose(Trajectory &traj, double x, double y, double th) {
+    return 0.0;
+  }
+
+  /**
+   * return the score for traj once all of its poses were streamed
+   */
+  virtual double endStream(Trajectory &traj) {
+    return scoreTrajectory(traj);
+  }
+
   double getScale() {
     return scale_;
   }
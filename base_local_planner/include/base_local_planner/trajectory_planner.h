@@ -38,15 +38,21 @@
 #define TRAJECTORY_ROLLOUT_TRAJECTORY_PLANNER_H_
 
 #include <vector>
+#include <map>
+#include <string>
+#include <stdint.h>
 #include <cmath>
 
 //for obstacle data access
 #include <costmap_2d/costmap_2d.h>
 #include <costmap_2d/cost_values.h>
 #include <base_local_planner/footprint_helper.h>
+#include <base_local_planner/footprint_set.h>
 
 #include <base_local_planner/world_model.h>
 #include <base_local_planner/trajectory.h>
+#include <base_local_planner/trajectory_pool.h>
+#include <base_local_planner/task_scheduler.h>
 #include <base_local_planner/Position2DInt.h>
 #include <base_local_planner/BaseLocalPlannerConfig.h>
 
@@ -60,6 +66,9 @@
 //for creating a local cost grid
 #include <base_local_planner/map_cell.h>
 #include <base_local_planner/map_grid.h>
+#include <base_local_planner/cost_bounds_grid.h>
+#include <base_local_planner/costmap_mirror.h>
+#include <base_local_planner/rollout_field.h>
 
 namespace base_local_planner {
   /**
@@ -69,6 +78,39 @@ namespace base_local_planner {
   class TrajectoryPlanner{
     friend class TrajectoryPlannerTest; //Need this for gtest to work
     public:
+      /**
+       * @brief  The phases of the velocity search, in the order they run
+       */
+      enum SearchPhase {
+        FORWARD_PHASE,        ///< every x velocity with every rotational velocity
+        STRAFE_PHASE,         ///< every y velocity alone, holonomic robots only
+        STRAFE_FORWARD_PHASE, ///< half the x velocities with every y velocity, holonomic robots only
+        ROTATE_PHASE,         ///< rotations in place
+        NUM_SEARCH_PHASES
+      };
+
+      /**
+       * @brief  How much a search phase may sample, and when its best trajectory is good enough to skip the later phases
+       */
+      struct SearchPhaseGate {
+        SearchPhaseGate() : max_samples(0), max_cost(-1.0), tube_margin(0.0), min_progress(0.0) {}
+        unsigned int max_samples; ///< @brief Rollouts the phase may score, 0 for all of its samples
+        double max_cost; ///< @brief The best trajectory so far is accepted at this cost or below, negative never accepts it
+        double tube_margin; ///< @brief ...and with its path distance this far within path_distance_max, if that is set
+        double min_progress; ///< @brief ...and if its endpoint is closer to the goal in a straight line, by this fraction of max_vel_x * sim_time
+      };
+
+      /**
+       * @brief  What the search phases did since the planner was created
+       */
+      struct SearchPhaseStats {
+        SearchPhaseStats() : runs(0), accepted(0), skipped(0), rollouts(0) {}
+        uint64_t runs; ///< @brief Searches the phase ran in
+        uint64_t accepted; ///< @brief Runs after which the best trajectory passed the gate of the phase
+        uint64_t skipped; ///< @brief Searches the phase was skipped in, because an earlier one was accepted
+        uint64_t rollouts; ///< @brief Trajectories the phase scored
+      };
+
       /**
        * @brief  Constructs a trajectory controller
        * @param world_model The WorldModel the trajectory controller uses to check for collisions 
@@ -147,6 +189,27 @@ namespace base_local_planner {
       Trajectory findBestPath(tf::Stamped<tf::Pose> global_pose, tf::Stamped<tf::Pose> global_vel,
           tf::Stamped<tf::Pose>& drive_velocities);
 
+      /**
+       * @brief  Replace the command findBestPath recorded with the one that was actually sent to the base
+       * @param vx The x velocity sent
+       * @param vy The y velocity sent
+       * @param vtheta The rotational velocity sent
+       */
+      void recordCommand(double vx, double vy, double vtheta);
+
+      /**
+       * @brief  Given the current position, orientation, and velocity of the robot, find the best trajectory along each of several global plans.
+       * The trajectories are simulated and checked for collisions once, then scored against the path and goal distances of every plan
+       * @param global_pose The current pose of the robot in world space
+       * @param global_vel The current velocity of the robot in world space
+       * @param plans The candidate global plans, the first one becomes the plan the controller is following
+       * @param best_trajs Will be set to the best trajectory for each plan, with a negative cost if none is legal.
+       * Heading scoring only scores the followed plan, so with it on the other plans get no trajectory
+       * @return The index of the plan whose best trajectory has the lowest cost, -1 if no plan has a legal trajectory
+       */
+      int findBestCorridorPaths(tf::Stamped<tf::Pose> global_pose, tf::Stamped<tf::Pose> global_vel,
+          const std::vector<std::vector<geometry_msgs::PoseStamped> >& plans, std::vector<Trajectory>& best_trajs);
+
       /**
        * @brief  Update the plan that the controller is following
        * @param new_plan A new plan for the controller to follow 
@@ -154,6 +217,16 @@ namespace base_local_planner {
        */
       void updatePlan(const std::vector<geometry_msgs::PoseStamped>& new_plan, bool compute_dists = false);
 
+      /**
+       * @brief  Update the plan that the controller is following without copying it
+       * @param new_plan A new plan for the controller to follow, swapped with the previous plan so its buffer can be filled again
+       * @param compute_dists Wheter or not to compute path/goal distances when a plan is updated
+       */
+      void swapPlan(std::vector<geometry_msgs::PoseStamped>& new_plan, bool compute_dists = false);
+
+      /** @brief Return the plan that the controller is following. */
+      const std::vector<geometry_msgs::PoseStamped>& getPlan() const { return global_plan_; }
+
       /**
        * @brief  Accessor for the goal the robot is currently pursuing in world corrdinates
        * @param x Will be set to the x position of the local goal 
@@ -205,14 +278,158 @@ namespace base_local_planner {
        */
       bool getCellCosts(int cx, int cy, float &path_cost, float &goal_cost, float &occ_cost, float &total_cost);
 
-      /** @brief Set the footprint specification of the robot. */
-      void setFootprint( std::vector<geometry_msgs::Point> footprint ) { footprint_spec_ = footprint; }
+      /** @brief Set the footprint specification of the robot, it is used from the start of the next cycle. */
+      void setFootprint( std::vector<geometry_msgs::Point> footprint );
+
+      /**
+       * @brief  Register a footprint to switch to later, computing everything derived from it now, on the calling thread
+       * @param id The id to select the footprint by, a footprint registered before under the same id is replaced
+       * @param footprint The footprint specification
+       */
+      void registerFootprint(int id, const std::vector<geometry_msgs::Point>& footprint);
+
+      /**
+       * @brief  Switch to a registered footprint from the start of the next cycle
+       * @param id The id the footprint was registered with
+       * @return False if no footprint is registered with this id
+       */
+      bool selectFootprint(int id);
 
       /** @brief Return the footprint specification of the robot. */
-      geometry_msgs::Polygon getFootprintPolygon() const { return costmap_2d::toPolygon(footprint_spec_); }
-      std::vector<geometry_msgs::Point> getFootprint() const { return footprint_spec_; }
+      geometry_msgs::Polygon getFootprintPolygon() const { return costmap_2d::toPolygon(footprint_->getFootprint()); }
+      std::vector<geometry_msgs::Point> getFootprint() const { return footprint_->getFootprint(); }
+
+      /** @brief Return the distances to the global plan, as of the last plan update or search. */
+      const MapGrid& getPathMap() const { return path_map_; }
+
+      /** @brief Return the distances to the local goal, as of the last plan update or search. */
+      const MapGrid& getGoalMap() const { return goal_map_; }
+
+      /**
+       * @brief  The heap memory of the large structures of the planner, call it between cycles
+       * @param names Will be set to the names of the structures
+       * @param bytes Will be set to the memory each of them holds, reserved capacity included
+       */
+      void getMemoryUsage(std::vector<std::string>& names, std::vector<uint64_t>& bytes);
+
+      /**
+       * @brief  The scheduler all parallel work of the planner runs on, replaced when its configuration changes
+       */
+      boost::shared_ptr<TaskScheduler> getScheduler();
+
+      /**
+       * @brief  Drive the structures derived from the costmap by the changes of a mirror, instead of recomputing them every cycle
+       * @param mirror The mirror whose costmap the planner was constructed on, NULL to recompute everything every cycle again
+       */
+      void setCostmapMirror(CostmapMirror* mirror);
+
+      /** @brief Return the most trajectory buffers in use at once since the last call. */
+      unsigned int takePeakTrajectoryBuffers() { return trajectory_pool_.takePeakInUse(); }
+
+      /** @brief Return the number of trajectory buffers kept between cycles. */
+      unsigned int getTrajectoryBuffers() { return trajectory_pool_.getSize(); }
+
+      /**
+       * @brief  Set the sample budget and the acceptance gate of a search phase, the gate of the last phase is never used
+       */
+      void setSearchPhaseGate(SearchPhase phase, const SearchPhaseGate& gate);
+
+      /** @brief Return what a search phase did so far, read it from the thread that plans. */
+      const SearchPhaseStats& getSearchPhaseStats(SearchPhase phase) const { return search_phase_stats_[phase]; }
 
     private:
+      /**
+       * @brief  An alternative global plan, scored against the trajectories rolled out for the followed one
+       */
+      struct Corridor {
+        std::vector<geometry_msgs::PoseStamped> plan; ///< @brief The global plan of the corridor
+        MapGrid path_map; ///< @brief Distances to the plan
+        MapGrid goal_map; ///< @brief Distances to the local goal of the plan
+        Trajectory best; ///< @brief The lowest cost trajectory for the plan so far
+        double reference_goal_cost; ///< @brief The goal cost of the robot staying where it is, negative if there is none
+      };
+
+      /**
+       * @brief  Score a trajectory against the path and goal distances of an alternative plan
+       * @param corridor The alternative plan
+       * @param traj The trajectory
+       * @param occ_cost The maximum cell cost along the trajectory
+       * @param impossible_cost The cost value of a cell in the local map grid that is considered impassable
+       * @param cost Will be set to the cost of the trajectory
+       * @param path_dist Will be set to the path distance of the trajectory, before path_distance_max applies
+       * @param goal_cost Will be set to the goal cost of the trajectory
+       * @return False if a point of the trajectory has no clear path to the goal of the plan
+       */
+      bool corridorCost(const Corridor& corridor, const Trajectory& traj, double occ_cost, double impossible_cost,
+          double& cost, double& path_dist, double& goal_cost);
+
+      /**
+       * @brief  Set the goal cost each alternative plan requires a trajectory to undercut, like the followed plan does
+       * @param current_pos_traj The trajectory of the robot staying where it is
+       * @param impossible_cost The cost value of a cell in the local map grid that is considered impassable
+       */
+      void setCorridorReferences(const Trajectory& current_pos_traj, double impossible_cost);
+
+      /**
+       * @brief  Score a sampled trajectory that passed the collision checks against every alternative plan, and keep it
+       * for those it makes progress on and is best for
+       * @param traj The trajectory
+       * @param occ_cost The maximum cell cost along the trajectory
+       * @param impossible_cost The cost value of a cell in the local map grid that is considered impassable
+       */
+      void scoreCorridors(const Trajectory& traj, double occ_cost, double impossible_cost);
+
+      /**
+       * @brief  Checksum of the costs in a window of the costmap and of the plan, to tell whether anything a failed search depended on changed
+       * @param x0 The lowest x coordinate of the window
+       * @param y0 The lowest y coordinate of the window
+       * @param x1 The highest x coordinate of the window, clipped to the map
+       * @param y1 The highest y coordinate of the window, clipped to the map
+       * @return The checksum
+       */
+      unsigned int blockedStateHash(unsigned int x0, unsigned int y0, unsigned int x1, unsigned int y1);
+
+      /**
+       * @brief  Forward-predict the state of the robot under the last command, within the acceleration limits
+       * @param pos The pose of the robot, replaced by the predicted pose
+       * @param vel The velocity of the robot, replaced by the predicted velocity
+       * @param horizon How far ahead to predict, in seconds
+       */
+      void predictStartState(Eigen::Vector3f& pos, Eigen::Vector3f& vel, double horizon);
+
+      /**
+       * @brief  Remember the command of this cycle and how long it took to compute it
+       * @param cycle_start When the cycle started
+       * @param drive_velocities The command of this cycle
+       */
+      void recordCycle(const ros::WallTime& cycle_start, const tf::Stamped<tf::Pose>& drive_velocities);
+
+      /**
+       * @brief  Switch to the pending footprint, if there is one, called at the start of a cycle
+       */
+      void switchFootprint();
+
+      /**
+       * @brief  Build the current and the registered footprints again for another number of heading bins, without holding configuration_mutex_
+       * @param heading_bins The number of heading ranges to build outline tables for, nothing is rebuilt if it did not change
+       */
+      void rebuildFootprints(unsigned int heading_bins);
+
+      /**
+       * @brief  Build a footprint set for the current heading bins, releasing footprint_mutex_ while it is built
+       * @param footprint The footprint specification
+       * @param lock A held lock of footprint_mutex_, held again on return
+       * @return The set, built for the heading bins in use on return
+       */
+      boost::shared_ptr<const FootprintSet> buildFootprintSet(const std::vector<geometry_msgs::Point>& footprint,
+          boost::mutex::scoped_lock& lock);
+
+      /**
+       * @brief  Refresh the final goal, and the path/goal distances if asked to, after the plan changed
+       * @param compute_dists Wheter or not to compute path/goal distances
+       */
+      void planUpdated(bool compute_dists);
+
       /**
        * @brief  Create the trajectories we wish to explore, score them, and return the best option
        * @param x The x position of the robot  
@@ -245,10 +462,53 @@ namespace base_local_planner {
        * @param acc_theta The theta acceleration limit of the robot
        * @param impossible_cost The cost value of a cell in the local map grid that is considered impassable
        * @param traj Will be set to the generated trajectory with its associated score 
+       * @param sampled True for the velocity samples of the search, which are also scored against the alternative plans
        */
       void generateTrajectory(double x, double y, double theta, double vx, double vy, 
           double vtheta, double vx_samp, double vy_samp, double vtheta_samp, double acc_x, double acc_y,
-          double acc_theta, double impossible_cost, Trajectory& traj);
+          double acc_theta, double impossible_cost, Trajectory& traj, bool sampled = false);
+
+      /**
+       * @brief  Generate and score a single trajectory, unless its endpoint shows that it cannot make progress
+       * towards the goal compared to a reference trajectory. In that case no rollout is done and the cost of traj is set to -6
+       * @param x The x position of the robot
+       * @param y The y position of the robot
+       * @param theta The orientation of the robot
+       * @param vx The x velocity of the robot
+       * @param vy The y velocity of the robot
+       * @param vtheta The theta velocity of the robot
+       * @param vx_samp The x velocity used to seed the trajectory
+       * @param vy_samp The y velocity used to seed the trajectory
+       * @param vtheta_samp The theta velocity used to seed the trajectory
+       * @param acc_x The x acceleration limit of the robot
+       * @param acc_y The y acceleration limit of the robot
+       * @param acc_theta The theta acceleration limit of the robot
+       * @param impossible_cost The cost value of a cell in the local map grid that is considered impassable
+       * @param reference The trajectory whose goal cost has to be beaten, ignored if it is not legal
+       * @param traj Will be set to the generated trajectory with its associated score
+       */
+      void generateProgressingTrajectory(double x, double y, double theta, double vx, double vy,
+          double vtheta, double vx_samp, double vy_samp, double vtheta_samp, double acc_x, double acc_y,
+          double acc_theta, double impossible_cost, const Trajectory& reference, Trajectory& traj);
+
+      /**
+       * @brief  Compute the goal cost a trajectory would end with, by only integrating its velocities
+       * up to the last point, without any footprint or map checks along the way
+       * @param goal_cost Will be set to the goal cost of the last point of the trajectory
+       * @return False if the last point is off the map or has no path to the goal, so the trajectory would be illegal
+       */
+      bool endpointGoalCost(double x, double y, double theta, double vx, double vy,
+          double vtheta, double vx_samp, double vy_samp, double vtheta_samp, double acc_x, double acc_y,
+          double acc_theta, double impossible_cost, double& goal_cost);
+
+      /**
+       * @brief  Compute the number of points a trajectory is simulated with
+       * @param vx_samp The x velocity used to seed the trajectory
+       * @param vy_samp The y velocity used to seed the trajectory
+       * @param vtheta_samp The theta velocity used to seed the trajectory
+       * @return The number of points, at least one
+       */
+      int computeNumSteps(double vx_samp, double vy_samp, double vtheta_samp);
 
       /**
        * @brief  Checks the legality of the robot footprint at a position and orientation using the world model
@@ -263,10 +523,15 @@ namespace base_local_planner {
     
       MapGrid path_map_; ///< @brief The local map grid where we propagate path distance
       MapGrid goal_map_; ///< @brief The local map grid where we propagate goal distance
+      CoarseGraph coarse_graph_; ///< @brief The coarse graph of the costmap all distance grids of a cycle share outside of the region of interest
       const costmap_2d::Costmap2D& costmap_; ///< @brief Provides access to cost map information
       WorldModel& world_model_; ///< @brief The world model that the controller uses for collision detection
 
-      std::vector<geometry_msgs::Point> footprint_spec_; ///< @brief The footprint specification of the robot
+      boost::shared_ptr<const FootprintSet> footprint_; ///< @brief The footprint of the robot and its derived data, only replaced between cycles
+      boost::shared_ptr<const FootprintSet> pending_footprint_; ///< @brief The footprint to switch to at the start of the next cycle
+      std::map<int, boost::shared_ptr<const FootprintSet> > footprint_sets_; ///< @brief The registered footprints by id
+      unsigned int footprint_heading_bins_; ///< @brief The number of heading ranges footprint outline tables are built for, 0 to check the polygon
+      boost::mutex footprint_mutex_; ///< @brief Guards pending_footprint_, footprint_sets_ and footprint_heading_bins_
 
       std::vector<geometry_msgs::PoseStamped> global_plan_; ///< @brief The global path for the robot to follow
 
@@ -293,6 +558,8 @@ namespace base_local_planner {
       int vtheta_samples_; ///< @brief The number of samples we'll take in the theta dimension of the control space
 
       double path_distance_max_; ///< @brief Maximum allowable distance from global path
+      int coarse_grid_factor_; ///< @brief Cells per coarse distance cell outside the reach of the rollouts, 1 for full resolution everywhere
+      double path_cost_weight_; ///< @brief Extra distance in cells of passing the highest cost when computing path and goal distances, 0 counts cells
       double pdist_scale_, gdist_scale_, occdist_scale_, hdiff_scale_; ///< @brief Scaling factors for the controller's cost function
       double acc_lim_x_, acc_lim_y_, acc_lim_theta_; ///< @brief The acceleration limits of the robot
 
@@ -300,6 +567,7 @@ namespace base_local_planner {
       double escape_x_, escape_y_, escape_theta_; ///< @brief Used to calculate the distance the robot has traveled before reseting escape booleans
 
       Trajectory traj_one, traj_two; ///< @brief Used for scoring trajectories
+      TrajectoryPool trajectory_pool_; ///< @brief Buffers for the other trajectories simulated per call, reused across calls
 
       double heading_lookahead_; ///< @brief How far the robot should look ahead of itself when differentiating between different rotational velocities
       double oscillation_reset_dist_; ///< @brief The distance the robot must travel before it can explore rotational velocities that were unsuccessful in the past
@@ -326,8 +594,47 @@ namespace base_local_planner {
       double occ_dist_, occ_cost_;
       double angle1_, angle2_;
 
-      double inscribed_radius_, circumscribed_radius_;
+      CostBoundsGrid cost_bounds_; ///< @brief Cost bounds over the footprint around each cell, to skip footprint checks where they cannot matter
+      bool cost_bounds_valid_; ///< @brief True while cost_bounds_ matches the costmap, during findBestPath
+      unsigned char cost_bounds_limit_; ///< @brief The window maximum below which the footprint is legal, lower for point robots
+      bool costmap_world_model_; ///< @brief The cost bounds only apply if collisions are checked against the costmap
+      CostmapMirror* costmap_mirror_; ///< @brief Reports the cells that changed between cycles, NULL if the costmap is shared
+      bool cost_bounds_synced_; ///< @brief True if cost_bounds_ holds every change costmap_mirror_ reported so far
+
+      RolloutField rollout_field_; ///< @brief Path distance, goal distance and cost of each cell interleaved for the rollouts
+      bool rollout_field_valid_; ///< @brief True while rollout_field_ matches the maps, during findBestPath
+
+      bool latency_compensation_; ///< @brief Whether rollouts start from the state predicted for when the command takes effect
+      double actuation_delay_; ///< @brief Seconds from handing back a command until the base acts on it
+      double planning_latency_; ///< @brief Smoothed wall time findBestPath takes
+      Eigen::Vector3f last_cmd_vel_; ///< @brief The command of the last cycle
+      bool last_cmd_valid_; ///< @brief Whether a cycle ran yet
+      ros::WallTime last_cycle_end_; ///< @brief When the last cycle handed back its command
+
+      int blocked_cycles_; ///< @brief Failed searches in a row after which the search waits for the surroundings to change, 0 to always search
+      int failed_searches_; ///< @brief Searches in a row that found no legal trajectory
+      bool blocked_; ///< @brief Whether the search is suspended until the surroundings of the robot change
+      unsigned int blocked_hash_; ///< @brief Checksum of the costmap around the robot and of the plan when it got blocked
+      double blocked_x_, blocked_y_, blocked_theta_; ///< @brief The pose the robot got blocked at
+
+      std::vector<Corridor> corridors_; ///< @brief The alternative plans of findBestCorridorPaths
+      bool corridors_active_; ///< @brief True while the rollouts are also scored against corridors_, during findBestCorridorPaths
+
+      /**
+       * @brief  Close a search phase, and decide whether the best trajectory so far is good enough to end the search
+       * @param skipped True if an earlier phase already ended the search, so this one did not run
+       * @param rollouts The trajectories the phase scored
+       * @param best The best trajectory so far
+       * @param reference The trajectory of standing still, its endpoint is where the progress toward the goal is measured from
+       * @return True if the later phases can be skipped
+       */
+      bool finishSearchPhase(SearchPhase phase, bool skipped, const SearchPhaseGate& gate, unsigned int rollouts,
+          const Trajectory& best, const Trajectory& reference);
+
+      SearchPhaseGate search_gates_[NUM_SEARCH_PHASES]; ///< @brief Budgets and gates of the search phases, guarded by configuration_mutex_
+      SearchPhaseStats search_phase_stats_[NUM_SEARCH_PHASES]; ///< @brief What the search phases did so far
 
+      boost::shared_ptr<TaskScheduler> scheduler_; ///< @brief Runs the parallel work, guarded by configuration_mutex_
       boost::mutex configuration_mutex_;
 
       /**
@@ -47,12 +47,15 @@
 #include <base_local_planner/voxel_grid_model.h>
 #include <base_local_planner/trajectory_planner.h>
 #include <base_local_planner/map_grid_visualizer.h>
+#include <base_local_planner/latency_histogram.h>
+#include <base_local_planner/shared_plan.h>
 
 #include <base_local_planner/planar_laser_scan.h>
 
 #include <tf/transform_datatypes.h>
 
 #include <nav_msgs/Odometry.h>
+#include <sensor_msgs/LaserScan.h>
 #include <geometry_msgs/PoseStamped.h>
 #include <geometry_msgs/Twist.h>
 #include <geometry_msgs/Point.h>
@@ -60,6 +63,7 @@
 #include <tf/transform_listener.h>
 
 #include <boost/thread.hpp>
+#include <boost/scoped_ptr.hpp>
 
 #include <string>
 
@@ -187,13 +191,72 @@ namespace base_local_planner {
        */
       bool stopWithAccLimits(const tf::Stamped<tf::Pose>& global_pose, const tf::Stamped<tf::Pose>& robot_vel, geometry_msgs::Twist& cmd_vel);
 
+      /**
+       * @brief Record how old the inputs of this cycle are at decision time, and publish the histograms of their ages
+       * @param  global_pose The pose of the robot in the global frame, stamped with the time of its transform
+       * @param  robot_vel The velocity of the robot, stamped with the time of its odometry
+       * @param  transformed_plan The plan in the global frame, stamped with the time of its transform
+       */
+      void recordInputAges(const tf::Stamped<tf::Pose>& global_pose, const tf::Stamped<tf::Pose>& robot_vel,
+          const std::vector<geometry_msgs::PoseStamped>& transformed_plan);
+
+      /**
+       * @brief Publish the allocations of this cycle and the memory the planner holds
+       * @param  cycle_allocations The allocation count when the cycle started
+       * @param  cycle_allocated_bytes The allocated bytes when the cycle started
+       */
+      void recordMemoryUsage(uint64_t cycle_allocations, uint64_t cycle_allocated_bytes);
+
+      /**
+       * @brief Drop the background tasks that did not start yet and wait for the running ones, before the maps they read change
+       */
+      void cancelBackgroundTasks();
+
+      /**
+       * @brief Publish the cost cloud of this cycle from the background lane of the scheduler of the controller
+       */
+      void publishCostCloud();
+
+      /**
+       * @brief Publish the cost cloud while holding the lock of the costmap, run as a background task
+       */
+      void publishLockedCostCloud();
+
+      /**
+       * @brief Publish the work done in each lane of the scheduler since the last cycle
+       */
+      void recordSchedulerLoad();
+
+      /**
+       * @brief Publish what each phase of the velocity search did since the last cycle
+       */
+      void recordSearchPhases();
+
+      /**
+       * @brief Keep the newest scan for the voxel grid, it is applied at the start of the next cycle
+       */
+      void scanCB(const sensor_msgs::LaserScan::ConstPtr& scan);
+
+      /**
+       * @brief Move the voxel grid along with the costmap, then clear and mark it with the newest scan, if one came in since the last cycle
+       */
+      void updateVoxelGrid();
+
       std::vector<double> loadYVels(ros::NodeHandle node);
 
+      /**
+       * @brief Load the parts of the robot at different heights from the footprint_sections parameter, a list of
+       * entries with a footprint, a min_z and a max_z
+       * @return The sections, none if the parameter is not set or malformed
+       */
+      std::vector<FootprintSection> loadFootprintSections(ros::NodeHandle node);
+
       double sign(double x){
         return x < 0.0 ? -1.0 : 1.0;
       }
 
       WorldModel* world_model_; ///< @brief The world model that the controller will use
+      VoxelGridModel* voxel_model_; ///< @brief The world model if it is a voxel grid, NULL otherwise
       TrajectoryPlanner* tc_; ///< @brief The trajectory controller
 
       costmap_2d::Costmap2DROS* costmap_ros_; ///< @brief The ROS wrapper for the costmap the controller will use
@@ -206,7 +269,8 @@ namespace base_local_planner {
       std::string robot_base_frame_; ///< @brief Used as the base frame id of the robot
       double rot_stopped_velocity_, trans_stopped_velocity_;
       double xy_goal_tolerance_, yaw_goal_tolerance_, min_in_place_vel_th_;
-      std::vector<geometry_msgs::PoseStamped> global_plan_;
+      SharedPlan global_plan_; ///< @brief Stored once per plan, pruning only moves its start
+      std::vector<geometry_msgs::PoseStamped> transformed_plan_; ///< @brief Filled every cycle, then swapped with the previous plan of the controller
       bool prune_plan_;
       boost::recursive_mutex odom_lock_;
 
@@ -218,6 +282,24 @@ namespace base_local_planner {
       bool latch_xy_goal_tolerance_, xy_tolerance_latch_;
 
       ros::Publisher g_plan_pub_, l_plan_pub_;
+      ros::Publisher latency_pub_; ///< @brief Publishes the age histograms of the inputs
+      ros::Publisher memory_pub_; ///< @brief Publishes the memory use of each cycle
+      ros::Publisher scheduler_pub_; ///< @brief Publishes the load of the lanes of the scheduler
+
+      boost::shared_ptr<TaskScheduler> scheduler_; ///< @brief The scheduler of the controller the background tasks were handed to
+      boost::scoped_ptr<TaskGroup> background_tasks_; ///< @brief Tasks nobody waits for, declared after the scheduler they run on
+      boost::mutex background_mutex_; ///< @brief Guards stop_background_
+      bool stop_background_; ///< @brief Set while cancelBackgroundTasks waits, running background tasks should return early
+      boost::shared_ptr<TaskScheduler> stats_scheduler_; ///< @brief The scheduler last_lane_stats_ were taken from
+      TaskScheduler::LaneStats last_lane_stats_[TaskScheduler::NUM_LANES]; ///< @brief The lane statistics at the last cycle
+      ros::WallTime last_lane_stats_time_;
+      ros::Publisher search_phase_pub_; ///< @brief Publishes what the phases of the velocity search did
+      TrajectoryPlanner::SearchPhaseStats last_search_phase_stats_[TrajectoryPlanner::NUM_SEARCH_PHASES]; ///< @brief The phase statistics at the last cycle
+
+      LatencyHistogram pose_age_; ///< @brief Age of the robot pose transform
+      LatencyHistogram odom_age_; ///< @brief Age of the odometry velocity
+      LatencyHistogram plan_age_; ///< @brief Age of the global plan transform
+      LatencyHistogram end_to_end_age_; ///< @brief Age of the newest sensor data, when the velocity command is handed back
 
       dynamic_reconfigure::Server<BaseLocalPlannerConfig> *dsrv_;
       base_local_planner::BaseLocalPlannerConfig default_config_;
@@ -228,6 +310,10 @@ namespace base_local_planner {
       base_local_planner::OdometryHelperRos odom_helper_;
 
       std::vector<geometry_msgs::Point> footprint_spec_;
+
+      ros::Subscriber scan_sub_; ///< @brief The scans the voxel grid is cleared and marked with
+      boost::mutex scan_mutex_; ///< @brief Guards pending_scan_
+      sensor_msgs::LaserScan::ConstPtr pending_scan_; ///< @brief The newest scan not yet applied to the voxel grid, NULL if there is none
   };
 };
 #endif
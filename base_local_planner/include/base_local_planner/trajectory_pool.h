@@ -0,0 +1,120 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the Willow Garage nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef TRAJECTORY_ROLLOUT_TRAJECTORY_POOL_H_
+#define TRAJECTORY_ROLLOUT_TRAJECTORY_POOL_H_
+
+#include <vector>
+#include <boost/thread.hpp>
+#include <boost/noncopyable.hpp>
+#include <base_local_planner/trajectory.h>
+
+namespace base_local_planner {
+  /**
+   * @class TrajectoryPool
+   * @brief Keeps Trajectory buffers alive between planning cycles, so that their point
+   * storage is allocated once instead of on every cycle. Safe to share between threads.
+   */
+  class TrajectoryPool : private boost::noncopyable {
+    public:
+      TrajectoryPool() : peak_in_use_(0) {}
+
+      /**
+       * @brief  Deletes all buffers, none may be in use anymore
+       */
+      ~TrajectoryPool();
+
+      /**
+       * @brief  Take a buffer out of the pool, creating one if all are in use
+       * @param num_pts The number of points the buffer should hold without allocating
+       * @return The buffer, its points are cleared
+       */
+      Trajectory* acquire(unsigned int num_pts = 0);
+
+      /**
+       * @brief  Give a buffer back to the pool
+       * @param traj A buffer acquired from this pool
+       */
+      void release(Trajectory* traj);
+
+      /**
+       * @brief  The number of buffers the pool created
+       */
+      unsigned int getSize();
+
+      /**
+       * @brief  The most buffers in use at once since the last call, which then starts over from the buffers in use now
+       */
+      unsigned int takePeakInUse();
+
+      /**
+       * @brief  The heap memory of all buffers, reserved capacity included. Call it between planning cycles,
+       * buffers in use may still be growing.
+       */
+      size_t getMemoryUsage();
+
+    private:
+      boost::mutex mutex_;
+      std::vector<Trajectory*> buffers_; ///< @brief Every buffer the pool created
+      std::vector<Trajectory*> free_; ///< @brief The buffers not in use
+      unsigned int peak_in_use_; ///< @brief The most buffers in use at once since takePeakInUse
+  };
+
+  /**
+   * @class PooledTrajectory
+   * @brief Holds a buffer of a TrajectoryPool for the lifetime of the handle
+   */
+  class PooledTrajectory : private boost::noncopyable {
+    public:
+      /**
+       * @brief  Acquire a buffer
+       * @param pool The pool to take the buffer from, it has to outlive the handle
+       * @param num_pts The number of points the buffer should hold without allocating
+       */
+      PooledTrajectory(TrajectoryPool& pool, unsigned int num_pts = 0)
+        : pool_(pool), traj_(pool.acquire(num_pts)) {}
+
+      ~PooledTrajectory() { pool_.release(traj_); }
+
+      Trajectory& operator*() const { return *traj_; }
+
+      Trajectory* operator->() const { return traj_; }
+
+    private:
+      TrajectoryPool& pool_;
+      Trajectory* traj_;
+  };
+};
+
+#endif
@@ -42,6 +42,27 @@
 
 namespace base_local_planner {
 
+/**
+ * @class TrajectoryPoseObserver
+ * @brief Receives the poses of a trajectory while a generator simulates it
+ */
+class TrajectoryPoseObserver {
+public:
+
+  /**
+   * Called once the velocities of traj are set, before the first pose is added
+   */
+  virtual void startTrajectory(Trajectory &traj) = 0;
+
+  /**
+   * Called after the pose at index was added to traj.
+   * Returning false stops the simulation of traj.
+   */
+  virtual bool poseAdded(Trajectory &traj, unsigned int index) = 0;
+
+  virtual ~TrajectoryPoseObserver() {}
+};
+
 /**
  * @class TrajectorySampleGenerator
  * @brief Provides an interface for navigation trajectory generators
@@ -59,6 +80,51 @@ public:
    */
   virtual bool nextTrajectory(Trajectory &traj) = 0;
 
+  /**
+   * Like nextTrajectory, but hands each pose to observer as soon as it exists.
+   * Returns false if no trajectory was generated or the observer stopped it.
+   * The default simulates the whole trajectory first and then replays its poses,
+   * generators should overwrite this to stop simulating early.
+   */
+  virtual bool nextTrajectory(Trajectory &traj, TrajectoryPoseObserver &observer) {
+    if ( ! nextTrajectory(traj)) {
+      return false;
+    }
+    observer.startTrajectory(traj);
+    for (unsigned int i = 0; i < traj.getPointsSize(); ++i) {
+      if ( ! observer.poseAdded(traj, i)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * Writes the velocities (xv_, yv_, thetav_) the next trajectory will be
+   * stored with into traj, without simulating it or advancing the generator.
+   * Returns false if the generator cannot tell the velocities in advance,
+   * in which case callers have to use nextTrajectory.
+   */
+  virtual bool peekNextVelocities(Trajectory &traj) {
+    return false;
+  }
+
+  /**
+   * Advances past the next trajectory without simulating it.
+   */
+  virtual void skipTrajectory() {
+    Trajectory traj;
+    nextTrajectory(traj);
+  }
+
+  /**
+   * An upper bound on the number of poses of the trajectories left to generate,
+   * used to size trajectory buffers up front. 0 if the generator cannot tell.
+   */
+  virtual unsigned int getMaxNumPoints() {
+    return 0;
+  }
+
   /**
    * @brief  Virtual destructor for the interface
    */
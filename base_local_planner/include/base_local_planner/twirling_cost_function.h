@@ -58,6 +58,8 @@ public:
   double scoreTrajectory(Trajectory &traj);
 
   bool prepare() {return true;};
+
+  bool isVelocityOnly() {return true;};
 };
 
 } /* namespace base_local_planner */
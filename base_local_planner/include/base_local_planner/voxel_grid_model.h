@@ -39,21 +39,32 @@
 #include <vector>
 #include <list>
 #include <cfloat>
+#include <stdint.h>
 #include <geometry_msgs/Point.h>
 #include <costmap_2d/observation.h>
 #include <base_local_planner/world_model.h>
+#include <base_local_planner/laser_beam_table.h>
+#include <sensor_msgs/LaserScan.h>
 
 #include <pcl/point_types.h>
 #include <pcl/point_cloud.h>
 
-//voxel grid stuff
-#include <voxel_grid/voxel_grid.h>
+#include <base_local_planner/sparse_voxel_grid.h>
 
 namespace base_local_planner {
+  /**
+   * @brief A part of the robot that only takes up a range of heights, like a mast or an arm above a narrow base
+   */
+  struct FootprintSection {
+    std::vector<geometry_msgs::Point> polygon; ///< @brief The outline of the part, relative to the robot center
+    double min_z, max_z; ///< @brief The heights the part spans, in the frame of the grid
+  };
+
   /**
    * @class VoxelGridModel
    * @brief A class that implements the WorldModel interface to provide grid
    * based collision checks for the trajectory controller using a 3D voxel grid.
+   * The grid only stores the bricks of voxels that hold obstacles.
    */
   class VoxelGridModel : public WorldModel {
     public:
@@ -61,7 +72,7 @@ namespace base_local_planner {
        * @brief  Constructor for the VoxelGridModel
        * @param size_x The x size of the map
        * @param size_y The y size of the map
-       * @param size_z The z size of the map... up to 32 cells
+       * @param size_z The z size of the map
        * @param xy_resolution The horizontal resolution of the map in meters/cell
        * @param z_resolution The vertical resolution of the map in meters/cell
        * @param origin_x The x value of the origin of the map
@@ -91,6 +102,26 @@ namespace base_local_planner {
 
       using WorldModel::footprintCost;
 
+      /**
+       * @brief  Checks the footprint sections of the robot at a pose, only against the voxels at their heights.
+       * Without sections the footprint spec is checked against whole columns, as by the other overloads.
+       * @param  x The x position of the robot in world coordinates
+       * @param  y The y position of the robot in world coordinates
+       * @param  theta The heading of the robot
+       * @param  footprint_spec The footprint of the robot, relative to its center, only used without sections
+       * @param  inscribed_radius The radius of the inscribed circle of the robot
+       * @param  circumscribed_radius The radius of the circumscribed circle of the robot
+       * @return Positive if no section hits an obstacle, negative otherwise
+       */
+      virtual double footprintCost(double x, double y, double theta, const std::vector<geometry_msgs::Point>& footprint_spec,
+          double inscribed_radius = 0.0, double circumscribed_radius = 0.0);
+
+      /**
+       * @brief  Describe the robot as parts at different heights, instead of one footprint spanning every height
+       * @param sections The parts of the robot, none to go back to checking the footprint spec
+       */
+      void setFootprintSections(const std::vector<FootprintSection>& sections);
+
       /**
        * @brief  The costmap already keeps track of world observations, so for this world model this method does nothing
        * @param footprint The footprint of the robot in its current location
@@ -100,8 +131,30 @@ namespace base_local_planner {
       void updateWorld(const std::vector<geometry_msgs::Point>& footprint,
           const std::vector<costmap_2d::Observation>& observations, const std::vector<PlanarLaserScan>& laser_scans);
 
+      /**
+       * @brief  Clears and marks the voxels of a planar scan straight from its ranges, without projecting it into a cloud first
+       * @param footprint The footprint of the robot in its current location
+       * @param scan The scan, its ranges are read in the frame of the scanner
+       * @param sensor_origin The position of the scanner in the frame of the grid
+       * @param sensor_yaw The heading of the scanner in the frame of the grid, the scanner is assumed to be level
+       */
+      void updateWorld(const std::vector<geometry_msgs::Point>& footprint, const sensor_msgs::LaserScan& scan,
+          const geometry_msgs::Point& sensor_origin, double sensor_yaw);
+
+      /**
+       * @brief  Move the grid to a new origin, keeping the voxels of the area both cover, as a rolling costmap does
+       * @param new_origin_x The x value of the new origin, the grid moves by whole cells towards it
+       * @param new_origin_y The y value of the new origin, the grid moves by whole cells towards it
+       */
+      void updateOrigin(double new_origin_x, double new_origin_y);
+
       void getPoints(pcl::PointCloud<pcl::PointXYZ>& cloud);
 
+      /**
+       * @brief  The heap memory of the voxel bricks
+       */
+      size_t getMemoryUsage();
+
     private:
       /**
        * @brief  Rasterizes a line in the costmap grid and checks for collisions
@@ -123,6 +176,13 @@ namespace base_local_planner {
 
       void removePointsInScanBoundry(const PlanarLaserScan& laser_scan, double raytrace_range);
 
+      /**
+       * @brief  Checks the outline of a footprint section against the voxels within its heights
+       * @return 0 for a legal section, negative otherwise
+       */
+      double sectionCost(double x, double y, double cos_th, double sin_th, const std::vector<geometry_msgs::Point>& polygon,
+          int min_z, int max_z);
+
       inline bool worldToMap3D(double wx, double wy, double wz, unsigned int& mx, unsigned int& my, unsigned int& mz){
         if(wx < origin_x_ || wy < origin_y_ || wz < origin_z_)
           return false;
@@ -164,7 +224,7 @@ namespace base_local_planner {
         obstacle_grid_.markVoxel(cell_x, cell_y, cell_z);
       }
 
-      voxel_grid::VoxelGrid obstacle_grid_;
+      SparseVoxelGrid obstacle_grid_;
       double xy_resolution_;
       double z_resolution_;
       double origin_x_;
@@ -173,6 +233,11 @@ namespace base_local_planner {
       double max_z_;  ///< @brief The height cutoff for adding points as obstacles
       double sq_obstacle_range_;  ///< @brief The square distance at which we no longer add obstacles to the grid
 
+      std::vector<FootprintSection> sections_; ///< @brief The parts of the robot at different heights, empty to check whole columns
+      std::vector<int> section_min_z_, section_max_z_; ///< @brief The voxels each section spans, empty if the max is below the min
+      LaserBeamTable beams_; ///< @brief The beam directions of the last scanner geometry seen
+      std::vector<pcl::PointXYZ> scan_hits_; ///< @brief The hits of the current scan waiting to be marked, reused between scans
+
   };
 };
 #endif
@@ -37,6 +37,7 @@
 #ifndef TRAJECTORY_ROLLOUT_WORLD_MODEL_H_
 #define TRAJECTORY_ROLLOUT_WORLD_MODEL_H_
 
+#include <cstddef>
 #include <vector>
 #include <costmap_2d/observation.h>
 #include <costmap_2d/footprint.h>
@@ -62,7 +63,17 @@ namespace base_local_planner {
       virtual double footprintCost(const geometry_msgs::Point& position, const std::vector<geometry_msgs::Point>& footprint,
           double inscribed_radius, double circumscribed_radius) = 0;
 
-      double footprintCost(double x, double y, double theta, const std::vector<geometry_msgs::Point>& footprint_spec, double inscribed_radius = 0.0, double circumscribed_radius=0.0){
+      /**
+       * @brief  Checks the footprint of the robot at a pose, subclasses that know more about the shape of the robot than its footprint may override this
+       * @param  x The x position of the robot in world coordinates
+       * @param  y The y position of the robot in world coordinates
+       * @param  theta The heading of the robot
+       * @param  footprint_spec The footprint of the robot, relative to its center
+       * @param  inscribed_radius The radius of the inscribed circle of the robot, computed if 0
+       * @param  circumscribed_radius The radius of the circumscribed circle of the robot
+       * @return Positive if all the points lie outside the footprint, negative otherwise
+       */
+      virtual double footprintCost(double x, double y, double theta, const std::vector<geometry_msgs::Point>& footprint_spec, double inscribed_radius = 0.0, double circumscribed_radius=0.0){
 
         double cos_th = cos(theta);
         double sin_th = sin(theta);
@@ -98,6 +109,13 @@ namespace base_local_planner {
         return footprintCost(position, footprint, inscribed_radius, circumscribed_radius); 
       }
 
+      /**
+       * @brief  The heap memory the model keeps about the world, 0 for models that only look into a costmap they do not own
+       */
+      virtual size_t getMemoryUsage() {
+        return 0;
+      }
+
       /**
        * @brief  Subclass will implement a destructor
        */
@@ -0,0 +1,163 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the Willow Garage nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+#include <base_local_planner/coarse_graph.h>
+#include <costmap_2d/cost_values.h>
+#include <base_local_planner/memory_usage.h>
+#include <algorithm>
+
+namespace base_local_planner {
+
+  const unsigned int CoarseGraph::NO_NODE;
+
+  CoarseGraph::CoarseGraph() : size_x_(0), size_y_(0), factor_(1), num_nodes_(0) {}
+
+  //cells the distance wavefronts do not pass through
+  static inline bool isObstacle(unsigned char cost) {
+    return cost == costmap_2d::LETHAL_OBSTACLE || cost == costmap_2d::INSCRIBED_INFLATED_OBSTACLE ||
+      cost == costmap_2d::NO_INFORMATION;
+  }
+
+  void CoarseGraph::update(const costmap_2d::Costmap2D& costmap, unsigned int factor) {
+    unsigned int k = std::max(factor, 1u);
+    factor_ = k;
+    size_x_ = costmap.getSizeInCellsX();
+    size_y_ = costmap.getSizeInCellsY();
+    const unsigned char* costs = costmap.getCharMap();
+
+    //grow a node from each free cell not in one yet, without leaving its coarse cell
+    node_.assign(size_x_ * size_y_, NO_NODE);
+    num_nodes_ = 0;
+    for (unsigned int by0 = 0; by0 < size_y_; by0 += k) {
+      unsigned int by1 = std::min(by0 + k, size_y_) - 1;
+      for (unsigned int bx0 = 0; bx0 < size_x_; bx0 += k) {
+        unsigned int bx1 = std::min(bx0 + k, size_x_) - 1;
+
+        //most coarse cells hold no obstacle, they are a single node without growing one
+        bool free = true;
+        for (unsigned int y = by0; y <= by1 && free; ++y) {
+          for (unsigned int x = bx0; x <= bx1; ++x) {
+            if (isObstacle(costs[y * size_x_ + x])) {
+              free = false;
+              break;
+            }
+          }
+        }
+        if (free) {
+          for (unsigned int y = by0; y <= by1; ++y) {
+            std::fill(node_.begin() + y * size_x_ + bx0, node_.begin() + y * size_x_ + bx1 + 1, num_nodes_);
+          }
+          ++num_nodes_;
+          continue;
+        }
+
+        for (unsigned int y = by0; y <= by1; ++y) {
+          for (unsigned int x = bx0; x <= bx1; ++x) {
+            unsigned int i = y * size_x_ + x;
+            if (node_[i] != NO_NODE || isObstacle(costs[i])) {
+              continue;
+            }
+            node_[i] = num_nodes_;
+            fill_.push_back(i);
+            while (!fill_.empty()) {
+              unsigned int cell = fill_.back();
+              fill_.pop_back();
+              unsigned int cx = cell % size_x_, cy = cell / size_x_;
+              unsigned int neighbors[4];
+              unsigned int num_neighbors = 0;
+              if (cx > bx0) neighbors[num_neighbors++] = cell - 1;
+              if (cx < bx1) neighbors[num_neighbors++] = cell + 1;
+              if (cy > by0) neighbors[num_neighbors++] = cell - size_x_;
+              if (cy < by1) neighbors[num_neighbors++] = cell + size_x_;
+              for (unsigned int n = 0; n < num_neighbors; ++n) {
+                unsigned int next = neighbors[n];
+                if (node_[next] == NO_NODE && !isObstacle(costs[next])) {
+                  node_[next] = num_nodes_;
+                  fill_.push_back(next);
+                }
+              }
+            }
+            ++num_nodes_;
+          }
+        }
+      }
+    }
+
+    //two nodes are adjacent where a free cell of one borders a free cell of the other across a coarse cell border,
+    //walking along each border the same two nodes mostly repeat, so only changes are kept
+    pairs_.clear();
+    for (unsigned int y = k - 1; y + 1 < size_y_; y += k) {
+      addLinks(y * size_x_, 1, size_x_, size_x_);
+    }
+    for (unsigned int x = k - 1; x + 1 < size_x_; x += k) {
+      addLinks(x, size_x_, 1, size_y_);
+    }
+
+    //bucket the links by their first node, a link left twice only costs the wavefronts a second look
+    link_start_.assign(num_nodes_ + 1, 0);
+    for (unsigned int i = 0; i < pairs_.size(); ++i) {
+      ++link_start_[pairs_[i].first + 1];
+    }
+    for (unsigned int n = 0; n < num_nodes_; ++n) {
+      link_start_[n + 1] += link_start_[n];
+    }
+    links_.resize(pairs_.size());
+    for (unsigned int i = 0; i < pairs_.size(); ++i) {
+      links_[link_start_[pairs_[i].first]++] = pairs_[i].second;
+    }
+    //filling moved each start to the next one, shift them back
+    for (unsigned int n = num_nodes_; n > 0; --n) {
+      link_start_[n] = link_start_[n - 1];
+    }
+    link_start_[0] = 0;
+  }
+
+  void CoarseGraph::addLinks(unsigned int start, unsigned int step, unsigned int across, unsigned int length) {
+    unsigned int last_node = NO_NODE, last_other = NO_NODE;
+    for (unsigned int i = 0, cell = start; i < length; ++i, cell += step) {
+      unsigned int node = node_[cell], other = node_[cell + across];
+      if (node == NO_NODE || other == NO_NODE || (node == last_node && other == last_other)) {
+        continue;
+      }
+      pairs_.push_back(std::make_pair(node, other));
+      pairs_.push_back(std::make_pair(other, node));
+      last_node = node;
+      last_other = other;
+    }
+  }
+
+  size_t CoarseGraph::getMemoryUsage() const {
+    return vectorBytes(node_) + vectorBytes(link_start_) + vectorBytes(links_) + vectorBytes(fill_) + vectorBytes(pairs_);
+  }
+
+};
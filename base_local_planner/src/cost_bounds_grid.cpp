@@ -0,0 +1,162 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the Willow Garage nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <base_local_planner/cost_bounds_grid.h>
+#include <base_local_planner/memory_usage.h>
+#include <costmap_2d/cost_values.h>
+
+#include <cmath>
+#include <algorithm>
+
+namespace base_local_planner {
+
+  CostBoundsGrid::CostBoundsGrid() : size_x_(0), size_y_(0), radius_(0), computed_radius_(0), computed_(false) {}
+
+  void CostBoundsGrid::setRadius(unsigned int radius) {
+    radius_ = radius;
+  }
+
+  unsigned int CostBoundsGrid::footprintRadius(const std::vector<geometry_msgs::Point>& footprint, double resolution) {
+    //a point robot is only checked at its center cell
+    if (footprint.size() < 3) {
+      return 0;
+    }
+    double circumscribed_radius = 0.0;
+    for (unsigned int i = 0; i < footprint.size(); ++i) {
+      circumscribed_radius = std::max(circumscribed_radius, hypot(footprint[i].x, footprint[i].y));
+    }
+    //two points this far apart can not fall into cells that are further apart than this
+    return (unsigned int) ceil(circumscribed_radius / resolution);
+  }
+
+  unsigned char CostBoundsGrid::legalCostLimit(const std::vector<geometry_msgs::Point>& footprint) {
+    //a point robot is in collision on an inscribed cell, a polygon only when its outline touches a lethal one
+    return footprint.size() < 3 ? costmap_2d::INSCRIBED_INFLATED_OBSTACLE : costmap_2d::LETHAL_OBSTACLE;
+  }
+
+  void CostBoundsGrid::update(const costmap_2d::Costmap2D& costmap) {
+    size_x_ = costmap.getSizeInCellsX();
+    size_y_ = costmap.getSizeInCellsY();
+    unsigned int size = size_x_ * size_y_;
+    max_cost_.resize(size);
+    min_cost_.resize(size);
+    max_rows_.resize(size);
+    min_rows_.resize(size);
+
+    const unsigned char* map = costmap.getCharMap();
+    if (size == 0 || map == NULL) {
+      computed_ = false;
+      return;
+    }
+
+    //the windows are squares, so the filter is separable into a row and a column pass
+    for (unsigned int y = 0; y < size_y_; ++y) {
+      filterLine(map + y * size_x_, &max_rows_[y * size_x_], size_x_, 1, true);
+      filterLine(map + y * size_x_, &min_rows_[y * size_x_], size_x_, 1, false);
+    }
+    for (unsigned int x = 0; x < size_x_; ++x) {
+      filterLine(&max_rows_[x], &max_cost_[x], size_y_, size_x_, true);
+      filterLine(&min_rows_[x], &min_cost_[x], size_y_, size_x_, false);
+    }
+    computed_radius_ = radius_;
+    computed_ = true;
+  }
+
+  void CostBoundsGrid::updateRegion(const costmap_2d::Costmap2D& costmap, unsigned int x0, unsigned int y0, unsigned int x1, unsigned int y1) {
+    if (!computed_ || radius_ != computed_radius_ ||
+        size_x_ != costmap.getSizeInCellsX() || size_y_ != costmap.getSizeInCellsY()) {
+      update(costmap);
+      return;
+    }
+    x1 = std::min(x1, size_x_ - 1);
+    y1 = std::min(y1, size_y_ - 1);
+    if (x0 > x1 || y0 > y1) {
+      return;
+    }
+
+    //a changed cell only enters the row pass of its own row...
+    const unsigned char* map = costmap.getCharMap();
+    for (unsigned int y = y0; y <= y1; ++y) {
+      filterLine(map + y * size_x_, &max_rows_[y * size_x_], size_x_, 1, true);
+      filterLine(map + y * size_x_, &min_rows_[y * size_x_], size_x_, 1, false);
+    }
+    //...but those rows changed up to the window radius to both sides of the region
+    unsigned int cx0 = x0 > radius_ ? x0 - radius_ : 0;
+    unsigned int cx1 = std::min(x1 + radius_, size_x_ - 1);
+    for (unsigned int x = cx0; x <= cx1; ++x) {
+      filterLine(&max_rows_[x], &max_cost_[x], size_y_, size_x_, true);
+      filterLine(&min_rows_[x], &min_cost_[x], size_y_, size_x_, false);
+    }
+  }
+
+  void CostBoundsGrid::filterLine(const unsigned char* in, unsigned char* out, unsigned int n, unsigned int stride, bool take_max) {
+    //pad the line with a neutral value on both sides, so the windows can be clipped at the map border
+    unsigned char pad = take_max ? 0 : 255;
+    unsigned int window = 2 * radius_ + 1;
+    unsigned int padded = n + 2 * radius_;
+    prefix_.resize(padded);
+    suffix_.resize(padded);
+
+    //running extreme from the start of each block of window cells
+    for (unsigned int k = 0; k < padded; ++k) {
+      unsigned char value = (k < radius_ || k >= n + radius_) ? pad : in[(k - radius_) * stride];
+      if (k % window == 0) {
+        prefix_[k] = value;
+      } else {
+        prefix_[k] = take_max ? std::max(prefix_[k - 1], value) : std::min(prefix_[k - 1], value);
+      }
+    }
+
+    //running extreme from the end of each block of window cells
+    for (unsigned int k = padded; k-- > 0;) {
+      unsigned char value = (k < radius_ || k >= n + radius_) ? pad : in[(k - radius_) * stride];
+      if (k % window == window - 1 || k == padded - 1) {
+        suffix_[k] = value;
+      } else {
+        suffix_[k] = take_max ? std::max(suffix_[k + 1], value) : std::min(suffix_[k + 1], value);
+      }
+    }
+
+    //any window of this size spans at most two blocks
+    for (unsigned int i = 0; i < n; ++i) {
+      out[i * stride] = take_max ? std::max(suffix_[i], prefix_[i + 2 * radius_])
+                                 : std::min(suffix_[i], prefix_[i + 2 * radius_]);
+    }
+  }
+
+  size_t CostBoundsGrid::getMemoryUsage() const {
+    return vectorBytes(max_cost_) + vectorBytes(min_cost_) + vectorBytes(max_rows_) + vectorBytes(min_rows_) + vectorBytes(prefix_) + vectorBytes(suffix_);
+  }
+
+};
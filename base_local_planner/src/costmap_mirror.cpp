@@ -0,0 +1,177 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the Willow Garage nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <base_local_planner/costmap_mirror.h>
+#include <costmap_2d/cost_values.h>
+#include <ros/console.h>
+
+#include <cstring>
+#include <algorithm>
+
+namespace base_local_planner {
+
+  CostmapMirror::CostmapMirror() : changed_(false), resized_(false),
+    changed_x0_(0), changed_y0_(0), changed_x1_(0), changed_y1_(0), revision_(0) {}
+
+  void CostmapMirror::setMap(unsigned int size_x, unsigned int size_y, double resolution,
+      double origin_x, double origin_y, const unsigned char* costs) {
+    boost::recursive_mutex::scoped_lock lock(*costmap_.getMutex());
+    ++revision_;
+    if (size_x != costmap_.getSizeInCellsX() || size_y != costmap_.getSizeInCellsY() ||
+        resolution != costmap_.getResolution() || origin_x != costmap_.getOriginX() || origin_y != costmap_.getOriginY()) {
+      costmap_.resizeMap(size_x, size_y, resolution, origin_x, origin_y);
+      resized_ = true;
+      //bounds from before are in cells of the old map
+      changed_ = false;
+      if (size_x == 0 || size_y == 0) {
+        return;
+      }
+      memcpy(costmap_.getCharMap(), costs, size_x * size_y);
+      markChanged(0, 0, size_x - 1, size_y - 1);
+      return;
+    }
+
+    //costmap_2d publishes the whole map again when it moves, so often only a small part of it differs
+    unsigned char* map = costmap_.getCharMap();
+    for (unsigned int y = 0; y < size_y; ++y) {
+      unsigned int row = y * size_x;
+      if (memcmp(map + row, costs + row, size_x) == 0) {
+        continue;
+      }
+      unsigned int x0 = 0, x1 = size_x - 1;
+      while (map[row + x0] == costs[row + x0]) {
+        ++x0;
+      }
+      while (map[row + x1] == costs[row + x1]) {
+        --x1;
+      }
+      memcpy(map + row + x0, costs + row + x0, x1 - x0 + 1);
+      markChanged(x0, y, x1, y);
+    }
+  }
+
+  bool CostmapMirror::applyPatch(int x0, int y0, unsigned int width, unsigned int height, const unsigned char* costs) {
+    boost::recursive_mutex::scoped_lock lock(*costmap_.getMutex());
+    ++revision_;
+    //clip the patch to the map
+    int size_x = costmap_.getSizeInCellsX(), size_y = costmap_.getSizeInCellsY();
+    int start_x = std::max(x0, 0), start_y = std::max(y0, 0);
+    int end_x = std::min(x0 + (int) width, size_x), end_y = std::min(y0 + (int) height, size_y);
+    if (start_x >= end_x || start_y >= end_y) {
+      return false;
+    }
+
+    unsigned char* map = costmap_.getCharMap();
+    for (int y = start_y; y < end_y; ++y) {
+      memcpy(map + y * size_x + start_x, costs + (y - y0) * width + (start_x - x0), end_x - start_x);
+    }
+    markChanged(start_x, start_y, end_x - 1, end_y - 1);
+    return true;
+  }
+
+  void CostmapMirror::setMap(const nav_msgs::OccupancyGrid& map) {
+    unsigned int size = map.info.width * map.info.height;
+    if (map.data.size() != size) {
+      ROS_ERROR("The mirrored map has %u cells, but %u costs", size, (unsigned int) map.data.size());
+      return;
+    }
+    costs_.resize(size);
+    for (unsigned int i = 0; i < size; ++i) {
+      costs_[i] = occupancyToCost(map.data[i]);
+    }
+    setMap(map.info.width, map.info.height, map.info.resolution,
+        map.info.origin.position.x, map.info.origin.position.y, costs_.empty() ? NULL : &costs_[0]);
+  }
+
+  bool CostmapMirror::applyUpdate(const map_msgs::OccupancyGridUpdate& update) {
+    unsigned int size = update.width * update.height;
+    if (update.data.size() != size || size == 0) {
+      ROS_ERROR("The map update has %u cells, but %u costs", size, (unsigned int) update.data.size());
+      return false;
+    }
+    costs_.resize(size);
+    for (unsigned int i = 0; i < size; ++i) {
+      costs_[i] = occupancyToCost(update.data[i]);
+    }
+    return applyPatch(update.x, update.y, update.width, update.height, &costs_[0]);
+  }
+
+  bool CostmapMirror::takeChanges(unsigned int& x0, unsigned int& y0, unsigned int& x1, unsigned int& y1, bool& resized) {
+    boost::recursive_mutex::scoped_lock lock(*costmap_.getMutex());
+    resized = resized_;
+    if (!changed_) {
+      return false;
+    }
+    x0 = changed_x0_;
+    y0 = changed_y0_;
+    x1 = changed_x1_;
+    y1 = changed_y1_;
+    changed_ = false;
+    resized_ = false;
+    return true;
+  }
+
+  unsigned char CostmapMirror::occupancyToCost(int value) {
+    //costmap_2d translates 1..252 to 1 + 97 * (cost - 1) / 251, and keeps the special costs apart
+    if (value < 0) {
+      return costmap_2d::NO_INFORMATION;
+    }
+    if (value == 0) {
+      return costmap_2d::FREE_SPACE;
+    }
+    if (value == 99) {
+      return costmap_2d::INSCRIBED_INFLATED_OBSTACLE;
+    }
+    if (value >= 100) {
+      return costmap_2d::LETHAL_OBSTACLE;
+    }
+    return (unsigned char) std::min(costmap_2d::INSCRIBED_INFLATED_OBSTACLE - 1, 1 + (value * 251 - 1) / 97);
+  }
+
+  void CostmapMirror::markChanged(unsigned int x0, unsigned int y0, unsigned int x1, unsigned int y1) {
+    if (!changed_) {
+      changed_x0_ = x0;
+      changed_y0_ = y0;
+      changed_x1_ = x1;
+      changed_y1_ = y1;
+      changed_ = true;
+      return;
+    }
+    changed_x0_ = std::min(changed_x0_, x0);
+    changed_y0_ = std::min(changed_y0_, y0);
+    changed_x1_ = std::max(changed_x1_, x1);
+    changed_y1_ = std::max(changed_y1_, y1);
+  }
+
+};
@@ -106,6 +106,23 @@ namespace base_local_planner {
 
   }
 
+  double CostmapModel::outlineCost(unsigned int cell_x, unsigned int cell_y, const FootprintOutline& outline) const {
+    //the whole outline is on the map if its bounds are, the outline polygon check fails for a vertex off the map too
+    if((int) cell_x + outline.min_dx < 0 || (int) cell_y + outline.min_dy < 0 ||
+        (int) cell_x + outline.max_dx >= (int) costmap_.getSizeInCellsX() ||
+        (int) cell_y + outline.max_dy >= (int) costmap_.getSizeInCellsY())
+      return -1.0;
+
+    unsigned char footprint_cost = 0;
+    for(unsigned int i = 0; i < outline.dx.size(); ++i){
+      unsigned char cost = costmap_.getCost(cell_x + outline.dx[i], cell_y + outline.dy[i]);
+      if(cost == LETHAL_OBSTACLE || cost == NO_INFORMATION)
+        return -1.0;
+      footprint_cost = std::max(cost, footprint_cost);
+    }
+    return footprint_cost;
+  }
+
   //calculate the cost of a ray-traced line
   double CostmapModel::lineCost(int x0, int x1, int y0, int y1) const {
     double line_cost = 0.0;
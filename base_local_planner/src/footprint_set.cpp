@@ -0,0 +1,163 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the Willow Garage nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+#include <base_local_planner/footprint_set.h>
+#include <base_local_planner/cost_bounds_grid.h>
+#include <base_local_planner/line_iterator.h>
+#include <base_local_planner/memory_usage.h>
+#include <costmap_2d/footprint.h>
+
+#include <cmath>
+#include <set>
+#include <utility>
+#include <algorithm>
+
+namespace base_local_planner {
+
+  FootprintSet::FootprintSet(const std::vector<geometry_msgs::Point>& footprint, double resolution, unsigned int heading_bins)
+    : footprint_(footprint), inscribed_radius_(0.0), circumscribed_radius_(0.0), resolution_(resolution),
+      cell_radius_(CostBoundsGrid::footprintRadius(footprint, resolution)) {
+    costmap_2d::calculateMinAndMaxDistances(footprint_, inscribed_radius_, circumscribed_radius_);
+
+    //a point robot is checked at its center cell only, there is no outline to tabulate
+    if (heading_bins == 0 || footprint_.size() < 3) {
+      return;
+    }
+    outlines_.resize(heading_bins);
+    double bin_width = 2.0 * M_PI / heading_bins;
+    for (unsigned int i = 0; i < heading_bins; ++i) {
+      buildOutline((i - 0.5) * bin_width, (i + 0.5) * bin_width, outlines_[i]);
+    }
+  }
+
+  const FootprintOutline& FootprintSet::getOutline(double theta) const {
+    double bins = outlines_.size();
+    double turns = theta / (2.0 * M_PI);
+    int bin = (int) floor((turns - floor(turns)) * bins + 0.5);
+    return outlines_[bin % outlines_.size()];
+  }
+
+  //a little slack for the rounding of the world coordinates the polygon check starts from
+  static const double CELL_SLACK = 1e-6;
+
+  //the cells a vertex coordinate can fall into, within bound of a cells from the robot center and the center anywhere in its cell
+  static void nearCellRange(double a, double a_bound, int& min_cell, int& max_cell) {
+    min_cell = (int) floor(a - a_bound - CELL_SLACK);
+    max_cell = (int) floor(a + a_bound + CELL_SLACK) + 1;
+  }
+
+  //the cells the other end of an edge d cells long can fall into, given the cell of the first end
+  static void farCellRange(int near_cell, double a, double a_bound, double d, double d_bound, int& min_cell, int& max_cell) {
+    //the center and the first vertex lie within the near cell, which narrows where the edge can start
+    double min_start = std::max((double) near_cell, a - a_bound);
+    double max_start = std::min(near_cell + 1.0, a + a_bound + 1.0);
+    min_cell = (int) floor(min_start + d - d_bound - CELL_SLACK);
+    max_cell = (int) floor(max_start + d + d_bound + CELL_SLACK);
+  }
+
+  void FootprintSet::buildOutline(double min_theta, double max_theta, FootprintOutline& outline) const {
+    //with the robot center at a fraction f of its cell, a vertex a cells from it lands in cell floor(f + a)... over a part
+    //of the heading range the vertices move by no more than their distance times the angle, so rasterizing every pair
+    //of cells the ends of an edge can fall into covers every pose, the parts only keep the pairs few
+    typedef std::pair<std::pair<int, int>, std::pair<int, int> > CellPair;
+    int theta_steps = std::max(1, (int) ceil((max_theta - min_theta) * cell_radius_ / 0.1));
+    double half_step = 0.5 * (max_theta - min_theta) / theta_steps;
+    std::set<CellPair> edges;
+    for (int t = 0; t < theta_steps; ++t) {
+      double theta = min_theta + (2 * t + 1) * half_step;
+      double cos_th = cos(theta);
+      double sin_th = sin(theta);
+      for (unsigned int i = 0; i < footprint_.size(); ++i) {
+        const geometry_msgs::Point& p0 = footprint_[i];
+        const geometry_msgs::Point& p1 = footprint_[(i + 1) % footprint_.size()];
+        double ax = (p0.x * cos_th - p0.y * sin_th) / resolution_;
+        double ay = (p0.x * sin_th + p0.y * cos_th) / resolution_;
+        double dx = ((p1.x - p0.x) * cos_th - (p1.y - p0.y) * sin_th) / resolution_;
+        double dy = ((p1.x - p0.x) * sin_th + (p1.y - p0.y) * cos_th) / resolution_;
+        double a_bound = hypot(p0.x, p0.y) / resolution_ * half_step;
+        double d_bound = hypot(p1.x - p0.x, p1.y - p0.y) / resolution_ * half_step;
+
+        int min_x0, max_x0, min_y0, max_y0;
+        nearCellRange(ax, a_bound, min_x0, max_x0);
+        nearCellRange(ay, a_bound, min_y0, max_y0);
+        for (int x0 = min_x0; x0 <= max_x0; ++x0) {
+          int min_x1, max_x1;
+          farCellRange(x0, ax, a_bound, dx, d_bound, min_x1, max_x1);
+          for (int y0 = min_y0; y0 <= max_y0; ++y0) {
+            int min_y1, max_y1;
+            farCellRange(y0, ay, a_bound, dy, d_bound, min_y1, max_y1);
+            for (int x1 = min_x1; x1 <= max_x1; ++x1) {
+              for (int y1 = min_y1; y1 <= max_y1; ++y1) {
+                edges.insert(std::make_pair(std::make_pair(x0, y0), std::make_pair(x1, y1)));
+              }
+            }
+          }
+        }
+      }
+    }
+
+    std::set<std::pair<int, int> > cells;
+    for (std::set<CellPair>::const_iterator it = edges.begin(); it != edges.end(); ++it) {
+      for (LineIterator line(it->first.first, it->first.second, it->second.first, it->second.second); line.isValid(); line.advance()) {
+        cells.insert(std::make_pair(line.getX(), line.getY()));
+      }
+    }
+
+    outline.dx.reserve(cells.size());
+    outline.dy.reserve(cells.size());
+    for (std::set<std::pair<int, int> >::const_iterator it = cells.begin(); it != cells.end(); ++it) {
+      outline.dx.push_back(it->first);
+      outline.dy.push_back(it->second);
+    }
+    outline.min_dx = *std::min_element(outline.dx.begin(), outline.dx.end());
+    outline.max_dx = *std::max_element(outline.dx.begin(), outline.dx.end());
+    outline.min_dy = *std::min_element(outline.dy.begin(), outline.dy.end());
+    outline.max_dy = *std::max_element(outline.dy.begin(), outline.dy.end());
+  }
+
+  unsigned int FootprintSet::getCellRadius(double resolution) const {
+    if (resolution == resolution_) {
+      return cell_radius_;
+    }
+    return CostBoundsGrid::footprintRadius(footprint_, resolution);
+  }
+
+  size_t FootprintSet::getMemoryUsage() const {
+    size_t bytes = vectorBytes(footprint_) + vectorBytes(outlines_);
+    for (unsigned int i = 0; i < outlines_.size(); ++i) {
+      bytes += vectorBytes(outlines_[i].dx) + vectorBytes(outlines_[i].dy);
+    }
+    return bytes;
+  }
+
+};
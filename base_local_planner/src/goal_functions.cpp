@@ -66,12 +66,13 @@ namespace base_local_planner {
     pub.publish(gui_path);
   }
 
-  void prunePlan(const tf::Stamped<tf::Pose>& global_pose, std::vector<geometry_msgs::PoseStamped>& plan, std::vector<geometry_msgs::PoseStamped>& global_plan){
-    ROS_ASSERT(global_plan.size() >= plan.size());
-    std::vector<geometry_msgs::PoseStamped>::iterator it = plan.begin();
-    std::vector<geometry_msgs::PoseStamped>::iterator global_it = global_plan.begin();
-    while(it != plan.end()){
-      const geometry_msgs::PoseStamped& w = *it;
+  /**
+   * @brief  Number of poses at the start of a plan that are too far from the robot to be kept
+   */
+  static unsigned int countPrunedPoses(const tf::Stamped<tf::Pose>& global_pose, const std::vector<geometry_msgs::PoseStamped>& plan) {
+    unsigned int pruned = 0;
+    while(pruned < plan.size()){
+      const geometry_msgs::PoseStamped& w = plan[pruned];
       // Fixed error bound of 2 meters for now. Can reduce to a portion of the map size or based on the resolution
       double x_diff = global_pose.getOrigin().x() - w.pose.position.x;
       double y_diff = global_pose.getOrigin().y() - w.pose.position.y;
@@ -80,22 +81,43 @@ namespace base_local_planner {
         ROS_DEBUG("Nearest waypoint to <%f, %f> is <%f, %f>\n", global_pose.getOrigin().x(), global_pose.getOrigin().y(), w.pose.position.x, w.pose.position.y);
         break;
       }
-      it = plan.erase(it);
-      global_it = global_plan.erase(global_it);
+      ++pruned;
     }
+    return pruned;
   }
 
-  bool transformGlobalPlan(
+  void prunePlan(const tf::Stamped<tf::Pose>& global_pose, std::vector<geometry_msgs::PoseStamped>& plan, std::vector<geometry_msgs::PoseStamped>& global_plan){
+    ROS_ASSERT(global_plan.size() >= plan.size());
+    //erase the pruned poses at once, erasing them one by one moves the rest of the plan every time
+    unsigned int pruned = countPrunedPoses(global_pose, plan);
+    plan.erase(plan.begin(), plan.begin() + pruned);
+    global_plan.erase(global_plan.begin(), global_plan.begin() + pruned);
+  }
+
+  void prunePlan(const tf::Stamped<tf::Pose>& global_pose, std::vector<geometry_msgs::PoseStamped>& plan, SharedPlan& global_plan){
+    ROS_ASSERT(global_plan.size() >= plan.size());
+    unsigned int pruned = countPrunedPoses(global_pose, plan);
+    plan.erase(plan.begin(), plan.begin() + pruned);
+    global_plan.advance(pruned);
+  }
+
+  /**
+   * @brief  Shared by the overloads of transformGlobalPlan, PlanT is a std::vector of poses or a SharedPlan
+   */
+  template <class PlanT>
+  static bool transformPlanWindow(
       const tf::TransformListener& tf,
-      const std::vector<geometry_msgs::PoseStamped>& global_plan,
+      const PlanT& global_plan,
       const tf::Stamped<tf::Pose>& global_pose,
       const costmap_2d::Costmap2D& costmap,
       const std::string& global_frame,
       std::vector<geometry_msgs::PoseStamped>& transformed_plan){
-    transformed_plan.clear();
+    //the poses already in the output are overwritten rather than freed, so their frame ids keep their storage
+    unsigned int num_transformed = 0;
 
     if (global_plan.empty()) {
       ROS_ERROR("Received plan with zero length");
+      transformed_plan.clear();
       return false;
     }
 
@@ -134,7 +156,6 @@ namespace base_local_planner {
       }
 
       tf::Stamped<tf::Pose> tf_pose;
-      geometry_msgs::PoseStamped newer_pose;
 
       //now we'll transform until points are outside of our distance threshold
       while(i < (unsigned int)global_plan.size() && sq_dist <= sq_dist_threshold) {
@@ -143,9 +164,11 @@ namespace base_local_planner {
         tf_pose.setData(plan_to_global_transform * tf_pose);
         tf_pose.stamp_ = plan_to_global_transform.stamp_;
         tf_pose.frame_id_ = global_frame;
-        poseStampedTFToMsg(tf_pose, newer_pose);
-
-        transformed_plan.push_back(newer_pose);
+        if (num_transformed == transformed_plan.size()) {
+          transformed_plan.push_back(geometry_msgs::PoseStamped());
+        }
+        poseStampedTFToMsg(tf_pose, transformed_plan[num_transformed]);
+        ++num_transformed;
 
         double x_diff = robot_pose.getOrigin().x() - global_plan[i].pose.position.x;
         double y_diff = robot_pose.getOrigin().y() - global_plan[i].pose.position.y;
@@ -153,13 +176,16 @@ namespace base_local_planner {
 
         ++i;
       }
+      transformed_plan.resize(num_transformed);
     }
     catch(tf::LookupException& ex) {
       ROS_ERROR("No Transform available Error: %s\n", ex.what());
+      transformed_plan.clear();
       return false;
     }
     catch(tf::ConnectivityException& ex) {
       ROS_ERROR("Connectivity Error: %s\n", ex.what());
+      transformed_plan.clear();
       return false;
     }
     catch(tf::ExtrapolationException& ex) {
@@ -167,14 +193,39 @@ namespace base_local_planner {
       if (!global_plan.empty())
         ROS_ERROR("Global Frame: %s Plan Frame size %d: %s\n", global_frame.c_str(), (unsigned int)global_plan.size(), global_plan[0].header.frame_id.c_str());
 
+      transformed_plan.clear();
       return false;
     }
 
     return true;
   }
 
-  bool getGoalPose(const tf::TransformListener& tf,
+  bool transformGlobalPlan(
+      const tf::TransformListener& tf,
       const std::vector<geometry_msgs::PoseStamped>& global_plan,
+      const tf::Stamped<tf::Pose>& global_pose,
+      const costmap_2d::Costmap2D& costmap,
+      const std::string& global_frame,
+      std::vector<geometry_msgs::PoseStamped>& transformed_plan){
+    return transformPlanWindow(tf, global_plan, global_pose, costmap, global_frame, transformed_plan);
+  }
+
+  bool transformGlobalPlan(
+      const tf::TransformListener& tf,
+      const SharedPlan& global_plan,
+      const tf::Stamped<tf::Pose>& global_pose,
+      const costmap_2d::Costmap2D& costmap,
+      const std::string& global_frame,
+      std::vector<geometry_msgs::PoseStamped>& transformed_plan){
+    return transformPlanWindow(tf, global_plan, global_pose, costmap, global_frame, transformed_plan);
+  }
+
+  /**
+   * @brief  Shared by the overloads of getGoalPose, PlanT is a std::vector of poses or a SharedPlan
+   */
+  template <class PlanT>
+  static bool transformPlanGoal(const tf::TransformListener& tf,
+      const PlanT& global_plan,
       const std::string& global_frame, tf::Stamped<tf::Pose>& goal_pose) {
     if (global_plan.empty())
     {
@@ -216,6 +267,18 @@ namespace base_local_planner {
     return true;
   }
 
+  bool getGoalPose(const tf::TransformListener& tf,
+      const std::vector<geometry_msgs::PoseStamped>& global_plan,
+      const std::string& global_frame, tf::Stamped<tf::Pose>& goal_pose) {
+    return transformPlanGoal(tf, global_plan, global_frame, goal_pose);
+  }
+
+  bool getGoalPose(const tf::TransformListener& tf,
+      const SharedPlan& global_plan,
+      const std::string& global_frame, tf::Stamped<tf::Pose>& goal_pose) {
+    return transformPlanGoal(tf, global_plan, global_frame, goal_pose);
+  }
+
   bool isGoalReached(const tf::TransformListener& tf,
       const std::vector<geometry_msgs::PoseStamped>& global_plan,
       const costmap_2d::Costmap2D& costmap __attribute__((unused)),
@@ -36,7 +36,7 @@ LatchedStopRotateController::~LatchedStopRotateController() {}
  */
 bool LatchedStopRotateController::isPositionReached(LocalPlannerUtil* planner_util,
     tf::Stamped<tf::Pose> global_pose) {
-  double xy_goal_tolerance = planner_util->getCurrentLimits().xy_goal_tolerance;
+  double xy_goal_tolerance = planner_util->getLimitsSnapshot()->xy_goal_tolerance;
 
   //we assume the global goal is the last point in the global plan
   tf::Stamped<tf::Pose> goal_pose;
@@ -64,9 +64,8 @@ bool LatchedStopRotateController::isPositionReached(LocalPlannerUtil* planner_ut
 bool LatchedStopRotateController::isGoalReached(LocalPlannerUtil* planner_util,
     OdometryHelperRos& odom_helper,
     tf::Stamped<tf::Pose> global_pose) {
-  double xy_goal_tolerance = planner_util->getCurrentLimits().xy_goal_tolerance;
-  double rot_stopped_vel = planner_util->getCurrentLimits().rot_stopped_vel;
-  double trans_stopped_vel = planner_util->getCurrentLimits().trans_stopped_vel;
+  //one consistent set of limits for the whole check
+  boost::shared_ptr<const LocalPlannerLimits> limits = planner_util->getLimitsSnapshot();
 
   //copy over the odometry information
   nav_msgs::Odometry base_odom;
@@ -81,11 +80,9 @@ bool LatchedStopRotateController::isGoalReached(LocalPlannerUtil* planner_util,
   double goal_x = goal_pose.getOrigin().getX();
   double goal_y = goal_pose.getOrigin().getY();
 
-  base_local_planner::LocalPlannerLimits limits = planner_util->getCurrentLimits();
-
   //check to see if we've reached the goal position
   if ((latch_xy_goal_tolerance_ && xy_tolerance_latch_) ||
-      base_local_planner::getGoalPositionDistance(global_pose, goal_x, goal_y) <= xy_goal_tolerance) {
+      base_local_planner::getGoalPositionDistance(global_pose, goal_x, goal_y) <= limits->xy_goal_tolerance) {
     //if the user wants to latch goal tolerance, if we ever reach the goal location, we'll
     //just rotate in place
     if (latch_xy_goal_tolerance_ && ! xy_tolerance_latch_) {
@@ -95,9 +92,9 @@ bool LatchedStopRotateController::isGoalReached(LocalPlannerUtil* planner_util,
     double goal_th = tf::getYaw(goal_pose.getRotation());
     double angle = base_local_planner::getGoalOrientationAngleDifference(global_pose, goal_th);
     //check to see if the goal orientation has been reached
-    if (fabs(angle) <= limits.yaw_goal_tolerance) {
+    if (fabs(angle) <= limits->yaw_goal_tolerance) {
       //make sure that we're actually stopped before returning success
-      if (base_local_planner::stopped(base_odom, rot_stopped_vel, trans_stopped_vel)) {
+      if (base_local_planner::stopped(base_odom, limits->rot_stopped_vel, limits->trans_stopped_vel)) {
         return true;
       }
     }
@@ -150,7 +147,7 @@ bool LatchedStopRotateController::rotateToGoal(
     geometry_msgs::Twist& cmd_vel,
     Eigen::Vector3f acc_lim,
     double sim_period,
-    base_local_planner::LocalPlannerLimits& limits,
+    const base_local_planner::LocalPlannerLimits& limits,
     boost::function<bool (Eigen::Vector3f pos,
                           Eigen::Vector3f vel,
                           Eigen::Vector3f vel_samples)> obstacle_check) {
@@ -210,7 +207,8 @@ bool LatchedStopRotateController::computeVelocityCommandsStopRotate(geometry_msg
     return false;
   }
 
-  base_local_planner::LocalPlannerLimits limits = planner_util->getCurrentLimits();
+  boost::shared_ptr<const LocalPlannerLimits> limits_snapshot = planner_util->getLimitsSnapshot();
+  const base_local_planner::LocalPlannerLimits& limits = *limits_snapshot;
 
   //if the user wants to latch goal tolerance, if we ever reach the goal location, we'll
   //just rotate in place
@@ -0,0 +1,68 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the Willow Garage nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+#include <base_local_planner/latency_histogram.h>
+
+#include <algorithm>
+
+namespace base_local_planner {
+
+  LatencyHistogram::LatencyHistogram(const std::string& name, double first_bound, unsigned int num_buckets)
+    : name_(name) {
+    num_buckets = std::max(num_buckets, 1u);
+    double bound = first_bound;
+    for (unsigned int i = 0; i + 1 < num_buckets; ++i) {
+      bounds_.push_back(bound);
+      bound *= 2.0;
+    }
+    reset();
+  }
+
+  void LatencyHistogram::addSample(double seconds) {
+    seconds = std::max(seconds, 0.0);
+    //the first bucket whose bound is not below the age, or the unbounded last one
+    unsigned int bucket = std::lower_bound(bounds_.begin(), bounds_.end(), seconds) - bounds_.begin();
+    ++counts_[bucket];
+    last_ = seconds;
+    max_ = std::max(max_, seconds);
+    ++num_samples_;
+  }
+
+  void LatencyHistogram::reset() {
+    counts_.assign(bounds_.size() + 1, 0);
+    last_ = 0.0;
+    max_ = 0.0;
+    num_samples_ = 0;
+  }
+
+};
@@ -66,8 +66,9 @@ void LocalPlannerUtil::reconfigureCB(LocalPlannerLimits &config, bool restore_de
     default_limits_ = config;
     setup_ = true;
   }
+  boost::shared_ptr<const LocalPlannerLimits> limits(new LocalPlannerLimits(config));
   boost::mutex::scoped_lock l(limits_configuration_mutex_);
-  limits_ = LocalPlannerLimits(config);
+  limits_ = limits;
 }
 
 costmap_2d::Costmap2D* LocalPlannerUtil::getCostmap() {
@@ -75,17 +76,60 @@ costmap_2d::Costmap2D* LocalPlannerUtil::getCostmap() {
 }
 
 LocalPlannerLimits LocalPlannerUtil::getCurrentLimits() {
+  return *getLimitsSnapshot();
+}
+
+boost::shared_ptr<const LocalPlannerLimits> LocalPlannerUtil::getLimitsSnapshot() {
   boost::mutex::scoped_lock l(limits_configuration_mutex_);
   return limits_;
 }
 
 
 bool LocalPlannerUtil::getGoal(tf::Stamped<tf::Pose>& goal_pose) {
+  if (global_plan_.empty()) {
+    ROS_ERROR("Received plan with zero length");
+    return false;
+  }
   //we assume the global goal is the last point in the global plan
-  return base_local_planner::getGoalPose(*tf_,
-        global_plan_,
-        global_frame_,
-        goal_pose);
+  const geometry_msgs::PoseStamped& plan_goal_pose = global_plan_.back();
+
+  //a goal in the global frame needs no transform, otherwise the transform may have moved
+  ros::Time transform_stamp;
+  if (plan_goal_pose.header.frame_id != global_frame_ &&
+      tf_->getLatestCommonTime(global_frame_, plan_goal_pose.header.frame_id, transform_stamp, NULL) != tf::NO_ERROR) {
+    transform_stamp = ros::Time();
+  }
+
+  if (goal_pose_valid_ && transform_stamp == goal_transform_stamp_) {
+    goal_pose = goal_pose_;
+    return true;
+  }
+
+  if (goal_pose_valid_) {
+    //the latest transform is available already, no need to wait for it
+    try {
+      tf::StampedTransform transform;
+      tf_->lookupTransform(global_frame_, ros::Time(),
+          plan_goal_pose.header.frame_id, plan_goal_pose.header.stamp,
+          plan_goal_pose.header.frame_id, transform);
+      tf::poseStampedMsgToTF(plan_goal_pose, goal_pose_);
+      goal_pose_.setData(transform * goal_pose_);
+      goal_pose_.stamp_ = transform.stamp_;
+      goal_pose_.frame_id_ = global_frame_;
+    }
+    catch (tf::TransformException& ex) {
+      //keep the goal of the previous transform, rather than losing it for a cycle
+      ROS_WARN_THROTTLE(1.0, "Could not update the goal pose, using the previous one: %s", ex.what());
+    }
+  } else if (base_local_planner::getGoalPose(*tf_, global_plan_, global_frame_, goal_pose_)) {
+    goal_pose_valid_ = true;
+  } else {
+    return false;
+  }
+
+  goal_transform_stamp_ = transform_stamp;
+  goal_pose = goal_pose_;
+  return true;
 }
 
 bool LocalPlannerUtil::setPlan(const std::vector<geometry_msgs::PoseStamped>& orig_global_plan) {
@@ -94,10 +138,9 @@ bool LocalPlannerUtil::setPlan(const std::vector<geometry_msgs::PoseStamped>& or
     return false;
   }
 
-  //reset the global plan
-  global_plan_.clear();
-
-  global_plan_ = orig_global_plan;
+  //reset the global plan, releasing the previous one
+  global_plan_ = SharedPlan(orig_global_plan);
+  goal_pose_valid_ = false;
 
   return true;
 }
@@ -116,7 +159,7 @@ bool LocalPlannerUtil::getLocalPlan(tf::Stamped<tf::Pose>& global_pose, std::vec
   }
 
   //now we'll prune the plan based on the position of the robot
-  if(limits_.prune_plan) {
+  if(getLimitsSnapshot()->prune_plan) {
     base_local_planner::prunePlan(global_pose, transformed_plan, global_plan_);
   }
   return true;
@@ -33,17 +33,29 @@
  *********************************************************************/
 #include <base_local_planner/map_grid.h>
 #include <costmap_2d/cost_values.h>
+#include <base_local_planner/memory_usage.h>
+#include <algorithm>
+#include <limits>
+#include <utility>
 using namespace std;
 
 namespace base_local_planner{
 
+  static bool compareTargetDist(const MapCell* a, const MapCell* b){
+    return a->target_dist < b->target_dist;
+  }
+
+  const unsigned int MapGrid::DISTANCE_UNITS;
+
   MapGrid::MapGrid()
-    : size_x_(0), size_y_(0)
+    : size_x_(0), size_y_(0),
+      roi_x0_(0), roi_y0_(0), roi_x1_(0), roi_y1_(0), coarse_graph_(NULL), cost_weight_(0.0)
   {
   }
 
   MapGrid::MapGrid(unsigned int size_x, unsigned int size_y) 
-    : size_x_(size_x), size_y_(size_y)
+    : size_x_(size_x), size_y_(size_y),
+      roi_x0_(0), roi_y0_(0), roi_x1_(0), roi_y1_(0), coarse_graph_(NULL), cost_weight_(0.0)
   {
     commonInit();
   }
@@ -52,6 +64,13 @@ namespace base_local_planner{
     size_y_ = mg.size_y_;
     size_x_ = mg.size_x_;
     map_ = mg.map_;
+    roi_x0_ = mg.roi_x0_;
+    roi_y0_ = mg.roi_y0_;
+    roi_x1_ = mg.roi_x1_;
+    roi_y1_ = mg.roi_y1_;
+    coarse_graph_ = mg.coarse_graph_;
+    cost_weight_ = mg.cost_weight_;
+    step_costs_ = mg.step_costs_;
   }
 
   void MapGrid::commonInit(){
@@ -78,6 +97,13 @@ namespace base_local_planner{
     size_y_ = mg.size_y_;
     size_x_ = mg.size_x_;
     map_ = mg.map_;
+    roi_x0_ = mg.roi_x0_;
+    roi_y0_ = mg.roi_y0_;
+    roi_x1_ = mg.roi_x1_;
+    roi_y1_ = mg.roi_y1_;
+    coarse_graph_ = mg.coarse_graph_;
+    cost_weight_ = mg.cost_weight_;
+    step_costs_ = mg.step_costs_;
     return *this;
   }
 
@@ -104,11 +130,7 @@ namespace base_local_planner{
       const costmap_2d::Costmap2D& costmap){
 
     //if the cell is an obstacle set the max path distance
-    unsigned char cost = costmap.getCost(check_cell->cx, check_cell->cy);
-    if(! getCell(check_cell->cx, check_cell->cy).within_robot &&
-        (cost == costmap_2d::LETHAL_OBSTACLE ||
-         cost == costmap_2d::INSCRIBED_INFLATED_OBSTACLE ||
-         cost == costmap_2d::NO_INFORMATION)){
+    if(isObstacle(check_cell->cx, check_cell->cy, costmap)){
       check_cell->target_dist = obstacleCosts();
       return false;
     }
@@ -204,7 +226,7 @@ namespace base_local_planner{
       return;
     }
 
-    computeTargetDistance(path_dist_queue, costmap);
+    computeDistances(path_dist_queue, costmap);
   }
 
   //mark the point of the costmap as local goal where global_plan first leaves the area (or its last point)
@@ -248,21 +270,36 @@ namespace base_local_planner{
       path_dist_queue.push(&current);
     }
 
-    computeTargetDistance(path_dist_queue, costmap);
+    computeDistances(path_dist_queue, costmap);
   }
 
 
 
   void MapGrid::computeTargetDistance(queue<MapCell*>& dist_queue, const costmap_2d::Costmap2D& costmap){
+    propagateDistance(dist_queue, std::vector<MapCell*>(), costmap);
+  }
+
+  void MapGrid::propagateDistance(queue<MapCell*>& dist_queue, const std::vector<MapCell*>& sources,
+      const costmap_2d::Costmap2D& costmap){
+    if(cost_weight_ > 0.0){
+      propagateWeightedDistance(dist_queue, sources, costmap);
+      return;
+    }
+
     MapCell* current_cell;
     MapCell* check_cell;
     unsigned int last_col = size_x_ - 1;
     unsigned int last_row = size_y_ - 1;
-    while(!dist_queue.empty()){
-      current_cell = dist_queue.front();
-
-
-      dist_queue.pop();
+    unsigned int next_source = 0;
+    while(!dist_queue.empty() || next_source < sources.size()){
+      //expand cells by increasing distance, the queue stays sorted since each cell adds one to the smallest distance
+      if(next_source < sources.size() &&
+          (dist_queue.empty() || sources[next_source]->target_dist <= dist_queue.front()->target_dist)){
+        current_cell = sources[next_source++];
+      } else {
+        current_cell = dist_queue.front();
+        dist_queue.pop();
+      }
 
       if(current_cell->cx > 0){
         check_cell = current_cell - 1;
@@ -307,4 +344,203 @@ namespace base_local_planner{
     }
   }
 
+  void MapGrid::setCostWeight(double weight){
+    weight = std::max(weight, 0.0);
+    if(weight == cost_weight_ && !step_costs_.empty())
+      return;
+    cost_weight_ = weight;
+
+    //the obstacle costs never get expanded into, unless the robot stands on them, so they step like the highest other cost
+    unsigned int max_cost = costmap_2d::INSCRIBED_INFLATED_OBSTACLE - 1;
+    step_costs_.resize(256);
+    for(unsigned int cost = 0; cost < step_costs_.size(); ++cost){
+      double relative_cost = double(std::min(cost, max_cost)) / max_cost;
+      step_costs_[cost] = DISTANCE_UNITS + (unsigned int) (DISTANCE_UNITS * weight * relative_cost + 0.5);
+    }
+  }
+
+  inline void MapGrid::relaxWeightedCell(MapCell* check_cell, unsigned int dist, const unsigned char* costs, unsigned int& pending){
+    //expanded cells, and the cells outside of the region of interest, are final
+    if(check_cell->target_mark)
+      return;
+
+    size_t index = check_cell - &map_[0];
+    unsigned char cost = costs[index];
+    if(!check_cell->within_robot &&
+        (cost == costmap_2d::LETHAL_OBSTACLE || cost == costmap_2d::INSCRIBED_INFLATED_OBSTACLE || cost == costmap_2d::NO_INFORMATION)){
+      check_cell->target_mark = true;
+      check_cell->target_dist = obstacleCosts();
+      return;
+    }
+
+    unsigned int new_dist = dist + step_costs_[cost];
+    if(new_dist < weighted_dist_[index]){
+      weighted_dist_[index] = new_dist;
+      buckets_[new_dist % buckets_.size()].push_back(check_cell);
+      ++pending;
+    }
+  }
+
+  void MapGrid::propagateWeightedDistance(queue<MapCell*>& dist_queue, const std::vector<MapCell*>& sources,
+      const costmap_2d::Costmap2D& costmap){
+    const unsigned char* costs = costmap.getCharMap();
+    if(map_.empty() || costs == NULL)
+      return;
+
+    //every pending distance is within one step of the distance being expanded
+    unsigned int max_step = *std::max_element(step_costs_.begin(), step_costs_.end());
+    buckets_.resize(max_step + 1);
+    for(unsigned int i = 0; i < buckets_.size(); ++i)
+      buckets_[i].clear();
+    weighted_dist_.assign(map_.size(), std::numeric_limits<unsigned int>::max());
+
+    unsigned int pending = 0;
+    while(!dist_queue.empty()){
+      MapCell* cell = dist_queue.front();
+      dist_queue.pop();
+      weighted_dist_[cell - &map_[0]] = 0;
+      buckets_[0].push_back(cell);
+      ++pending;
+    }
+
+    unsigned int last_col = size_x_ - 1;
+    unsigned int last_row = size_y_ - 1;
+    unsigned int next_source = 0;
+    unsigned int dist = 0;
+    while(pending > 0 || next_source < sources.size()){
+      //the sources are sorted, they join the ring once their distance fits into it
+      if(pending == 0)
+        dist = std::max(dist, (unsigned int) (sources[next_source]->target_dist * DISTANCE_UNITS + 0.5));
+      while(next_source < sources.size()){
+        MapCell* source = sources[next_source];
+        unsigned int source_dist = (unsigned int) (source->target_dist * DISTANCE_UNITS + 0.5);
+        if(source_dist > dist + max_step)
+          break;
+        ++next_source;
+        size_t index = source - &map_[0];
+        if(source_dist < weighted_dist_[index]){
+          weighted_dist_[index] = source_dist;
+          buckets_[source_dist % buckets_.size()].push_back(source);
+          ++pending;
+        }
+      }
+
+      //steps are at least one unit long, so expanding a bucket never adds to it
+      std::vector<MapCell*>& bucket = buckets_[dist % buckets_.size()];
+      for(unsigned int i = 0; i < bucket.size(); ++i){
+        --pending;
+        MapCell* current_cell = bucket[i];
+        if(weighted_dist_[current_cell - &map_[0]] != dist)
+          continue;
+        current_cell->target_mark = true;
+        //heavy weights can carry a distance past the obstacle costs, the cell has to stay reachable
+        current_cell->target_dist = std::min(double(dist) / DISTANCE_UNITS, obstacleCosts() - 1.0 / DISTANCE_UNITS);
+
+        if(current_cell->cx > 0)
+          relaxWeightedCell(current_cell - 1, dist, costs, pending);
+        if(current_cell->cx < last_col)
+          relaxWeightedCell(current_cell + 1, dist, costs, pending);
+        if(current_cell->cy > 0)
+          relaxWeightedCell(current_cell - size_x_, dist, costs, pending);
+        if(current_cell->cy < last_row)
+          relaxWeightedCell(current_cell + size_x_, dist, costs, pending);
+      }
+      bucket.clear();
+      ++dist;
+    }
+  }
+
+  void MapGrid::setRegionOfInterest(unsigned int x0, unsigned int y0, unsigned int x1, unsigned int y1, const CoarseGraph* coarse_graph){
+    roi_x0_ = x0;
+    roi_y0_ = y0;
+    roi_x1_ = x1;
+    roi_y1_ = y1;
+    coarse_graph_ = coarse_graph;
+  }
+
+  void MapGrid::computeDistances(queue<MapCell*>& dist_queue, const costmap_2d::Costmap2D& costmap){
+    //a region covering the whole map gains nothing from the coarse graph
+    if(coarse_graph_ == NULL || coarse_graph_->getFactor() <= 1 || size_x_ == 0 || size_y_ == 0 ||
+        coarse_graph_->size_x_ != size_x_ || coarse_graph_->size_y_ != size_y_ ||
+        (roi_x0_ == 0 && roi_y0_ == 0 && roi_x1_ >= size_x_ - 1 && roi_y1_ >= size_y_ - 1)){
+      computeTargetDistance(dist_queue, costmap);
+      return;
+    }
+    computeTargetDistanceMultiResolution(dist_queue, costmap);
+  }
+
+  void MapGrid::computeTargetDistanceMultiResolution(queue<MapCell*>& dist_queue, const costmap_2d::Costmap2D& costmap){
+    const CoarseGraph& graph = *coarse_graph_;
+    unsigned int k = graph.getFactor();
+    unsigned int unreachable = std::numeric_limits<unsigned int>::max();
+    unsigned int x0 = std::min(roi_x0_, size_x_ - 1), x1 = std::min(roi_x1_, size_x_ - 1);
+    unsigned int y0 = std::min(roi_y0_, size_y_ - 1), y1 = std::min(roi_y1_, size_y_ - 1);
+
+    //wavefront on the coarse graph, starting from every node holding an initial cell
+    coarse_dist_.assign(graph.getNumNodes(), unreachable);
+    queue<unsigned int> coarse_queue;
+    queue<MapCell*> fine_queue;
+    while(!dist_queue.empty()){
+      MapCell* cell = dist_queue.front();
+      dist_queue.pop();
+      unsigned int node = graph.getNode(cell->cx, cell->cy);
+      if(node != CoarseGraph::NO_NODE && coarse_dist_[node] != 0){
+        coarse_dist_[node] = 0;
+        coarse_queue.push(node);
+      }
+      //initial cells inside the region also start the full resolution wavefront
+      if(cell->cx >= x0 && cell->cx <= x1 && cell->cy >= y0 && cell->cy <= y1){
+        fine_queue.push(cell);
+      }
+    }
+    while(!coarse_queue.empty()){
+      unsigned int node = coarse_queue.front();
+      coarse_queue.pop();
+      for(unsigned int l = graph.linkStart(node); l < graph.linkStart(node + 1); ++l){
+        unsigned int next = graph.link(l);
+        if(coarse_dist_[next] == unreachable){
+          coarse_dist_[next] = coarse_dist_[node] + 1;
+          coarse_queue.push(next);
+        }
+      }
+    }
+
+    //cells outside the region take the coarse distance, scaled back to cells
+    coarse_sources_.clear();
+    for(unsigned int y = 0; y < size_y_; ++y){
+      for(unsigned int x = 0; x < size_x_; ++x){
+        if(x >= x0 && x <= x1 && y >= y0 && y <= y1){
+          continue;
+        }
+        MapCell& cell = getCell(x, y);
+        unsigned int node = graph.getNode(x, y);
+        if(cell.target_mark){
+          //an initial cell, already at distance 0
+        } else if(node == CoarseGraph::NO_NODE){
+          cell.target_dist = obstacleCosts();
+        } else if(coarse_dist_[node] != unreachable){
+          cell.target_dist = double(coarse_dist_[node]) * k;
+        }
+        cell.target_mark = true;
+
+        //the reachable cells bordering the region seed the full resolution wavefront inside of it
+        bool borders_region = (x + 1 >= x0 && x <= x1 + 1 && y + 1 >= y0 && y <= y1 + 1);
+        if(borders_region && cell.target_dist < obstacleCosts()){
+          coarse_sources_.push_back(&cell);
+        }
+      }
+    }
+    std::sort(coarse_sources_.begin(), coarse_sources_.end(), compareTargetDist);
+
+    propagateDistance(fine_queue, coarse_sources_, costmap);
+  }
+
+  size_t MapGrid::getMemoryUsage() const {
+    size_t bytes = vectorBytes(map_) + vectorBytes(coarse_dist_) + vectorBytes(coarse_sources_) +
+      vectorBytes(step_costs_) + vectorBytes(weighted_dist_) + vectorBytes(buckets_);
+    for(unsigned int i = 0; i < buckets_.size(); ++i)
+      bytes += vectorBytes(buckets_[i]);
+    return bytes;
+  }
+
 };
@@ -0,0 +1,103 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the Willow Garage nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <base_local_planner/memory_usage.h>
+
+#ifdef BASE_LOCAL_PLANNER_COUNT_ALLOCATIONS
+#include <cstdlib>
+#include <new>
+
+//dynamic exception specifications are deprecated since C++11
+#if __cplusplus >= 201103L
+#define THROWS_BAD_ALLOC
+#define THROWS_NOTHING noexcept
+#else
+#define THROWS_BAD_ALLOC throw(std::bad_alloc)
+#define THROWS_NOTHING throw()
+#endif
+
+namespace {
+  uint64_t allocation_count = 0;
+  uint64_t allocation_bytes = 0;
+
+  void* countedAlloc(size_t size) {
+    __sync_fetch_and_add(&allocation_count, 1);
+    __sync_fetch_and_add(&allocation_bytes, size);
+    //malloc(0) may return NULL, operator new may not
+    void* ptr = malloc(size ? size : 1);
+    if (ptr == NULL) {
+      throw std::bad_alloc();
+    }
+    return ptr;
+  }
+};
+
+void* operator new(size_t size) THROWS_BAD_ALLOC {
+  return countedAlloc(size);
+}
+
+void* operator new[](size_t size) THROWS_BAD_ALLOC {
+  return countedAlloc(size);
+}
+
+void operator delete(void* ptr) THROWS_NOTHING {
+  free(ptr);
+}
+
+void operator delete[](void* ptr) THROWS_NOTHING {
+  free(ptr);
+}
+#endif
+
+namespace base_local_planner {
+
+  bool allocationsCounted() {
+#ifdef BASE_LOCAL_PLANNER_COUNT_ALLOCATIONS
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  void getAllocationCount(uint64_t& count, uint64_t& bytes) {
+#ifdef BASE_LOCAL_PLANNER_COUNT_ALLOCATIONS
+    count = __sync_fetch_and_add(&allocation_count, 0);
+    bytes = __sync_fetch_and_add(&allocation_bytes, 0);
+#else
+    count = 0;
+    bytes = 0;
+#endif
+  }
+
+};
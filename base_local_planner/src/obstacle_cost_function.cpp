@@ -72,8 +72,6 @@ bool ObstacleCostFunction::prepare() {
 }
 
 double ObstacleCostFunction::scoreTrajectory(Trajectory &traj) {
-  double cost = 0;
-  double scale = getScalingFactor(traj, scaling_speed_, max_trans_vel_, max_scaling_factor_);
   double px, py, pth;
   if (footprint_spec_.size() == 0) {
     // Bug, should never happen
@@ -81,22 +79,45 @@ double ObstacleCostFunction::scoreTrajectory(Trajectory &traj) {
     return -9;
   }
 
+  beginStream(traj);
   for (unsigned int i = 0; i < traj.getPointsSize(); ++i) {
     traj.getPoint(i, px, py, pth);
-    double f_cost = footprintCost(px, py, pth,
-        scale, footprint_spec_,
-        costmap_, world_model_);
-
+    double f_cost = scorePose(traj, px, py, pth);
     if(f_cost < 0){
         return f_cost;
     }
+  }
+  return endStream(traj);
+}
+
+void ObstacleCostFunction::beginStream(Trajectory &traj) {
+  stream_scale_ = getScalingFactor(traj, scaling_speed_, max_trans_vel_, max_scaling_factor_);
+  stream_cost_ = 0;
+}
+
+double ObstacleCostFunction::scorePose(Trajectory &traj, double x, double y, double th) {
+  if (footprint_spec_.size() == 0) {
+    // Bug, should never happen
+    ROS_ERROR("Footprint spec is empty, maybe missing call to setFootprint?");
+    return -9;
+  }
+  double f_cost = footprintCost(x, y, th,
+      stream_scale_, footprint_spec_,
+      costmap_, world_model_);
 
-    if(sum_scores_)
-        cost +=  f_cost;
-    else
-        cost = f_cost;
+  if(f_cost < 0){
+      return f_cost;
   }
-  return cost;
+
+  if(sum_scores_)
+      stream_cost_ +=  f_cost;
+  else
+      stream_cost_ = f_cost;
+  return f_cost;
+}
+
+double ObstacleCostFunction::endStream(Trajectory &traj) {
+  return stream_cost_;
 }
 
 double ObstacleCostFunction::getScalingFactor(Trajectory &traj, double scaling_speed, double max_trans_vel, double max_scaling_factor) {
@@ -50,6 +50,7 @@ void OdometryHelperRos::odomCallback(const nav_msgs::Odometry::ConstPtr& msg) {
   base_odom_.twist.twist.linear.x = msg->twist.twist.linear.x;
   base_odom_.twist.twist.linear.y = msg->twist.twist.linear.y;
   base_odom_.twist.twist.angular.z = msg->twist.twist.angular.z;
+  base_odom_.header.stamp = msg->header.stamp;
   base_odom_.child_frame_id = msg->child_frame_id;
 //  ROS_DEBUG_NAMED("dwa_local_planner", "In the odometry callback with velocity values: (%.2f, %.2f, %.2f)",
 //      base_odom_.twist.twist.linear.x, base_odom_.twist.twist.linear.y, base_odom_.twist.twist.angular.z);
@@ -72,9 +73,10 @@ void OdometryHelperRos::getRobotVel(tf::Stamped<tf::Pose>& robot_vel) {
     global_vel.angular.z = base_odom_.twist.twist.angular.z;
 
     robot_vel.frame_id_ = base_odom_.child_frame_id;
+    //the time the velocity was measured at, so callers can tell how old it is
+    robot_vel.stamp_ = base_odom_.header.stamp;
   }
   robot_vel.setData(tf::Transform(tf::createQuaternionFromYaw(global_vel.angular.z), tf::Vector3(global_vel.linear.x, global_vel.linear.y, 0)));
-  robot_vel.stamp_ = ros::Time();
 }
 
 void OdometryHelperRos::setOdomTopic(std::string odom_topic)
@@ -36,6 +36,7 @@
 *********************************************************************/
 
 #include <base_local_planner/point_grid.h>
+#include <base_local_planner/memory_usage.h>
 #include <ros/console.h>
 #include <sys/time.h>
 #include <math.h>
@@ -476,6 +477,95 @@ PointGrid::PointGrid(double size_x, double size_y, double resolution, geometry_m
       return false;
   }
 
+  void PointGrid::updateWorld(const std::vector<geometry_msgs::Point>& footprint, const sensor_msgs::LaserScan& scan,
+      const geometry_msgs::Point& sensor_origin, double sensor_yaw){
+    unsigned int num_beams = scan.ranges.size();
+    if(num_beams < 2 || scan.angle_increment <= 0.0)
+      return;
+
+    beams_.update(scan.angle_min, scan.angle_increment, num_beams);
+    double cos_yaw = cos(sensor_yaw);
+    double sin_yaw = sin(sensor_yaw);
+
+    //a single pass over the ranges finds how far each beam saw free space, the hits to insert, and the bounds of both
+    clear_ranges_.resize(num_beams);
+    scan_hits_.clear();
+    geometry_msgs::Point lower_left = sensor_origin, upper_right = sensor_origin;
+    for(unsigned int i = 0; i < num_beams; ++i){
+      float range = scan.ranges[i];
+      double clear_range = 0.0;
+      bool hit = false;
+      //readings past the maximum range, infinite ones included, saw no obstacle up to it... NaNs and short readings saw nothing
+      if(range >= scan.range_min && range < scan.range_max){
+        clear_range = range;
+        hit = true;
+      }
+      else if(range >= scan.range_max)
+        clear_range = scan.range_max;
+      clear_ranges_[i] = clear_range;
+
+      //rotate the beam of the table into the frame of the grid
+      double dir_x = beams_.cos(i) * cos_yaw - beams_.sin(i) * sin_yaw;
+      double dir_y = beams_.cos(i) * sin_yaw + beams_.sin(i) * cos_yaw;
+      double end_x = sensor_origin.x + clear_range * dir_x;
+      double end_y = sensor_origin.y + clear_range * dir_y;
+      lower_left.x = min((double)lower_left.x, end_x);
+      lower_left.y = min((double)lower_left.y, end_y);
+      upper_right.x = max((double)upper_right.x, end_x);
+      upper_right.y = max((double)upper_right.y, end_y);
+
+      if(hit && sensor_origin.z <= max_z_ && (double)range * range < sq_obstacle_range_){
+        pcl::PointXYZ pt;
+        pt.x = end_x;
+        pt.y = end_y;
+        pt.z = sensor_origin.z;
+        scan_hits_.push_back(pt);
+      }
+    }
+
+    //clear the points the scan sees through before inserting what it hit
+    getPointsInRange(lower_left, upper_right, points_);
+    for(unsigned int i = 0; i < points_.size(); ++i){
+      list<pcl::PointXYZ>* cell_points = points_[i];
+      if(cell_points != NULL){
+        list<pcl::PointXYZ>::iterator it = cell_points->begin();
+        while(it != cell_points->end()){
+          if(ptInScan(*it, scan, sensor_origin, sensor_yaw))
+            it = cell_points->erase(it);
+          else
+            it++;
+        }
+      }
+    }
+
+    for(unsigned int i = 0; i < scan_hits_.size(); ++i)
+      insert(scan_hits_[i]);
+
+    //remove the points that are in the footprint of the robot
+    removePointsInPolygon(footprint);
+  }
+
+  bool PointGrid::ptInScan(const pcl::PointXYZ& pt, const sensor_msgs::LaserScan& scan,
+      const geometry_msgs::Point& sensor_origin, double sensor_yaw){
+    double v_x = pt.x - sensor_origin.x;
+    double v_y = pt.y - sensor_origin.y;
+
+    //the angle of the point from the first beam, between 0 and 2PI
+    double vector_angle = atan2(v_y, v_x) - sensor_yaw - scan.angle_min;
+    vector_angle = fmod(vector_angle, 2 * M_PI);
+    if(vector_angle < 0)
+      vector_angle += 2 * M_PI;
+
+    //the point lies between this beam and the next one
+    unsigned int index = (unsigned int) (vector_angle / scan.angle_increment);
+    if(index + 1 >= clear_ranges_.size())
+      return false;
+
+    //the chord between the two beams comes no closer to the scanner than the shorter beam times the cosine of half the angle between them
+    double clear_range = min(clear_ranges_[index], clear_ranges_[index + 1]) * cos(scan.angle_increment / 2.0);
+    return v_x * v_x + v_y * v_y < clear_range * clear_range;
+  }
+
   void PointGrid::getPoints(pcl::PointCloud<pcl::PointXYZ>& cloud){
     for(unsigned int i = 0; i < cells_.size(); ++i){
       for(list<pcl::PointXYZ>::iterator it = cells_[i].begin(); it != cells_[i].end(); ++it){
@@ -484,6 +574,15 @@ PointGrid::PointGrid(double size_x, double size_y, double resolution, geometry_m
     }
   }
 
+  size_t PointGrid::getMemoryUsage(){
+    //every point sits in its own list node, next to the two links of the node
+    size_t num_points = 0;
+    for(unsigned int i = 0; i < cells_.size(); ++i)
+      num_points += cells_[i].size();
+    return vectorBytes(cells_) + num_points * (sizeof(pcl::PointXYZ) + 2 * sizeof(void*))
+      + vectorBytes(points_) + vectorBytes(clear_ranges_) + vectorBytes(scan_hits_) + 2 * beams_.size() * sizeof(double);
+  }
+
   void PointGrid::removePointsInPolygon(const std::vector<geometry_msgs::Point> poly){
     if(poly.size() == 0)
       return;
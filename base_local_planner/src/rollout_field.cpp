@@ -0,0 +1,88 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the Willow Garage nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+#include <base_local_planner/rollout_field.h>
+#include <costmap_2d/cost_values.h>
+#include <base_local_planner/memory_usage.h>
+
+namespace base_local_planner {
+
+  RolloutField::RolloutField() : size_x_(0), size_y_(0) {}
+
+  unsigned short RolloutField::quantise(double dist, double impossible_dist) {
+    if (dist >= impossible_dist) {
+      return IMPOSSIBLE_DIST;
+    }
+    double units = dist * MapGrid::DISTANCE_UNITS;
+    if (units >= MAX_DIST) {
+      return MAX_DIST;
+    }
+    //the wavefronts produce multiples of a unit, so this is exact below the saturation
+    return (unsigned short) (units + 0.5);
+  }
+
+  void RolloutField::update(const costmap_2d::Costmap2D& costmap, MapGrid& path_map, MapGrid& goal_map, double path_distance_max) {
+    size_x_ = costmap.getSizeInCellsX();
+    size_y_ = costmap.getSizeInCellsY();
+    cells_.resize(size_x_ * size_y_);
+
+    //anything at or above the obstacle cost is either an obstacle or unreachable
+    double path_impossible = path_map.obstacleCosts();
+    double goal_impossible = goal_map.obstacleCosts();
+
+    for (unsigned int y = 0; y < size_y_; ++y) {
+      for (unsigned int x = 0; x < size_x_; ++x) {
+        RolloutCell& cell = cells_[size_x_ * y + x];
+        double path_dist = path_map.getCell(x, y).target_dist;
+        cell.path_dist = quantise(path_dist, path_impossible);
+        cell.goal_dist = quantise(goal_map.getCell(x, y).target_dist, goal_impossible);
+        cell.cost = costmap.getCost(x, y);
+        cell.flags = 0;
+        if (path_distance_max > 0.0 && path_dist <= path_distance_max) {
+          cell.flags |= IN_TUBE;
+        }
+        if (cell.cost == costmap_2d::LETHAL_OBSTACLE) {
+          cell.flags |= LETHAL;
+        } else if (cell.cost == costmap_2d::NO_INFORMATION) {
+          cell.flags |= UNKNOWN;
+        }
+        cell.reserved = 0;
+      }
+    }
+  }
+
+  size_t RolloutField::getMemoryUsage() const {
+    return vectorBytes(cells_);
+  }
+
+};
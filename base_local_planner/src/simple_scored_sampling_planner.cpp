@@ -37,25 +37,76 @@
 
 #include <base_local_planner/simple_scored_sampling_planner.h>
 
+#include <algorithm>
+#include <boost/bind.hpp>
+
 #include <ros/console.h>
 
 namespace base_local_planner {
+
+  //runs as a task of the preparation group, each critic writes only its own flag
+  static void prepareCritic(TrajectoryCostFunction* critic, char* prepared) {
+    *prepared = critic->prepare();
+  }
   
-  SimpleScoredSamplingPlanner::SimpleScoredSamplingPlanner(std::vector<TrajectorySampleGenerator*> gen_list, std::vector<TrajectoryCostFunction*>& critics, int max_samples) {
+  SimpleScoredSamplingPlanner::SimpleScoredSamplingPlanner(std::vector<TrajectorySampleGenerator*> gen_list, std::vector<TrajectoryCostFunction*>& critics, int max_samples)
+    : trajectory_pool_(new TrajectoryPool()) {
     max_samples_ = max_samples;
     gen_list_ = gen_list;
     critics_ = critics;
+    for (std::vector<TrajectoryCostFunction*>::iterator critic = critics_.begin(); critic != critics_.end(); ++critic) {
+      if ((*critic)->isVelocityOnly()) {
+        velocity_critics_.push_back(*critic);
+      } else {
+        pose_critics_.push_back(*critic);
+        if ((*critic)->isStreaming()) {
+          pose_stream_.critics.push_back(*critic);
+        }
+      }
+    }
   }
 
-  double SimpleScoredSamplingPlanner::scoreTrajectory(Trajectory& traj, double best_traj_cost) {
-    double traj_cost = 0;
+  void SimpleScoredSamplingPlanner::PoseStreamScorer::startTrajectory(Trajectory &traj) {
+    stopped = false;
+    for (std::vector<TrajectoryCostFunction*>::iterator critic = critics.begin(); critic != critics.end(); ++critic) {
+      if ((*critic)->getScale() != 0) {
+        (*critic)->beginStream(traj);
+      }
+    }
+  }
+
+  bool SimpleScoredSamplingPlanner::PoseStreamScorer::poseAdded(Trajectory &traj, unsigned int index) {
+    double px, py, pth;
+    traj.getPoint(index, px, py, pth);
+    for (std::vector<TrajectoryCostFunction*>::iterator critic = critics.begin(); critic != critics.end(); ++critic) {
+      if ((*critic)->getScale() == 0) {
+        continue;
+      }
+      double cost = (*critic)->scorePose(traj, px, py, pth);
+      if (cost < 0) {
+        ROS_DEBUG("Velocity %.3lf, %.3lf, %.3lf discarded at pose %u with cost: %f", traj.xv_, traj.yv_, traj.thetav_, index, cost);
+        stopped = true;
+        stop_cost = cost;
+        return false;
+      }
+    }
+    return true;
+  }
+
+  double SimpleScoredSamplingPlanner::scoreWithCritics(std::vector<TrajectoryCostFunction*>& critics,
+      Trajectory& traj, double traj_cost, double best_traj_cost, bool streamed) {
     int gen_id = 0;
-    for(std::vector<TrajectoryCostFunction*>::iterator score_function = critics_.begin(); score_function != critics_.end(); ++score_function) {
+    for(std::vector<TrajectoryCostFunction*>::iterator score_function = critics.begin(); score_function != critics.end(); ++score_function) {
       TrajectoryCostFunction* score_function_p = *score_function;
       if (score_function_p->getScale() == 0) {
         continue;
       }
-      double cost = score_function_p->scoreTrajectory(traj);
+      double cost;
+      if (streamed && score_function_p->isStreaming()) {
+        cost = score_function_p->endStream(traj);
+      } else {
+        cost = score_function_p->scoreTrajectory(traj);
+      }
       if (cost < 0) {
         ROS_DEBUG("Velocity %.3lf, %.3lf, %.3lf discarded by cost function  %d with cost: %f", traj.xv_, traj.yv_, traj.thetav_, gen_id, cost);
         traj_cost = cost;
@@ -78,15 +129,42 @@ namespace base_local_planner {
     return traj_cost;
   }
 
+  double SimpleScoredSamplingPlanner::scoreVelocities(Trajectory& traj, double best_traj_cost) {
+    return scoreWithCritics(velocity_critics_, traj, 0, best_traj_cost);
+  }
+
+  double SimpleScoredSamplingPlanner::scoreTrajectory(Trajectory& traj, double best_traj_cost) {
+    // cheap velocity-only critics first, so their aborts spare the pose critics
+    double traj_cost = scoreVelocities(traj, best_traj_cost);
+    if (isHopeless(traj_cost, best_traj_cost)) {
+      return traj_cost;
+    }
+    return scoreWithCritics(pose_critics_, traj, traj_cost, best_traj_cost);
+  }
+
   bool SimpleScoredSamplingPlanner::findBestTrajectory(Trajectory& traj, std::vector<Trajectory>* all_explored) {
-    Trajectory loop_traj;
-    Trajectory best_traj;
+    // buffers from the pool keep their capacity across cycles, so this search does not allocate once warmed up
+    unsigned int max_points = 0;
+    for (std::vector<TrajectorySampleGenerator*>::iterator loop_gen = gen_list_.begin(); loop_gen != gen_list_.end(); ++loop_gen) {
+      max_points = std::max(max_points, (*loop_gen)->getMaxNumPoints());
+    }
+    PooledTrajectory loop_buffer(*trajectory_pool_, max_points);
+    PooledTrajectory best_buffer(*trajectory_pool_, max_points);
+    Trajectory& loop_traj = *loop_buffer;
+    Trajectory& best_traj = *best_buffer;
     double loop_traj_cost, best_traj_cost = -1;
     bool gen_success;
     int count, count_valid;
-    for (std::vector<TrajectoryCostFunction*>::iterator loop_critic = critics_.begin(); loop_critic != critics_.end(); ++loop_critic) {
-      TrajectoryCostFunction* loop_critic_p = *loop_critic;
-      if (loop_critic_p->prepare() == false) {
+    // map grid critics each run their own wavefront, so the preparations are worth running side by side
+    std::vector<char> prepared(critics_.size(), 0);
+    {
+      TaskGroup preparation(scheduler_.get(), TaskScheduler::CONTROL);
+      for (unsigned int i = 0; i < critics_.size(); ++i) {
+        preparation.run(boost::bind(&prepareCritic, critics_[i], &prepared[i]));
+      }
+    }
+    for (unsigned int i = 0; i < prepared.size(); ++i) {
+      if (!prepared[i]) {
         ROS_WARN("A scoring function failed to prepare");
         return false;
       }
@@ -97,12 +175,45 @@ namespace base_local_planner {
       count_valid = 0;
       TrajectorySampleGenerator* gen_ = *loop_gen;
       while (gen_->hasMoreTrajectories()) {
-        gen_success = gen_->nextTrajectory(loop_traj);
-        if (gen_success == false) {
-          // TODO use this for debugging
-          continue;
+        // when collecting all explored trajectories for debugging, every sample gets fully simulated
+        if (all_explored == NULL) {
+          bool velocities_scored = gen_->peekNextVelocities(loop_traj);
+          loop_traj_cost = 0;
+          if (velocities_scored) {
+            loop_traj_cost = scoreVelocities(loop_traj, best_traj_cost);
+            if (isHopeless(loop_traj_cost, best_traj_cost)) {
+              // rejected or hopeless on velocities alone, no need to simulate
+              gen_->skipTrajectory();
+              count++;
+              if (max_samples_ > 0 && count >= max_samples_) {
+                break;
+              }
+              continue;
+            }
+          }
+          pose_stream_.stopped = false;
+          gen_success = gen_->nextTrajectory(loop_traj, pose_stream_);
+          if (pose_stream_.stopped) {
+            // a streaming critic rejected a pose, the rest was not simulated
+            loop_traj_cost = pose_stream_.stop_cost;
+          } else if (gen_success == false) {
+            continue;
+          } else {
+            if ( ! velocities_scored) {
+              loop_traj_cost = scoreVelocities(loop_traj, best_traj_cost);
+            }
+            if ( ! isHopeless(loop_traj_cost, best_traj_cost)) {
+              loop_traj_cost = scoreWithCritics(pose_critics_, loop_traj, loop_traj_cost, best_traj_cost, true);
+            }
+          }
+        } else {
+          gen_success = gen_->nextTrajectory(loop_traj);
+          if (gen_success == false) {
+            // TODO use this for debugging
+            continue;
+          }
+          loop_traj_cost = scoreTrajectory(loop_traj, best_traj_cost);
         }
-        loop_traj_cost = scoreTrajectory(loop_traj, best_traj_cost);
         if (all_explored != NULL) {
           loop_traj.cost_ = loop_traj_cost;
           all_explored->push_back(loop_traj);
@@ -112,7 +223,8 @@ namespace base_local_planner {
           count_valid++;
           if (best_traj_cost < 0 || loop_traj_cost < best_traj_cost) {
             best_traj_cost = loop_traj_cost;
-            best_traj = loop_traj;
+            // loop_traj is overwritten by the next sample anyway
+            best_traj.swap(loop_traj);
           }
         }
         count++;
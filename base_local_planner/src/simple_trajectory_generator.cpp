@@ -38,6 +38,7 @@
 #include <base_local_planner/simple_trajectory_generator.h>
 
 #include <cmath>
+#include <algorithm>
 
 #include <base_local_planner/velocity_iterator.h>
 
@@ -173,6 +174,80 @@ bool SimpleTrajectoryGenerator::nextTrajectory(Trajectory &comp_traj) {
   return result;
 }
 
+/**
+ * Create the next sample trajectory, streaming its poses to observer
+ */
+bool SimpleTrajectoryGenerator::nextTrajectory(Trajectory &comp_traj, TrajectoryPoseObserver &observer) {
+  bool result = false;
+  if (hasMoreTrajectories()) {
+    if (generateTrajectory(
+        pos_,
+        vel_,
+        sample_params_[next_sample_index_],
+        comp_traj,
+        &observer)) {
+      result = true;
+    }
+  }
+  next_sample_index_++;
+  return result;
+}
+
+/**
+ * Fill in the velocities of the next sample, so velocity-only critics can
+ * judge it before it gets simulated
+ */
+bool SimpleTrajectoryGenerator::peekNextVelocities(Trajectory &traj) {
+  if ( ! hasMoreTrajectories()) {
+    return false;
+  }
+  const Eigen::Vector3f& sample_target_vel = sample_params_[next_sample_index_];
+  int num_steps = computeNumSteps(sample_target_vel);
+  if (num_steps <= 0) {
+    // generateTrajectory will reject this sample anyway
+    return false;
+  }
+  Eigen::Vector3f first_vel = computeFirstVelocities(sample_target_vel, vel_, sim_time_ / num_steps);
+  traj.xv_     = first_vel[0];
+  traj.yv_     = first_vel[1];
+  traj.thetav_ = first_vel[2];
+  return true;
+}
+
+void SimpleTrajectoryGenerator::skipTrajectory() {
+  next_sample_index_++;
+}
+
+unsigned int SimpleTrajectoryGenerator::getMaxNumPoints() {
+  int max_steps = 0;
+  for (unsigned int i = next_sample_index_; i < sample_params_.size(); ++i) {
+    max_steps = std::max(max_steps, computeNumSteps(sample_params_[i]));
+  }
+  return max_steps;
+}
+
+int SimpleTrajectoryGenerator::computeNumSteps(const Eigen::Vector3f& sample_target_vel) {
+  if (discretize_by_time_) {
+    return ceil(sim_time_ / sim_granularity_);
+  }
+  //compute the number of steps we must take along this trajectory to be "safe"
+  double vmag = hypot(sample_target_vel[0], sample_target_vel[1]);
+  double sim_time_distance = vmag * sim_time_; // the distance the robot would travel in sim_time if it did not change velocity
+  double sim_time_angle = fabs(sample_target_vel[2]) * sim_time_; // the angle the robot would rotate in sim_time
+  return ceil(std::max(sim_time_distance / sim_granularity_,
+      sim_time_angle    / angular_sim_granularity_));
+}
+
+Eigen::Vector3f SimpleTrajectoryGenerator::computeFirstVelocities(const Eigen::Vector3f& sample_target_vel,
+    const Eigen::Vector3f& vel, double dt) {
+  if (continued_acceleration_) {
+    // assuming the velocity of the first cycle is the one we want to store in the trajectory object
+    return computeNewVelocities(sample_target_vel, vel, limits_->getAccLimits(), dt);
+  }
+  // assuming sample_vel is our target velocity within acc limits for one timestep
+  return sample_target_vel;
+}
+
 /**
  * @param pos current position of robot
  * @param vel desired velocity for sampling
@@ -181,7 +256,8 @@ bool SimpleTrajectoryGenerator::generateTrajectory(
       Eigen::Vector3f pos,
       Eigen::Vector3f vel,
       Eigen::Vector3f sample_target_vel,
-      base_local_planner::Trajectory& traj) {
+      base_local_planner::Trajectory& traj,
+      TrajectoryPoseObserver* observer) {
   double vmag = hypot(sample_target_vel[0], sample_target_vel[1]);
   double eps = 1e-4;
   traj.cost_   = -1.0; // placed here in case we return early
@@ -199,35 +275,19 @@ bool SimpleTrajectoryGenerator::generateTrajectory(
     return false;
   }
 
-  int num_steps;
-  if (discretize_by_time_) {
-    num_steps = ceil(sim_time_ / sim_granularity_);
-  } else {
-    //compute the number of steps we must take along this trajectory to be "safe"
-    double sim_time_distance = vmag * sim_time_; // the distance the robot would travel in sim_time if it did not change velocity
-    double sim_time_angle = fabs(sample_target_vel[2]) * sim_time_; // the angle the robot would rotate in sim_time
-    num_steps =
-        ceil(std::max(sim_time_distance / sim_granularity_,
-            sim_time_angle    / angular_sim_granularity_));
-  }
+  int num_steps = computeNumSteps(sample_target_vel);
 
   //compute a timestep
   double dt = sim_time_ / num_steps;
   traj.time_delta_ = dt;
 
-  Eigen::Vector3f loop_vel;
-  if (continued_acceleration_) {
-    // assuming the velocity of the first cycle is the one we want to store in the trajectory object
-    loop_vel = computeNewVelocities(sample_target_vel, vel, limits_->getAccLimits(), dt);
-    traj.xv_     = loop_vel[0];
-    traj.yv_     = loop_vel[1];
-    traj.thetav_ = loop_vel[2];
-  } else {
-    // assuming sample_vel is our target velocity within acc limits for one timestep
-    loop_vel = sample_target_vel;
-    traj.xv_     = sample_target_vel[0];
-    traj.yv_     = sample_target_vel[1];
-    traj.thetav_ = sample_target_vel[2];
+  Eigen::Vector3f loop_vel = computeFirstVelocities(sample_target_vel, vel, dt);
+  traj.xv_     = loop_vel[0];
+  traj.yv_     = loop_vel[1];
+  traj.thetav_ = loop_vel[2];
+
+  if (observer != NULL) {
+    observer->startTrajectory(traj);
   }
 
   //simulate the trajectory and check for collisions, updating costs along the way
@@ -236,6 +296,11 @@ bool SimpleTrajectoryGenerator::generateTrajectory(
     //add the point to the trajectory so we can draw it later if we want
     traj.addPoint(pos[0], pos[1], pos[2]);
 
+    //let the observer check the pose before we spend time on the next one
+    if (observer != NULL && ! observer->poseAdded(traj, i)) {
+      return false;
+    }
+
     if (continued_acceleration_) {
       //calculate velocities
       loop_vel = computeNewVelocities(sample_target_vel, loop_vel, limits_->getAccLimits(), dt);
@@ -0,0 +1,276 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the Willow Garage nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <base_local_planner/sparse_voxel_grid.h>
+#include <base_local_planner/memory_usage.h>
+
+#include <cmath>
+#include <cfloat>
+#include <cstdlib>
+#include <algorithm>
+
+namespace base_local_planner {
+
+  const unsigned int SparseVoxelGrid::BRICK_SHIFT;
+  const unsigned int SparseVoxelGrid::BRICK_MASK;
+  const unsigned int SparseVoxelGrid::NO_BRICK;
+  const unsigned int SparseVoxelGrid::TOP_LAYER;
+
+  SparseVoxelGrid::SparseVoxelGrid(unsigned int size_x, unsigned int size_y, unsigned int size_z) :
+    size_x_(size_x), size_y_(size_y), size_z_(size_z), column_layers_(size_x * size_y, 0) {}
+
+  unsigned int SparseVoxelGrid::findBrick(uint64_t key) const {
+    boost::unordered_map<uint64_t, unsigned int>::const_iterator it = index_.find(key);
+    return it == index_.end() ? NO_BRICK : it->second;
+  }
+
+  bool SparseVoxelGrid::isEmpty(const Brick& brick) {
+    uint64_t bits = 0;
+    for (unsigned int i = 0; i <= BRICK_MASK; ++i) {
+      bits |= brick.rows[i];
+    }
+    return bits == 0;
+  }
+
+  void SparseVoxelGrid::releaseBrick(uint64_t key, unsigned int index) {
+    index_.erase(key);
+    free_bricks_.push_back(index);
+  }
+
+  void SparseVoxelGrid::markVoxel(unsigned int x, unsigned int y, unsigned int z) {
+    if (x >= size_x_ || y >= size_y_ || z >= size_z_) {
+      return;
+    }
+    uint64_t key = brickKey(x >> BRICK_SHIFT, y >> BRICK_SHIFT, z >> BRICK_SHIFT);
+    unsigned int index = findBrick(key);
+    if (index == NO_BRICK) {
+      //released bricks are empty already
+      if (free_bricks_.empty()) {
+        Brick brick = {{0}};
+        index = bricks_.size();
+        bricks_.push_back(brick);
+      } else {
+        index = free_bricks_.back();
+        free_bricks_.pop_back();
+      }
+      index_[key] = index;
+    }
+    bricks_[index].rows[y & BRICK_MASK] |= voxelBit(x, z);
+    column_layers_[y * size_x_ + x] |= layerBit(z >> BRICK_SHIFT);
+  }
+
+  void SparseVoxelGrid::updateColumnLayers(const Brick& brick, unsigned int x, unsigned int y, unsigned int z) {
+    //the top bit is shared by all layers above, it stays set rather than checking the others
+    if ((z >> BRICK_SHIFT) < TOP_LAYER && columnHeights(brick, x, y) == 0) {
+      column_layers_[y * size_x_ + x] &= ~layerBit(z >> BRICK_SHIFT);
+    }
+  }
+
+  void SparseVoxelGrid::clearVoxel(unsigned int x, unsigned int y, unsigned int z) {
+    if (x >= size_x_ || y >= size_y_ || z >= size_z_) {
+      return;
+    }
+    uint64_t key = brickKey(x >> BRICK_SHIFT, y >> BRICK_SHIFT, z >> BRICK_SHIFT);
+    unsigned int index = findBrick(key);
+    if (index == NO_BRICK) {
+      return;
+    }
+    bricks_[index].rows[y & BRICK_MASK] &= ~voxelBit(x, z);
+    updateColumnLayers(bricks_[index], x, y, z);
+    if (isEmpty(bricks_[index])) {
+      releaseBrick(key, index);
+    }
+  }
+
+  bool SparseVoxelGrid::getVoxel(unsigned int x, unsigned int y, unsigned int z) const {
+    if (x >= size_x_ || y >= size_y_ || z >= size_z_) {
+      return false;
+    }
+    unsigned int index = findBrick(brickKey(x >> BRICK_SHIFT, y >> BRICK_SHIFT, z >> BRICK_SHIFT));
+    return index != NO_BRICK && (bricks_[index].rows[y & BRICK_MASK] & voxelBit(x, z)) != 0;
+  }
+
+  bool SparseVoxelGrid::columnOccupied(unsigned int x, unsigned int y, unsigned int min_z, unsigned int max_z) const {
+    //nothing is known about the world outside the grid
+    if (x >= size_x_ || y >= size_y_) {
+      return true;
+    }
+    if (size_z_ == 0) {
+      return false;
+    }
+    max_z = std::min(max_z, size_z_ - 1);
+    if (min_z > max_z) {
+      return false;
+    }
+
+    //most columns have nothing marked in the range, they are rejected without touching the index
+    unsigned int min_bz = min_z >> BRICK_SHIFT, max_bz = max_z >> BRICK_SHIFT;
+    uint32_t range = (layerBit(max_bz) | (layerBit(max_bz) - 1)) & ~(layerBit(min_bz) - 1);
+    uint32_t layers = column_layers_[y * size_x_ + x] & range;
+    if (layers == 0) {
+      return false;
+    }
+
+    for (unsigned int bz = min_bz; bz <= max_bz; ++bz) {
+      if ((layers & layerBit(bz)) == 0) {
+        continue;
+      }
+      //a layer the range covers whole holds a marked voxel, unless its bit is the shared top one
+      if (bz != min_bz && bz != max_bz && bz < TOP_LAYER) {
+        return true;
+      }
+      unsigned int index = findBrick(brickKey(x >> BRICK_SHIFT, y >> BRICK_SHIFT, bz));
+      if (index == NO_BRICK) {
+        continue;
+      }
+      unsigned int low = bz == min_bz ? min_z & BRICK_MASK : 0;
+      unsigned int high = bz == max_bz ? max_z & BRICK_MASK : BRICK_MASK;
+      if (columnHeights(bricks_[index], x, y) & ((2u << high) - 1) & ~((1u << low) - 1)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void SparseVoxelGrid::clearVoxelLine(double x0, double y0, double z0, double x1, double y1, double z1) {
+    int x = (int) floor(x0), y = (int) floor(y0), z = (int) floor(z0);
+    int end_x = (int) floor(x1), end_y = (int) floor(y1), end_z = (int) floor(z1);
+    double dx = x1 - x0, dy = y1 - y0, dz = z1 - z0;
+    int step_x = dx > 0 ? 1 : -1, step_y = dy > 0 ? 1 : -1, step_z = dz > 0 ? 1 : -1;
+
+    //how far along the ray the next voxel boundary of each axis is, and how far apart the boundaries are
+    double t_max_x = dx != 0 ? (dx > 0 ? x + 1 - x0 : x0 - x) / fabs(dx) : DBL_MAX;
+    double t_max_y = dy != 0 ? (dy > 0 ? y + 1 - y0 : y0 - y) / fabs(dy) : DBL_MAX;
+    double t_max_z = dz != 0 ? (dz > 0 ? z + 1 - z0 : z0 - z) / fabs(dz) : DBL_MAX;
+    double t_delta_x = dx != 0 ? 1.0 / fabs(dx) : DBL_MAX;
+    double t_delta_y = dy != 0 ? 1.0 / fabs(dy) : DBL_MAX;
+    double t_delta_z = dz != 0 ? 1.0 / fabs(dz) : DBL_MAX;
+
+    //every step crosses one boundary, so the count bounds the walk whatever the rounding
+    unsigned int steps = abs(end_x - x) + abs(end_y - y) + abs(end_z - z);
+    uint64_t brick_key = 0;
+    unsigned int brick = NO_BRICK;
+    bool in_brick = false, cleared = false;
+    for (unsigned int i = 0; ; ++i) {
+      if (x >= 0 && y >= 0 && z >= 0 && x < (int) size_x_ && y < (int) size_y_ && z < (int) size_z_) {
+        uint64_t key = brickKey(x >> BRICK_SHIFT, y >> BRICK_SHIFT, z >> BRICK_SHIFT);
+        if (!in_brick || key != brick_key) {
+          if (cleared && isEmpty(bricks_[brick])) {
+            releaseBrick(brick_key, brick);
+          }
+          brick_key = key;
+          brick = findBrick(key);
+          in_brick = true;
+          cleared = false;
+        }
+        if (brick != NO_BRICK) {
+          bricks_[brick].rows[y & BRICK_MASK] &= ~voxelBit(x, z);
+          updateColumnLayers(bricks_[brick], x, y, z);
+          cleared = true;
+        }
+      }
+      if (i == steps) {
+        break;
+      }
+
+      if (t_max_x <= t_max_y && t_max_x <= t_max_z) {
+        x += step_x;
+        t_max_x += t_delta_x;
+      } else if (t_max_y <= t_max_z) {
+        y += step_y;
+        t_max_y += t_delta_y;
+      } else {
+        z += step_z;
+        t_max_z += t_delta_z;
+      }
+    }
+    if (cleared && isEmpty(bricks_[brick])) {
+      releaseBrick(brick_key, brick);
+    }
+  }
+
+  void SparseVoxelGrid::getMarkedVoxels(std::vector<VoxelCell>& cells) const {
+    cells.clear();
+    for (boost::unordered_map<uint64_t, unsigned int>::const_iterator it = index_.begin(); it != index_.end(); ++it) {
+      unsigned int bx = (unsigned int) (it->first & 0x1fffff) << BRICK_SHIFT;
+      unsigned int by = (unsigned int) ((it->first >> 21) & 0x1fffff) << BRICK_SHIFT;
+      unsigned int bz = (unsigned int) (it->first >> 42) << BRICK_SHIFT;
+      const Brick& brick = bricks_[it->second];
+      for (unsigned int row = 0; row <= BRICK_MASK; ++row) {
+        uint64_t bits = brick.rows[row];
+        for (unsigned int bit = 0; bits != 0; ++bit, bits >>= 1) {
+          if (bits & 1) {
+            VoxelCell cell;
+            cell.x = bx + (bit >> BRICK_SHIFT);
+            cell.y = by + row;
+            cell.z = bz + (bit & BRICK_MASK);
+            cells.push_back(cell);
+          }
+        }
+      }
+    }
+  }
+
+  void SparseVoxelGrid::reset() {
+    bricks_.clear();
+    free_bricks_.clear();
+    index_.clear();
+    std::fill(column_layers_.begin(), column_layers_.end(), 0);
+  }
+
+  void SparseVoxelGrid::shift(int dx, int dy) {
+    if (dx == 0 && dy == 0) {
+      return;
+    }
+    //the bricks are keyed by their cells, so the voxels are marked again at their new cells
+    std::vector<VoxelCell> cells;
+    getMarkedVoxels(cells);
+    reset();
+    for (unsigned int i = 0; i < cells.size(); ++i) {
+      int x = (int) cells[i].x - dx;
+      int y = (int) cells[i].y - dy;
+      if (x >= 0 && y >= 0) {
+        markVoxel(x, y, cells[i].z);
+      }
+    }
+  }
+
+  size_t SparseVoxelGrid::getMemoryUsage() const {
+    //a node of the index holds its entry and a link, the buckets one pointer each
+    size_t index_bytes = index_.bucket_count() * sizeof(void*) +
+      index_.size() * (sizeof(std::pair<const uint64_t, unsigned int>) + sizeof(void*));
+    return vectorBytes(bricks_) + vectorBytes(free_bricks_) + vectorBytes(column_layers_) + index_bytes;
+  }
+
+};
@@ -0,0 +1,258 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the Willow Garage nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <base_local_planner/task_scheduler.h>
+#include <boost/bind.hpp>
+#include <ros/console.h>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace base_local_planner {
+
+  TaskScheduler::TaskScheduler(unsigned int num_threads, uint64_t core_mask)
+    : core_mask_(core_mask), queued_(0), stop_(false), next_worker_(0) {
+    //all queues exist before the first worker looks for work in them
+    for (unsigned int i = 0; i < num_threads; ++i) {
+      workers_.push_back(new Worker());
+    }
+    for (unsigned int i = 0; i < num_threads; ++i) {
+      boost::thread* thread = threads_.create_thread(boost::bind(&TaskScheduler::workerLoop, this, i));
+#ifdef __linux__
+      if (core_mask_ != 0) {
+        cpu_set_t cores;
+        CPU_ZERO(&cores);
+        for (unsigned int core = 0; core < 64 && core < CPU_SETSIZE; ++core) {
+          if (core_mask_ & ((uint64_t) 1 << core)) {
+            CPU_SET(core, &cores);
+          }
+        }
+        if (pthread_setaffinity_np(thread->native_handle(), sizeof(cores), &cores) != 0) {
+          ROS_WARN("Could not restrict planner worker %u to the cores of mask 0x%llx", i, (unsigned long long) core_mask_);
+        }
+      }
+#else
+      (void) thread;
+#endif
+    }
+  }
+
+  TaskScheduler::~TaskScheduler() {
+    {
+      boost::mutex::scoped_lock lock(wake_mutex_);
+      stop_ = true;
+    }
+    wake_.notify_all();
+    threads_.join_all();
+    for (unsigned int i = 0; i < workers_.size(); ++i) {
+      delete workers_[i];
+    }
+  }
+
+  TaskScheduler::LaneStats TaskScheduler::getLaneStats(Lane lane) {
+    boost::mutex::scoped_lock lock(stats_mutex_);
+    return stats_[lane];
+  }
+
+  void TaskScheduler::submit(Lane lane, const Task& task) {
+    if (workers_.empty()) {
+      Task inline_task = task;
+      execute(lane, inline_task);
+      return;
+    }
+
+    unsigned int index;
+    {
+      boost::mutex::scoped_lock lock(wake_mutex_);
+      index = next_worker_;
+      next_worker_ = (next_worker_ + 1) % workers_.size();
+    }
+    {
+      boost::mutex::scoped_lock lock(workers_[index]->mutex);
+      workers_[index]->lanes[lane].push_back(task);
+    }
+    {
+      boost::mutex::scoped_lock lock(wake_mutex_);
+      ++queued_;
+    }
+    wake_.notify_one();
+  }
+
+  bool TaskScheduler::take(Lane lane, unsigned int first, Task& task) {
+    unsigned int num_workers = workers_.size();
+    for (unsigned int i = 0; i < num_workers; ++i) {
+      Worker* worker = workers_[(first + i) % num_workers];
+      {
+        boost::mutex::scoped_lock lock(worker->mutex);
+        std::deque<Task>& queue = worker->lanes[lane];
+        if (queue.empty()) {
+          continue;
+        }
+        //the owner takes what was queued first, thieves what was queued last
+        if (i == 0) {
+          task = queue.front();
+          queue.pop_front();
+        } else {
+          task = queue.back();
+          queue.pop_back();
+        }
+      }
+      boost::mutex::scoped_lock lock(wake_mutex_);
+      --queued_;
+      return true;
+    }
+    return false;
+  }
+
+  void TaskScheduler::execute(Lane lane, Task& task) {
+    ros::WallTime start = ros::WallTime::now();
+    bool cancelled;
+    {
+      boost::mutex::scoped_lock lock(task.group->mutex);
+      cancelled = task.group->cancelled;
+    }
+    if (!cancelled) {
+      task.function();
+    }
+    ros::WallTime end = ros::WallTime::now();
+
+    {
+      boost::mutex::scoped_lock lock(stats_mutex_);
+      if (cancelled) {
+        ++stats_[lane].cancelled;
+      } else {
+        ++stats_[lane].tasks;
+        stats_[lane].busy_time += (end - start).toSec();
+        stats_[lane].wait_time += (start - task.queued).toSec();
+      }
+    }
+
+    boost::mutex::scoped_lock lock(task.group->mutex);
+    if (--task.group->pending == 0) {
+      task.group->done.notify_all();
+    }
+  }
+
+  void TaskScheduler::workerLoop(unsigned int index) {
+    while (true) {
+      //control work first, also when it has to be stolen from another worker
+      Task task;
+      bool found = false;
+      for (unsigned int lane = 0; lane < NUM_LANES && !found; ++lane) {
+        if (take((Lane) lane, index, task)) {
+          execute((Lane) lane, task);
+          found = true;
+        }
+      }
+      if (found) {
+        continue;
+      }
+
+      boost::mutex::scoped_lock lock(wake_mutex_);
+      while (queued_ == 0 && !stop_) {
+        wake_.wait(lock);
+      }
+      if (queued_ == 0 && stop_) {
+        return;
+      }
+    }
+  }
+
+  TaskGroup::TaskGroup(TaskScheduler* scheduler, TaskScheduler::Lane lane)
+    : scheduler_(scheduler), lane_(lane), state_(new TaskScheduler::GroupState()) {}
+
+  TaskGroup::~TaskGroup() {
+    wait();
+  }
+
+  void TaskGroup::run(const boost::function<void ()>& function) {
+    if (scheduler_ == NULL) {
+      function();
+      return;
+    }
+
+    TaskScheduler::Task task;
+    task.function = function;
+    task.group = state_;
+    task.queued = ros::WallTime::now();
+    {
+      boost::mutex::scoped_lock lock(state_->mutex);
+      ++state_->pending;
+    }
+    scheduler_->submit(lane_, task);
+  }
+
+  void TaskGroup::wait() {
+    if (scheduler_ == NULL) {
+      return;
+    }
+
+    //help with the queued work of the lane, once none is left the tasks of this group are all running
+    while (true) {
+      {
+        boost::mutex::scoped_lock lock(state_->mutex);
+        if (state_->pending == 0) {
+          return;
+        }
+      }
+      TaskScheduler::Task task;
+      if (!scheduler_->take(lane_, 0, task)) {
+        break;
+      }
+      scheduler_->execute(lane_, task);
+    }
+
+    boost::mutex::scoped_lock lock(state_->mutex);
+    while (state_->pending > 0) {
+      state_->done.wait(lock);
+    }
+  }
+
+  void TaskGroup::cancel() {
+    if (scheduler_ == NULL) {
+      return;
+    }
+
+    {
+      boost::mutex::scoped_lock lock(state_->mutex);
+      state_->cancelled = true;
+    }
+    wait();
+    //the dropped tasks keep the old state, new ones start over
+    state_.reset(new TaskScheduler::GroupState());
+  }
+
+};
@@ -32,6 +32,9 @@
  *  POSSIBILITY OF SUCH DAMAGE.
  *********************************************************************/
 #include <base_local_planner/trajectory.h>
+#include <base_local_planner/memory_usage.h>
+
+#include <algorithm>
 
 namespace base_local_planner {
   Trajectory::Trajectory()
@@ -74,7 +77,31 @@ namespace base_local_planner {
     th = th_pts_.back();
   }
 
+  void Trajectory::reservePoints(unsigned int num_pts){
+    x_pts_.reserve(num_pts);
+    y_pts_.reserve(num_pts);
+    th_pts_.reserve(num_pts);
+  }
+
+  void Trajectory::swap(Trajectory& other){
+    std::swap(xv_, other.xv_);
+    std::swap(yv_, other.yv_);
+    std::swap(thetav_, other.thetav_);
+    std::swap(cost_, other.cost_);
+    std::swap(path_dist_traj_, other.path_dist_traj_);
+    std::swap(head_cost_traj_, other.head_cost_traj_);
+    std::swap(goal_cost_traj_, other.goal_cost_traj_);
+    std::swap(time_delta_, other.time_delta_);
+    x_pts_.swap(other.x_pts_);
+    y_pts_.swap(other.y_pts_);
+    th_pts_.swap(other.th_pts_);
+  }
+
   unsigned int Trajectory::getPointsSize() const {
     return x_pts_.size();
   }
+
+  size_t Trajectory::getMemoryUsage() const {
+    return vectorBytes(x_pts_) + vectorBytes(y_pts_) + vectorBytes(th_pts_);
+  }
 };
@@ -36,6 +36,8 @@
 *********************************************************************/
 
 #include <base_local_planner/trajectory_planner.h>
+#include <base_local_planner/costmap_model.h>
+#include <base_local_planner/memory_usage.h>
 #include <costmap_2d/footprint.h>
 #include <string>
 #include <sstream>
@@ -45,6 +47,7 @@
 
 
 #include <boost/algorithm/string.hpp>
+#include <boost/bind.hpp>
 
 #include <ros/console.h>
 
@@ -86,6 +89,35 @@ namespace base_local_planner{
       hdiff_scale_ = config.hdiff_scale;
       path_distance_max_ = config.path_distance_max;
 
+      coarse_grid_factor_ = config.coarse_grid_factor;
+      path_cost_weight_ = config.path_cost_weight;
+
+      blocked_cycles_ = config.blocked_cycles;
+      blocked_ = false;
+
+      latency_compensation_ = config.latency_compensation;
+      actuation_delay_ = config.actuation_delay;
+
+      //cycles that already started keep the scheduler they hold, the workers are joined when they release it
+      if (config.scheduler_threads != (int) scheduler_->getNumThreads() ||
+          (uint64_t) config.scheduler_core_mask != scheduler_->getCoreMask()) {
+        scheduler_.reset(new TaskScheduler(config.scheduler_threads, config.scheduler_core_mask));
+      }
+
+      //the gates share their thresholds, only the sample budgets differ per phase
+      SearchPhaseGate gate;
+      if (config.search_phase_gating) {
+        gate.max_cost = config.gate_max_cost;
+        gate.tube_margin = config.gate_tube_margin;
+        gate.min_progress = config.gate_min_progress;
+      }
+      const int phase_samples[NUM_SEARCH_PHASES] = {config.forward_phase_samples, config.strafe_phase_samples,
+          config.strafe_forward_phase_samples, config.rotate_phase_samples};
+      for (int i = 0; i < NUM_SEARCH_PHASES; ++i) {
+        search_gates_[i] = gate;
+        search_gates_[i].max_samples = phase_samples[i];
+      }
+
       if (meter_scoring_) {
         //if we use meter scoring, then we want to multiply the biases by the resolution of the costmap
         double resolution = costmap_.getResolution();
@@ -142,6 +174,9 @@ namespace base_local_planner{
 
       y_vels_ = y_vels;
 
+      //building the outline tables takes a while, the rollouts of a running cycle must not wait for it
+      l.unlock();
+      rebuildFootprints(config.footprint_heading_bins);
   }
 
   TrajectoryPlanner::TrajectoryPlanner(WorldModel& world_model,
@@ -163,7 +198,7 @@ namespace base_local_planner{
     : path_map_(costmap.getSizeInCellsX(), costmap.getSizeInCellsY()),
       goal_map_(costmap.getSizeInCellsX(), costmap.getSizeInCellsY()),
       costmap_(costmap),
-    world_model_(world_model), footprint_spec_(footprint_spec),
+    world_model_(world_model), footprint_(new FootprintSet(footprint_spec, costmap.getResolution())),
     sim_time_(sim_time), sim_granularity_(sim_granularity), angular_sim_granularity_(angular_sim_granularity),
     vx_samples_(vx_samples), vtheta_samples_(vtheta_samples),
     pdist_scale_(pdist_scale), gdist_scale_(gdist_scale), occdist_scale_(occdist_scale),
@@ -192,7 +227,26 @@ namespace base_local_planner{
     final_goal_position_valid_ = false;
 
 
-    costmap_2d::calculateMinAndMaxDistances(footprint_spec_, inscribed_radius_, circumscribed_radius_);
+    //there is no constructor argument for it, reconfigure sets it
+    vy_samples_ = vx_samples_;
+    coarse_grid_factor_ = 1;
+    path_cost_weight_ = 0.0;
+    cost_bounds_valid_ = false;
+    cost_bounds_limit_ = LETHAL_OBSTACLE;
+    costmap_mirror_ = NULL;
+    cost_bounds_synced_ = false;
+    rollout_field_valid_ = false;
+    corridors_active_ = false;
+    blocked_cycles_ = 0;
+    failed_searches_ = 0;
+    blocked_ = false;
+    latency_compensation_ = false;
+    actuation_delay_ = 0.0;
+    planning_latency_ = 0.0;
+    last_cmd_valid_ = false;
+    footprint_heading_bins_ = 0;
+    scheduler_.reset(new TaskScheduler());
+    costmap_world_model_ = dynamic_cast<CostmapModel*>(&world_model_) != NULL;
   }
 
   TrajectoryPlanner::~TrajectoryPlanner(){}
@@ -224,7 +278,7 @@ namespace base_local_planner{
       double vx_samp, double vy_samp, double vtheta_samp,
       double acc_x, double acc_y, double acc_theta,
       double impossible_cost,
-      Trajectory& traj) {
+      Trajectory& traj, bool sampled) {
 
     // make sure the configuration doesn't change mid run
     boost::mutex::scoped_lock l(configuration_mutex_);
@@ -239,22 +293,9 @@ namespace base_local_planner{
     vy_i = vy;
     vtheta_i = vtheta;
 
-    //compute the magnitude of the velocities
-    double vmag = hypot(vx_samp, vy_samp);
-
     traj.path_dist_traj_ = -2.0;
     //compute the number of steps we must take along this trajectory to be "safe"
-    int num_steps;
-    if(!heading_scoring_) {
-      num_steps = int(max((vmag * sim_time_) / sim_granularity_, fabs(vtheta_samp) / angular_sim_granularity_) + 0.5);
-    } else {
-      num_steps = int(sim_time_ / sim_granularity_ + 0.5);
-    }
-
-    //we at least want to take one step... even if we won't move, we want to score our current position
-    if(num_steps == 0) {
-      num_steps = 1;
-    }
+    int num_steps = computeNumSteps(vx_samp, vy_samp, vtheta_samp);
 
     double dt = sim_time_ / num_steps;
     double time = 0.0;
@@ -271,6 +312,7 @@ namespace base_local_planner{
     double goal_dist = 0.0;
     double occ_cost = 0.0;
     double heading_diff = 0.0;
+    bool plan_impossible = false;
 
     for(int i = 0; i < num_steps; ++i){
       //get map coordinates of a point
@@ -282,8 +324,23 @@ namespace base_local_planner{
         return;
       }
 
+      //everything this step reads about the cell, from a single record when the rollout field is built
+      const RolloutCell* field_cell = rollout_field_valid_ ? &rollout_field_(cell_x, cell_y) : NULL;
+      double cell_cost = field_cell != NULL ? field_cell->cost : costmap_.getCost(cell_x, cell_y);
+
       //check the point on the trajectory for legality
-      double footprint_cost = footprintCost(x_i, y_i, theta_i);
+      double footprint_cost;
+      unsigned char max_bound;
+      if(cost_bounds_valid_ && cost_bounds_.maxCost(cell_x, cell_y, max_bound) && max_bound < cost_bounds_limit_
+          && (occdist_scale_ == 0.0 || max_bound <= std::max(occ_cost, cell_cost))){
+        //the footprint is legal, and its exact cost could not raise the occupancy cost of the trajectory, or does not count
+        footprint_cost = 0.0;
+      } else if(cost_bounds_valid_ && cost_bounds_.minCost(cell_x, cell_y) >= LETHAL_OBSTACLE){
+        //every cell the footprint could touch is an obstacle
+        footprint_cost = -1.0;
+      } else {
+        footprint_cost = footprintCost(x_i, y_i, theta_i);
+      }
 
       //if the footprint hits an obstacle this trajectory is invalid
       if(footprint_cost < 0){
@@ -312,7 +369,7 @@ namespace base_local_planner{
         */
       }
 
-      occ_cost = std::max(std::max(occ_cost, footprint_cost), double(costmap_.getCost(cell_x, cell_y)));
+      occ_cost = std::max(std::max(occ_cost, footprint_cost), cell_cost);
 
       //do we want to follow blindly
       if (simple_attractor_) {
@@ -342,7 +399,12 @@ namespace base_local_planner{
         if (update_path_and_goal_distances) {
           //update path and goal distances
 
-          if(!heading_scoring_)
+          if(!heading_scoring_ && field_cell != NULL)
+          {
+            path_dist = RolloutField::distance(field_cell->path_dist, impossible_cost);
+            goal_dist = RolloutField::distance(field_cell->goal_dist, impossible_cost);
+          }
+          else if(!heading_scoring_)
           {
             path_dist = path_map_(cell_x, cell_y).target_dist;
             goal_dist = goal_map_(cell_x, cell_y).target_dist;
@@ -353,7 +415,11 @@ namespace base_local_planner{
 //            ROS_DEBUG("No path to goal with goal distance = %f, path_distance = %f and max cost = %f",
 //                goal_dist, path_dist, impossible_cost);
             traj.cost_ = -2.0;
-            return;
+            //the alternative plans may still be reachable along this trajectory
+            if(!corridors_active_){
+              return;
+            }
+            plan_impossible = true;
           }
           //ROS_INFO("path_dist %f",path_dist);
           double path_dist_internal = (double) path_dist;
@@ -399,6 +465,16 @@ namespace base_local_planner{
       time += dt;
     } // end for i < numsteps
 
+    if(corridors_active_){
+      if(sampled){
+        scoreCorridors(traj, occ_cost, impossible_cost);
+      }
+      if(plan_impossible){
+        traj.cost_ = -2.0;
+        return;
+      }
+    }
+
     //ROS_INFO("OccCost: %f, vx: %.2f, vy: %.2f, vtheta: %.2f", occ_cost, vx_samp, vy_samp, vtheta_samp);
     double cost;
     if (!heading_scoring_) {
@@ -426,6 +502,109 @@ namespace base_local_planner{
 
   }
 
+  int TrajectoryPlanner::computeNumSteps(double vx_samp, double vy_samp, double vtheta_samp) {
+    //compute the magnitude of the velocities
+    double vmag = hypot(vx_samp, vy_samp);
+
+    int num_steps;
+    if(!heading_scoring_) {
+      num_steps = int(max((vmag * sim_time_) / sim_granularity_, fabs(vtheta_samp) / angular_sim_granularity_) + 0.5);
+    } else {
+      num_steps = int(sim_time_ / sim_granularity_ + 0.5);
+    }
+
+    //we at least want to take one step... even if we won't move, we want to score our current position
+    if(num_steps == 0) {
+      num_steps = 1;
+    }
+    return num_steps;
+  }
+
+  bool TrajectoryPlanner::endpointGoalCost(
+      double x, double y, double theta,
+      double vx, double vy, double vtheta,
+      double vx_samp, double vy_samp, double vtheta_samp,
+      double acc_x, double acc_y, double acc_theta,
+      double impossible_cost,
+      double& goal_cost) {
+
+    // make sure the configuration doesn't change mid run
+    boost::mutex::scoped_lock l(configuration_mutex_);
+
+    int num_steps = computeNumSteps(vx_samp, vy_samp, vtheta_samp);
+    double dt = sim_time_ / num_steps;
+
+    // same integration as generateTrajectory, so we end up on exactly the same last point
+    double x_i = x, y_i = y, theta_i = theta;
+    double vx_i = vx, vy_i = vy, vtheta_i = vtheta;
+    for(int i = 0; i < num_steps - 1; ++i){
+      vx_i = computeNewVelocity(vx_samp, vx_i, acc_x, dt);
+      vy_i = computeNewVelocity(vy_samp, vy_i, acc_y, dt);
+      vtheta_i = computeNewVelocity(vtheta_samp, vtheta_i, acc_theta, dt);
+
+      x_i = computeNewXPosition(x_i, vx_i, vy_i, theta_i, dt);
+      y_i = computeNewYPosition(y_i, vx_i, vy_i, theta_i, dt);
+      theta_i = computeNewThetaPosition(theta_i, vtheta_i, dt);
+    }
+
+    unsigned int cell_x, cell_y;
+    if(!costmap_.worldToMap(x_i, y_i, cell_x, cell_y)){
+      return false;
+    }
+
+    double goal_dist, path_dist;
+    if (simple_attractor_) {
+      goal_dist = (x_i - global_plan_[global_plan_.size() -1].pose.position.x) *
+        (x_i - global_plan_[global_plan_.size() -1].pose.position.x) +
+        (y_i - global_plan_[global_plan_.size() -1].pose.position.y) *
+        (y_i - global_plan_[global_plan_.size() -1].pose.position.y);
+    } else {
+      if (heading_scoring_) {
+        headingDiff(cell_x, cell_y, x_i, y_i, theta_i, goal_dist, path_dist);
+      } else if (rollout_field_valid_) {
+        const RolloutCell& field_cell = rollout_field_(cell_x, cell_y);
+        path_dist = RolloutField::distance(field_cell.path_dist, impossible_cost);
+        goal_dist = RolloutField::distance(field_cell.goal_dist, impossible_cost);
+      } else {
+        path_dist = path_map_(cell_x, cell_y).target_dist;
+        goal_dist = goal_map_(cell_x, cell_y).target_dist;
+      }
+      if(impossible_cost <= goal_dist || impossible_cost <= path_dist){
+        return false;
+      }
+    }
+
+    goal_cost = goal_dist * gdist_scale_;
+    return true;
+  }
+
+  void TrajectoryPlanner::generateProgressingTrajectory(
+      double x, double y, double theta,
+      double vx, double vy, double vtheta,
+      double vx_samp, double vy_samp, double vtheta_samp,
+      double acc_x, double acc_y, double acc_theta,
+      double impossible_cost,
+      const Trajectory& reference,
+      Trajectory& traj) {
+    //the goal cost is that of the followed plan, a sample it rules out may still be best for an alternative one
+    if (reference.cost_ >= 0 && !corridors_active_) {
+      double goal_cost;
+      if (!endpointGoalCost(x, y, theta, vx, vy, vtheta, vx_samp, vy_samp, vtheta_samp,
+            acc_x, acc_y, acc_theta, impossible_cost, goal_cost)
+          || goal_cost >= reference.goal_cost_traj_) {
+        //this sample could not be selected anyway, so spare ourselves the rollout and footprint checks
+        traj.resetPoints();
+        traj.xv_ = vx_samp;
+        traj.yv_ = vy_samp;
+        traj.thetav_ = vtheta_samp;
+        traj.cost_ = -6.0;
+        return;
+      }
+    }
+    generateTrajectory(x, y, theta, vx, vy, vtheta, vx_samp, vy_samp, vtheta_samp,
+        acc_x, acc_y, acc_theta, impossible_cost, traj, true);
+  }
+
   double TrajectoryPlanner::headingDiff(int cell_x, int cell_y, double x, double y, double heading, double &goal_dist_traj, double &path_dist_traj){
     unsigned int goal_cell_x, goal_cell_y;
 
@@ -585,7 +764,97 @@ double TrajectoryPlanner::AngleDifference( double angle1, double angle2 )
     for(unsigned int i = 0; i < new_plan.size(); ++i){
       global_plan_[i] = new_plan[i];
     }
+    planUpdated(compute_dists);
+  }
+
+  void TrajectoryPlanner::setFootprint(std::vector<geometry_msgs::Point> footprint) {
+    boost::mutex::scoped_lock lock(footprint_mutex_);
+    pending_footprint_ = buildFootprintSet(footprint, lock);
+  }
+
+  void TrajectoryPlanner::registerFootprint(int id, const std::vector<geometry_msgs::Point>& footprint) {
+    boost::mutex::scoped_lock lock(footprint_mutex_);
+    footprint_sets_[id] = buildFootprintSet(footprint, lock);
+  }
+
+  boost::shared_ptr<const FootprintSet> TrajectoryPlanner::buildFootprintSet(const std::vector<geometry_msgs::Point>& footprint,
+      boost::mutex::scoped_lock& lock) {
+    //build outside of the lock, a cycle starting meanwhile should not wait for it
+    while (true) {
+      unsigned int heading_bins = footprint_heading_bins_;
+      lock.unlock();
+      boost::shared_ptr<const FootprintSet> footprint_set(new FootprintSet(footprint, costmap_.getResolution(), heading_bins));
+      lock.lock();
+      //a rebuild for other heading bins meanwhile would miss this set
+      if (heading_bins == footprint_heading_bins_) {
+        return footprint_set;
+      }
+    }
+  }
+
+  bool TrajectoryPlanner::selectFootprint(int id) {
+    boost::mutex::scoped_lock lock(footprint_mutex_);
+    std::map<int, boost::shared_ptr<const FootprintSet> >::const_iterator it = footprint_sets_.find(id);
+    if (it == footprint_sets_.end()) {
+      ROS_ERROR("No footprint is registered with id %d", id);
+      return false;
+    }
+    pending_footprint_ = it->second;
+    return true;
+  }
+
+  void TrajectoryPlanner::switchFootprint() {
+    boost::mutex::scoped_lock lock(footprint_mutex_);
+    if (pending_footprint_) {
+      footprint_.swap(pending_footprint_);
+      pending_footprint_.reset();
+    }
+  }
+
+  void TrajectoryPlanner::rebuildFootprints(unsigned int heading_bins) {
+    std::map<int, boost::shared_ptr<const FootprintSet> > footprint_sets;
+    boost::shared_ptr<const FootprintSet> current;
+    {
+      boost::mutex::scoped_lock lock(footprint_mutex_);
+      if (heading_bins == footprint_heading_bins_) {
+        return;
+      }
+      footprint_heading_bins_ = heading_bins;
+      footprint_sets = footprint_sets_;
+      current = pending_footprint_ ? pending_footprint_ : footprint_;
+    }
+
+    //build outside of the lock like registerFootprint, then swap the new sets in as if they were selected
+    std::map<int, boost::shared_ptr<const FootprintSet> >::iterator it;
+    for (it = footprint_sets.begin(); it != footprint_sets.end(); ++it) {
+      it->second.reset(new FootprintSet(it->second->getFootprint(), costmap_.getResolution(), heading_bins));
+    }
+    boost::shared_ptr<const FootprintSet> rebuilt(new FootprintSet(current->getFootprint(), costmap_.getResolution(), heading_bins));
+
+    boost::mutex::scoped_lock lock(footprint_mutex_);
+    //a later rebuild for other heading bins takes over
+    if (heading_bins != footprint_heading_bins_) {
+      return;
+    }
+    for (it = footprint_sets.begin(); it != footprint_sets.end(); ++it) {
+      //unless the footprint was registered again meanwhile, then it was built for these bins already
+      std::map<int, boost::shared_ptr<const FootprintSet> >::iterator registered = footprint_sets_.find(it->first);
+      if (registered != footprint_sets_.end() && registered->second->getHeadingBins() != heading_bins) {
+        registered->second = it->second;
+      }
+    }
+    //unless another footprint was asked for meanwhile
+    if (!pending_footprint_ || pending_footprint_ == current) {
+      pending_footprint_ = rebuilt;
+    }
+  }
+
+  void TrajectoryPlanner::swapPlan(vector<geometry_msgs::PoseStamped>& new_plan, bool compute_dists){
+    global_plan_.swap(new_plan);
+    planUpdated(compute_dists);
+  }
 
+  void TrajectoryPlanner::planUpdated(bool compute_dists){
     if( global_plan_.size() > 0 ){
       geometry_msgs::PoseStamped& final_goal_pose = global_plan_[ global_plan_.size() - 1 ];
       final_goal_x_ = final_goal_pose.pose.position.x;
@@ -599,6 +868,8 @@ double TrajectoryPlanner::AngleDifference( double angle1, double angle2 )
       //reset the map for new operations
       path_map_.resetPathDist();
       goal_map_.resetPathDist();
+      path_map_.setCostWeight(path_cost_weight_);
+      goal_map_.setCostWeight(path_cost_weight_);
 
       //make sure that we update our path based on the global plan and compute costs
       path_map_.setTargetCells(costmap_, global_plan_);
@@ -609,8 +880,6 @@ double TrajectoryPlanner::AngleDifference( double angle1, double angle2 )
 
   bool TrajectoryPlanner::checkTrajectory(double x, double y, double theta, double vx, double vy,
       double vtheta, double vx_samp, double vy_samp, double vtheta_samp){
-    Trajectory t;
-
     double cost = scoreTrajectory(x, y, theta, vx, vy, vtheta, vx_samp, vy_samp, vtheta_samp);
 
     //if the trajectory is a legal one... the check passes
@@ -625,16 +894,64 @@ double TrajectoryPlanner::AngleDifference( double angle1, double angle2 )
 
   double TrajectoryPlanner::scoreTrajectory(double x, double y, double theta, double vx, double vy,
       double vtheta, double vx_samp, double vy_samp, double vtheta_samp) {
-    Trajectory t;
+    switchFootprint();
+    PooledTrajectory t(trajectory_pool_, computeNumSteps(vx_samp, vy_samp, vtheta_samp));
     double impossible_cost = path_map_.obstacleCosts();
     generateTrajectory(x, y, theta,
                        vx, vy, vtheta,
                        vx_samp, vy_samp, vtheta_samp,
                        acc_lim_x_, acc_lim_y_, acc_lim_theta_,
-                       impossible_cost, t);
+                       impossible_cost, *t);
 
     // return the cost.
-    return double( t.cost_ );
+    return double( t->cost_ );
+  }
+
+  //a phase with a budget stops sampling once it has scored that many trajectories
+  static bool withinBudget(const TrajectoryPlanner::SearchPhaseGate& gate, unsigned int rollouts) {
+    return gate.max_samples == 0 || rollouts < gate.max_samples;
+  }
+
+  void TrajectoryPlanner::setSearchPhaseGate(SearchPhase phase, const SearchPhaseGate& gate) {
+    boost::mutex::scoped_lock l(configuration_mutex_);
+    search_gates_[phase] = gate;
+  }
+
+  bool TrajectoryPlanner::finishSearchPhase(SearchPhase phase, bool skipped, const SearchPhaseGate& gate, unsigned int rollouts,
+      const Trajectory& best, const Trajectory& reference) {
+    SearchPhaseStats& stats = search_phase_stats_[phase];
+    if (skipped) {
+      ++stats.skipped;
+      return true;
+    }
+    ++stats.runs;
+    stats.rollouts += rollouts;
+
+    if (gate.max_cost < 0.0 || best.cost_ < 0.0 || best.cost_ > gate.max_cost) {
+      return false;
+    }
+    //the path distance of the trajectory is the one of its last scored point
+    if (path_distance_max_ > 0.0 && best.path_dist_traj_ > path_distance_max_ - gate.tube_margin) {
+      return false;
+    }
+    //the goal costs are in different units in every scoring mode, so the progress is measured between the endpoints in meters
+    double reach = max_vel_x_ * sim_time_;
+    if (gate.min_progress > 0.0) {
+      if (reach <= 0.0 || reference.cost_ < 0.0 || reference.getPointsSize() == 0 || best.getPointsSize() == 0 ||
+          global_plan_.empty()) {
+        return false;
+      }
+      double goal_x = global_plan_.back().pose.position.x, goal_y = global_plan_.back().pose.position.y;
+      double best_x, best_y, best_th, reference_x, reference_y, reference_th;
+      best.getEndpoint(best_x, best_y, best_th);
+      reference.getEndpoint(reference_x, reference_y, reference_th);
+      double progress = hypot(goal_x - reference_x, goal_y - reference_y) - hypot(goal_x - best_x, goal_y - best_y);
+      if (progress < gate.min_progress * reach) {
+        return false;
+      }
+    }
+    ++stats.accepted;
+    return true;
   }
 
   /*
@@ -703,9 +1020,22 @@ double TrajectoryPlanner::AngleDifference( double angle1, double angle2 )
 
 
 // Compute a reference cost, i.e. the current position. If the new traj do not make progress then we do not take it into account
-    Trajectory current_pos_traj;
+    PooledTrajectory current_pos_buffer(trajectory_pool_, computeNumSteps(0, 0, 0));
+    Trajectory& current_pos_traj = *current_pos_buffer;
     generateTrajectory(x, y, theta, vx, vy, vtheta, 0, 0, 0,
             acc_x, acc_y, acc_theta, impossible_cost, current_pos_traj);
+    if (corridors_active_) {
+      setCorridorReferences(current_pos_traj, impossible_cost);
+    }
+
+    //each phase may end the search once the best trajectory so far passes its gate
+    SearchPhaseGate gates[NUM_SEARCH_PHASES];
+    {
+      boost::mutex::scoped_lock l(configuration_mutex_);
+      std::copy(search_gates_, search_gates_ + NUM_SEARCH_PHASES, gates);
+    }
+    bool accepted = false;
+    unsigned int rollouts = 0;
 
 
 
@@ -713,11 +1043,12 @@ double TrajectoryPlanner::AngleDifference( double angle1, double angle2 )
     if (true) {//{ Cesar
 //    if (!escaping_) {
       //loop through all x velocities
-      for(int i = 0; i < vx_samples_; ++i) {
+      for(int i = 0; i < vx_samples_ && withinBudget(gates[FORWARD_PHASE], rollouts); ++i) {
         vtheta_samp = 0;
         //first sample the straight trajectory
-        generateTrajectory(x, y, theta, vx, vy, vtheta, vx_samp, vy_samp, vtheta_samp,
-            acc_x, acc_y, acc_theta, impossible_cost, *comp_traj);
+        generateProgressingTrajectory(x, y, theta, vx, vy, vtheta, vx_samp, vy_samp, vtheta_samp,
+            acc_x, acc_y, acc_theta, impossible_cost, current_pos_traj, *comp_traj);
+        ++rollouts;
 
         //if the new trajectory is better... let's take it
         if(comp_traj->cost_ >= 0 && (comp_traj->cost_ < best_traj->cost_ || best_traj->cost_ < 0)
@@ -737,9 +1068,10 @@ double TrajectoryPlanner::AngleDifference( double angle1, double angle2 )
         vtheta_samp = min_vel_theta;
         //next sample all theta trajectories
 
-        for(int j = 0; j < vtheta_samples_ - 1; ++j){
-          generateTrajectory(x, y, theta, vx, vy, vtheta, vx_samp, vy_samp, vtheta_samp,
-              acc_x, acc_y, acc_theta, impossible_cost, *comp_traj);
+        for(int j = 0; j < vtheta_samples_ - 1 && withinBudget(gates[FORWARD_PHASE], rollouts); ++j){
+          generateProgressingTrajectory(x, y, theta, vx, vy, vtheta, vx_samp, vy_samp, vtheta_samp,
+              acc_x, acc_y, acc_theta, impossible_cost, current_pos_traj, *comp_traj);
+          ++rollouts;
 
           //if the new trajectory is better... let's take it
           if(comp_traj->cost_ >= 0 && (comp_traj->cost_ < best_traj->cost_ || best_traj->cost_ < 0)
@@ -759,18 +1091,21 @@ double TrajectoryPlanner::AngleDifference( double angle1, double angle2 )
         }
         vx_samp += dvx;
       }
+      accepted = finishSearchPhase(FORWARD_PHASE, false, gates[FORWARD_PHASE], rollouts, *best_traj, current_pos_traj);
 
        if (holonomic_robot_) {
         vtheta_samp = 0.0;
         vx_samp = 0.0;
         vy_samp = min_vel_y;
-        for(int j = 0; j < vy_samples_ - 1; ++j){
+        rollouts = 0;
+        for(int j = 0; !accepted && j < vy_samples_ - 1 && withinBudget(gates[STRAFE_PHASE], rollouts); ++j){
           if (fabs(vy_samp) < 0.01){
             vy_samp += dvy;
             continue;
           }
-          generateTrajectory(x, y, theta, vx, vy, vtheta, vx_samp, vy_samp, vtheta_samp,
-              acc_x, acc_y, acc_theta, impossible_cost, *comp_traj);
+          generateProgressingTrajectory(x, y, theta, vx, vy, vtheta, vx_samp, vy_samp, vtheta_samp,
+              acc_x, acc_y, acc_theta, impossible_cost, current_pos_traj, *comp_traj);
+          ++rollouts;
 
           //if the new trajectory is better... let's take it
           if(comp_traj->cost_ >= 0 && ( comp_traj->cost_ < best_traj->cost_  || best_traj->cost_ < 0)
@@ -789,20 +1124,23 @@ double TrajectoryPlanner::AngleDifference( double angle1, double angle2 )
           }
           vy_samp += dvy;
         }
+        accepted = finishSearchPhase(STRAFE_PHASE, accepted, gates[STRAFE_PHASE], rollouts, *best_traj, current_pos_traj);
 
         vx_samp = min_vel_x/2;
-        for(int i = 0; i < vx_samples_/2; ++i) {
+        rollouts = 0;
+        for(int i = 0; !accepted && i < vx_samples_/2 && withinBudget(gates[STRAFE_FORWARD_PHASE], rollouts); ++i) {
           vtheta_samp = 0.0;
           vy_samp = min_vel_y;
           //next sample all vy trajectories
-          for(int j = 0; j < (vy_samples_ - 1); ++j){
+          for(int j = 0; j < (vy_samples_ - 1) && withinBudget(gates[STRAFE_FORWARD_PHASE], rollouts); ++j){
             if (fabs(vy_samp) < 0.01)
             {
               vy_samp += dvy;
               continue;
             }
-            generateTrajectory(x, y, theta, vx, vy, vtheta, vx_samp, vy_samp, vtheta_samp,
-                acc_x, acc_y, acc_theta, impossible_cost, *comp_traj);
+            generateProgressingTrajectory(x, y, theta, vx, vy, vtheta, vx_samp, vy_samp, vtheta_samp,
+                acc_x, acc_y, acc_theta, impossible_cost, current_pos_traj, *comp_traj);
+            ++rollouts;
 
             //if the new trajectory is better... let's take it
             if(comp_traj->cost_ >= 0 && (comp_traj->cost_ < best_traj->cost_ || best_traj->cost_ < 0)
@@ -822,6 +1160,8 @@ double TrajectoryPlanner::AngleDifference( double angle1, double angle2 )
           }
           vx_samp += dvx;
         }
+        accepted = finishSearchPhase(STRAFE_FORWARD_PHASE, accepted, gates[STRAFE_FORWARD_PHASE], rollouts,
+            *best_traj, current_pos_traj);
       }
 
       ////only explore y velocities with holonomic robots
@@ -870,14 +1210,16 @@ double TrajectoryPlanner::AngleDifference( double angle1, double angle2 )
     //let's try to rotate toward open space
     double heading_dist = DBL_MAX;
 
-     if (true){ //  best_traj->cost_ < 0 Cesar added condition
-        for(int i = 0; i < vtheta_samples_; ++i) {
+    rollouts = 0;
+     if (!accepted){ //  best_traj->cost_ < 0 Cesar added condition
+        for(int i = 0; i < vtheta_samples_ && withinBudget(gates[ROTATE_PHASE], rollouts); ++i) {
         //enforce a minimum rotational velocity because the base can't handle small in-place rotations
         double vtheta_samp_limited = vtheta_samp > 0 ? max(vtheta_samp, min_in_place_vel_th_)
             : min(vtheta_samp, -1.0 * min_in_place_vel_th_);
 
-        generateTrajectory(x, y, theta, vx, vy, vtheta, vx_samp, vy_samp, vtheta_samp_limited,
-            acc_x, acc_y, acc_theta, impossible_cost, *comp_traj);
+        generateProgressingTrajectory(x, y, theta, vx, vy, vtheta, vx_samp, vy_samp, vtheta_samp_limited,
+            acc_x, acc_y, acc_theta, impossible_cost, current_pos_traj, *comp_traj);
+        ++rollouts;
 
 
         //if the new trajectory is better... let's take it...
@@ -938,6 +1280,7 @@ double TrajectoryPlanner::AngleDifference( double angle1, double angle2 )
         vtheta_samp += dvtheta;
         }
      }
+    finishSearchPhase(ROTATE_PHASE, accepted, gates[ROTATE_PHASE], rollouts, *best_traj, current_pos_traj);
 
     //do we have a legal trajectory
     if (best_traj->cost_ >= 0) {
@@ -1148,13 +1491,195 @@ double TrajectoryPlanner::AngleDifference( double angle1, double angle2 )
 
   }
 
+  bool TrajectoryPlanner::corridorCost(const Corridor& corridor, const Trajectory& traj, double occ_cost, double impossible_cost,
+      double& cost, double& path_dist, double& goal_cost){
+    unsigned int num_points = traj.getPointsSize();
+    if (num_points == 0 || corridor.plan.empty()) {
+      return false;
+    }
+
+    double path_dist_scored = 0.0;
+    double goal_dist = 0.0;
+    for (unsigned int i = 0; i < num_points; ++i) {
+      double px, py, pth;
+      traj.getPoint(i, px, py, pth);
+
+      if (simple_attractor_) {
+        const geometry_msgs::Point& goal = corridor.plan[corridor.plan.size() - 1].pose.position;
+        goal_dist = (px - goal.x) * (px - goal.x) + (py - goal.y) * (py - goal.y);
+        continue;
+      }
+
+      //every point of the trajectory passed the map bounds check
+      unsigned int cell_x, cell_y;
+      costmap_.worldToMap(px, py, cell_x, cell_y);
+      path_dist_scored = corridor.path_map(cell_x, cell_y).target_dist;
+      goal_dist = corridor.goal_map(cell_x, cell_y).target_dist;
+
+      //if a point on this trajectory has no clear path to goal it is invalid
+      if (impossible_cost <= goal_dist || impossible_cost <= path_dist_scored) {
+        return false;
+      }
+    }
+
+    path_dist = path_dist_scored;
+    if (path_distance_max_ > 0.0 && path_dist_scored <= path_distance_max_) {
+      path_dist_scored = 0.0;
+    }
+    goal_cost = goal_dist * gdist_scale_;
+    cost = pdist_scale_ * path_dist_scored + goal_cost + occdist_scale_ * occ_cost;
+    return true;
+  }
+
+  void TrajectoryPlanner::setCorridorReferences(const Trajectory& current_pos_traj, double impossible_cost){
+    for (unsigned int c = 0; c < corridors_.size(); ++c) {
+      double cost, path_dist, goal_cost;
+      if (!corridorCost(corridors_[c], current_pos_traj, 0.0, impossible_cost, cost, path_dist, goal_cost)) {
+        goal_cost = -1.0;
+      }
+      corridors_[c].reference_goal_cost = goal_cost;
+    }
+  }
+
+  void TrajectoryPlanner::scoreCorridors(const Trajectory& traj, double occ_cost, double impossible_cost){
+    for (unsigned int c = 0; c < corridors_.size(); ++c) {
+      Corridor& corridor = corridors_[c];
+      double cost, path_dist, goal_cost;
+      if (!corridorCost(corridor, traj, occ_cost, impossible_cost, cost, path_dist, goal_cost)) {
+        continue;
+      }
+
+      //like on the followed plan, a trajectory has to bring the robot closer to the goal than staying put
+      if (corridor.reference_goal_cost >= 0.0 && goal_cost >= corridor.reference_goal_cost) {
+        continue;
+      }
+
+      if (corridor.best.cost_ < 0 || cost < corridor.best.cost_) {
+        corridor.best = traj;
+        corridor.best.cost_ = cost;
+        corridor.best.path_dist_traj_ = path_dist;
+        corridor.best.goal_cost_traj_ = goal_cost;
+      }
+    }
+  }
+
+  unsigned int TrajectoryPlanner::blockedStateHash(unsigned int x0, unsigned int y0, unsigned int x1, unsigned int y1) {
+    //FNV-1a over the costs of the window
+    unsigned int hash = 2166136261u;
+    const unsigned char* costs = costmap_.getCharMap();
+    unsigned int size_x = costmap_.getSizeInCellsX();
+    x1 = std::min(x1, size_x - 1);
+    y1 = std::min(y1, costmap_.getSizeInCellsY() - 1);
+    for (unsigned int y = y0; y <= y1; ++y) {
+      const unsigned char* row = costs + y * size_x;
+      for (unsigned int x = x0; x <= x1; ++x) {
+        hash = (hash ^ row[x]) * 16777619u;
+      }
+    }
+
+    //and over every position of the plan, a rerouted plan brings new distances even if it ends at the same goal
+    for (unsigned int p = 0; p < global_plan_.size(); ++p) {
+      double position[2] = {global_plan_[p].pose.position.x, global_plan_[p].pose.position.y};
+      const unsigned char* bytes = reinterpret_cast<const unsigned char*>(position);
+      for (unsigned int i = 0; i < sizeof(position); ++i) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+      }
+    }
+    hash = (hash ^ (unsigned int) global_plan_.size()) * 16777619u;
+    return hash;
+  }
+
+  int TrajectoryPlanner::findBestCorridorPaths(tf::Stamped<tf::Pose> global_pose, tf::Stamped<tf::Pose> global_vel,
+      const std::vector<std::vector<geometry_msgs::PoseStamped> >& plans, std::vector<Trajectory>& best_trajs){
+    best_trajs.clear();
+    if (plans.empty()) {
+      return -1;
+    }
+
+    updatePlan(plans[0]);
+
+    corridors_.resize(plans.size() - 1);
+    for (unsigned int c = 0; c < corridors_.size(); ++c) {
+      corridors_[c].plan = plans[c + 1];
+      corridors_[c].best.resetPoints();
+      corridors_[c].best.cost_ = -1.0;
+      corridors_[c].reference_goal_cost = -1.0;
+    }
+
+    //heading scoring compares headings along the followed plan only, the other plans could only be scored differently
+    if (heading_scoring_ && !corridors_.empty()) {
+      ROS_ERROR("Alternative plans are not scored with heading_scoring on, only the first plan is");
+    }
+
+    //one rollout of the samples, scored against the first plan by findBestPath and against the others as they come
+    tf::Stamped<tf::Pose> drive_velocities;
+    corridors_active_ = !heading_scoring_ && !corridors_.empty();
+    best_trajs.push_back(findBestPath(global_pose, global_vel, drive_velocities));
+    corridors_active_ = false;
+
+    for (unsigned int c = 0; c < corridors_.size(); ++c) {
+      best_trajs.push_back(corridors_[c].best);
+    }
+
+    int best_index = -1;
+    for (unsigned int i = 0; i < best_trajs.size(); ++i) {
+      if (best_trajs[i].cost_ >= 0 && (best_index < 0 || best_trajs[i].cost_ < best_trajs[best_index].cost_)) {
+        best_index = i;
+      }
+    }
+    return best_index;
+  }
+
   //given the current state of the robot, find a good trajectory
   Trajectory TrajectoryPlanner::findBestPath(tf::Stamped<tf::Pose> global_pose, tf::Stamped<tf::Pose> global_vel,
       tf::Stamped<tf::Pose>& drive_velocities){
 
+    ros::WallTime cycle_start = ros::WallTime::now();
+    switchFootprint();
+
     Eigen::Vector3f pos(global_pose.getOrigin().getX(), global_pose.getOrigin().getY(), tf::getYaw(global_pose.getRotation()));
     Eigen::Vector3f vel(global_vel.getOrigin().getX(), global_vel.getOrigin().getY(), tf::getYaw(global_vel.getRotation()));
 
+    //the command is only applied once planning and actuation are done, so plan from where the robot will be by then
+    if (latency_compensation_ && last_cmd_valid_ && (cycle_start - last_cycle_end_).toSec() <= 2.0 * sim_period_ + planning_latency_) {
+      predictStartState(pos, vel, planning_latency_ + actuation_delay_);
+    }
+
+    //the rollouts can not get further from the robot than this many cells
+    double max_speed = std::max(std::max(fabs(max_vel_x_), fabs(min_vel_x_)), fabs(backup_vel_));
+    for (unsigned int i = 0; i < y_vels_.size(); ++i) {
+      max_speed = std::max(max_speed, fabs(y_vels_[i]));
+    }
+    max_speed = std::max(max_speed, (double) hypot(vel[0], vel[1]));
+    unsigned int reach = (unsigned int) ceil(max_speed * sim_time_ / costmap_.getResolution());
+    unsigned int robot_x, robot_y;
+    bool robot_in_map = costmap_.worldToMap(pos[0], pos[1], robot_x, robot_y);
+
+    //a blocked robot only searches again once the costmap its footprint could reach, the plan, or its pose changed
+    unsigned int blocked_hash = 0;
+    if (blocked_cycles_ > 0 && robot_in_map) {
+      unsigned int window = reach + footprint_->getCellRadius(costmap_.getResolution());
+      blocked_hash = blockedStateHash(robot_x > window ? robot_x - window : 0, robot_y > window ? robot_y - window : 0,
+          robot_x + window, robot_y + window);
+      if (blocked_) {
+        bool moved = hypot(pos[0] - blocked_x_, pos[1] - blocked_y_) > sim_granularity_ ||
+            fabs(angles::shortest_angular_distance(blocked_theta_, pos[2])) > angular_sim_granularity_;
+        if (!moved && blocked_hash == blocked_hash_) {
+          //the search would fail again, so keep commanding the stop it led to
+          Trajectory stop;
+          stop.cost_ = -1.0;
+          drive_velocities.setOrigin(tf::Vector3(0, 0, 0));
+          tf::Matrix3x3 matrix;
+          matrix.setRotation(tf::createQuaternionFromYaw(0));
+          drive_velocities.setBasis(matrix);
+          recordCycle(cycle_start, drive_velocities);
+          return stop;
+        }
+        ROS_DEBUG("The surroundings of the blocked robot changed, searching again");
+        blocked_ = false;
+      }
+    }
+
     //reset the map for new operations
     path_map_.resetPathDist();
     goal_map_.resetPathDist();
@@ -1163,7 +1688,7 @@ double TrajectoryPlanner::AngleDifference( double angle1, double angle2 )
     std::vector<base_local_planner::Position2DInt> footprint_list =
         footprint_helper_.getFootprintCells(
             pos,
-            footprint_spec_,
+            footprint_->getFootprint(),
             costmap_,
             true);
 
@@ -1172,15 +1697,92 @@ double TrajectoryPlanner::AngleDifference( double angle1, double angle2 )
       path_map_(footprint_list[i].x, footprint_list[i].y).within_robot = true;
     }
 
-    //make sure that we update our path based on the global plan and compute costs
-    path_map_.setTargetCells(costmap_, global_plan_);
-    goal_map_.setLocalGoal(costmap_, global_plan_);
+    //only the cells the rollouts can reach need full resolution distances
+    unsigned int roi_x0 = 0, roi_y0 = 0, roi_x1 = 0, roi_y1 = 0;
+    const CoarseGraph* coarse_graph = NULL;
+    if (coarse_grid_factor_ > 1 && robot_in_map) {
+      unsigned int roi_reach = reach + coarse_grid_factor_;
+      roi_x0 = robot_x > roi_reach ? robot_x - roi_reach : 0;
+      roi_y0 = robot_y > roi_reach ? robot_y - roi_reach : 0;
+      roi_x1 = robot_x + roi_reach;
+      roi_y1 = robot_y + roi_reach;
+      //the graph only depends on the costmap, so it is built once for all the distance grids below
+      coarse_graph_.update(costmap_, coarse_grid_factor_);
+      coarse_graph = &coarse_graph_;
+    }
+    path_map_.setRegionOfInterest(roi_x0, roi_y0, roi_x1, roi_y1, coarse_graph);
+    goal_map_.setRegionOfInterest(roi_x0, roi_y0, roi_x1, roi_y1, coarse_graph);
+    path_map_.setCostWeight(path_cost_weight_);
+    goal_map_.setCostWeight(path_cost_weight_);
+
+    //the distance fields and the cost bounds only read the costmap, so they are computed side by side
+    boost::shared_ptr<TaskScheduler> scheduler = getScheduler();
+    {
+      TaskGroup fields(scheduler.get(), TaskScheduler::CONTROL);
+
+      //make sure that we update our path based on the global plan and compute costs
+      fields.run(boost::bind(&MapGrid::setTargetCells, &path_map_, boost::cref(costmap_), boost::cref(global_plan_)));
+      fields.run(boost::bind(&MapGrid::setLocalGoal, &goal_map_, boost::cref(costmap_), boost::cref(global_plan_)));
+
+      //the alternative plans score the same rollouts, so they need their own distances
+      if (corridors_active_) {
+        for (unsigned int c = 0; c < corridors_.size(); ++c) {
+          Corridor& corridor = corridors_[c];
+          corridor.path_map.sizeCheck(costmap_.getSizeInCellsX(), costmap_.getSizeInCellsY());
+          corridor.goal_map.sizeCheck(costmap_.getSizeInCellsX(), costmap_.getSizeInCellsY());
+          corridor.path_map.resetPathDist();
+          corridor.goal_map.resetPathDist();
+          for (unsigned int i = 0; i < footprint_list.size(); ++i) {
+            corridor.path_map(footprint_list[i].x, footprint_list[i].y).within_robot = true;
+          }
+          corridor.path_map.setRegionOfInterest(roi_x0, roi_y0, roi_x1, roi_y1, coarse_graph);
+          corridor.goal_map.setRegionOfInterest(roi_x0, roi_y0, roi_x1, roi_y1, coarse_graph);
+          corridor.path_map.setCostWeight(path_cost_weight_);
+          corridor.goal_map.setCostWeight(path_cost_weight_);
+          fields.run(boost::bind(&MapGrid::setTargetCells, &corridor.path_map, boost::cref(costmap_), boost::cref(corridor.plan)));
+          fields.run(boost::bind(&MapGrid::setLocalGoal, &corridor.goal_map, boost::cref(costmap_), boost::cref(corridor.plan)));
+        }
+      }
+
+      //bound the costs under the footprint around each cell, so most poses need no footprint check
+      if (costmap_world_model_) {
+        cost_bounds_.setRadius(footprint_->getCellRadius(costmap_.getResolution()));
+        cost_bounds_limit_ = CostBoundsGrid::legalCostLimit(footprint_->getFootprint());
+        unsigned int changed_x0, changed_y0, changed_x1, changed_y1;
+        bool resized = false;
+        if (costmap_mirror_ == NULL || !cost_bounds_synced_) {
+          //without a mirror nothing tells which cells changed
+          if (costmap_mirror_ != NULL) {
+            costmap_mirror_->takeChanges(changed_x0, changed_y0, changed_x1, changed_y1, resized);
+          }
+          fields.run(boost::bind(&CostBoundsGrid::update, &cost_bounds_, boost::cref(costmap_)));
+        } else {
+          //an empty region still recomputes the bounds for a new footprint radius, and the bounds fall back to a full update when the map was resized
+          if (!costmap_mirror_->takeChanges(changed_x0, changed_y0, changed_x1, changed_y1, resized)) {
+            changed_x0 = changed_y0 = 1;
+            changed_x1 = changed_y1 = 0;
+          }
+          fields.run(boost::bind(&CostBoundsGrid::updateRegion, &cost_bounds_, boost::cref(costmap_),
+                changed_x0, changed_y0, changed_x1, changed_y1));
+        }
+        cost_bounds_synced_ = costmap_mirror_ != NULL;
+        cost_bounds_valid_ = true;
+      }
+
+      fields.wait();
+    }
     ROS_DEBUG("Path/Goal distance computed");
 
+    //pack what the rollouts read per cell into one record
+    rollout_field_.update(costmap_, path_map_, goal_map_, path_distance_max_);
+    rollout_field_valid_ = true;
+
     //rollout trajectories and find the minimum cost one
     Trajectory best = createTrajectories(pos[0], pos[1], pos[2],
         vel[0], vel[1], vel[2],
         acc_lim_x_, acc_lim_y_, acc_lim_theta_);
+    cost_bounds_valid_ = false;
+    rollout_field_valid_ = false;
     ROS_DEBUG("Trajectories created");
 
     /*
@@ -1208,6 +1810,21 @@ double TrajectoryPlanner::AngleDifference( double angle1, double angle2 )
     }
     */
 
+    //after enough failures in a row, wait for the surroundings to change before searching again
+    if (best.cost_ < 0) {
+      ++failed_searches_;
+      if (blocked_cycles_ > 0 && failed_searches_ >= blocked_cycles_ && robot_in_map) {
+        ROS_DEBUG("No legal trajectory in %d cycles, suspending the search until the costmap or the robot pose change", failed_searches_);
+        blocked_ = true;
+        blocked_hash_ = blocked_hash;
+        blocked_x_ = pos[0];
+        blocked_y_ = pos[1];
+        blocked_theta_ = pos[2];
+      }
+    } else {
+      failed_searches_ = 0;
+    }
+
     if(best.cost_ < 0){
       //drive_velocities.setIdentity();
       tf::Vector3 start(0, 0, 0);
@@ -1224,13 +1841,62 @@ double TrajectoryPlanner::AngleDifference( double angle1, double angle2 )
       drive_velocities.setBasis(matrix);
     }
 
+    recordCycle(cycle_start, drive_velocities);
     return best;
   }
 
+  void TrajectoryPlanner::predictStartState(Eigen::Vector3f& pos, Eigen::Vector3f& vel, double horizon) {
+    //the base accelerates towards the last command within its limits, integrated in steps like the rollouts
+    const double max_step = 0.05;
+    int num_steps = (int) ceil(horizon / max_step);
+    if (num_steps <= 0) {
+      return;
+    }
+    double dt = horizon / num_steps;
+    double x = pos[0], y = pos[1], theta = pos[2];
+    double vx = vel[0], vy = vel[1], vtheta = vel[2];
+    for (int i = 0; i < num_steps; ++i) {
+      vx = computeNewVelocity(last_cmd_vel_[0], vx, acc_lim_x_, dt);
+      vy = computeNewVelocity(last_cmd_vel_[1], vy, acc_lim_y_, dt);
+      vtheta = computeNewVelocity(last_cmd_vel_[2], vtheta, acc_lim_theta_, dt);
+      x = computeNewXPosition(x, vx, vy, theta, dt);
+      y = computeNewYPosition(y, vx, vy, theta, dt);
+      theta = computeNewThetaPosition(theta, vtheta, dt);
+    }
+    pos = Eigen::Vector3f(x, y, theta);
+    vel = Eigen::Vector3f(vx, vy, vtheta);
+  }
+
+  void TrajectoryPlanner::recordCycle(const ros::WallTime& cycle_start, const tf::Stamped<tf::Pose>& drive_velocities) {
+    last_cycle_end_ = ros::WallTime::now();
+    double latency = (last_cycle_end_ - cycle_start).toSec();
+    //smooth the measured latency, so a single slow cycle does not throw the next start state far off
+    planning_latency_ = last_cmd_valid_ ? 0.8 * planning_latency_ + 0.2 * latency : latency;
+    last_cmd_vel_ = Eigen::Vector3f(drive_velocities.getOrigin().getX(), drive_velocities.getOrigin().getY(),
+        tf::getYaw(drive_velocities.getRotation()));
+    last_cmd_valid_ = true;
+  }
+
+  void TrajectoryPlanner::recordCommand(double vx, double vy, double vtheta) {
+    //the next start state is predicted from the command the base got, which is not the planned one near the goal
+    last_cycle_end_ = ros::WallTime::now();
+    last_cmd_vel_ = Eigen::Vector3f(vx, vy, vtheta);
+    last_cmd_valid_ = true;
+  }
+
   //we need to take the footprint of the robot into account when we calculate cost to obstacles
   double TrajectoryPlanner::footprintCost(double x_i, double y_i, double theta_i){
+    //with outline tables for this footprint, checking a pose is a loop over a fixed list of cells
+    if (costmap_world_model_ && footprint_->hasOutlines(costmap_.getResolution())) {
+      unsigned int cell_x, cell_y;
+      if (!costmap_.worldToMap(x_i, y_i, cell_x, cell_y)) {
+        return -1.0;
+      }
+      return static_cast<CostmapModel&>(world_model_).outlineCost(cell_x, cell_y, footprint_->getOutline(theta_i));
+    }
     //check if the footprint is legal
-    return world_model_.footprintCost(x_i, y_i, theta_i, footprint_spec_, inscribed_radius_, circumscribed_radius_);
+    return world_model_.footprintCost(x_i, y_i, theta_i, footprint_->getFootprint(),
+        footprint_->getInscribedRadius(), footprint_->getCircumscribedRadius());
   }
 
 
@@ -1239,6 +1905,61 @@ double TrajectoryPlanner::AngleDifference( double angle1, double angle2 )
     y = path_map_.goal_y_;
   }
 
+  void TrajectoryPlanner::setCostmapMirror(CostmapMirror* mirror){
+    if (mirror != NULL && &mirror->getCostmap() != &costmap_) {
+      ROS_ERROR("The costmap mirror is not the costmap the planner was constructed on, ignoring it");
+      mirror = NULL;
+    }
+    costmap_mirror_ = mirror;
+    cost_bounds_synced_ = false;
+  }
+
+  boost::shared_ptr<TaskScheduler> TrajectoryPlanner::getScheduler(){
+    boost::mutex::scoped_lock l(configuration_mutex_);
+    return scheduler_;
+  }
+
+  void TrajectoryPlanner::getMemoryUsage(std::vector<std::string>& names, std::vector<uint64_t>& bytes){
+    names.clear();
+    bytes.clear();
+    names.push_back("path_map");
+    bytes.push_back(path_map_.getMemoryUsage());
+    names.push_back("goal_map");
+    bytes.push_back(goal_map_.getMemoryUsage());
+    names.push_back("coarse_graph");
+    bytes.push_back(coarse_graph_.getMemoryUsage());
+    names.push_back("rollout_field");
+    bytes.push_back(rollout_field_.getMemoryUsage());
+    names.push_back("cost_bounds");
+    bytes.push_back(cost_bounds_.getMemoryUsage());
+    names.push_back("trajectory_pool");
+    bytes.push_back(trajectory_pool_.getMemoryUsage());
+    names.push_back("world_model");
+    bytes.push_back(world_model_.getMemoryUsage());
+
+    //the footprint in use may also be registered, count every set once
+    uint64_t footprint_bytes = footprint_->getMemoryUsage();
+    {
+      boost::mutex::scoped_lock lock(footprint_mutex_);
+      for (std::map<int, boost::shared_ptr<const FootprintSet> >::const_iterator it = footprint_sets_.begin();
+          it != footprint_sets_.end(); ++it) {
+        if (it->second != footprint_) {
+          footprint_bytes += it->second->getMemoryUsage();
+        }
+      }
+    }
+    names.push_back("footprints");
+    bytes.push_back(footprint_bytes);
+
+    uint64_t plan_bytes = vectorBytes(global_plan_) + vectorBytes(corridors_);
+    for (unsigned int i = 0; i < corridors_.size(); ++i) {
+      plan_bytes += vectorBytes(corridors_[i].plan) + corridors_[i].path_map.getMemoryUsage()
+        + corridors_[i].goal_map.getMemoryUsage() + corridors_[i].best.getMemoryUsage();
+    }
+    names.push_back("plans");
+    bytes.push_back(plan_bytes);
+  }
+
 };
 
 
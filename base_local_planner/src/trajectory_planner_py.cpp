@@ -0,0 +1,229 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the Willow Garage nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/*
+ * Python bindings over the trajectory planner, for offline analysis of recorded data.
+ * Built only when pybind11 is available. The costmap is copied into the planner once per
+ * update, the distance fields are returned as read only views onto the planner's grids.
+ */
+
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+
+#include <boost/scoped_ptr.hpp>
+
+#include <base_local_planner/trajectory_planner.h>
+#include <base_local_planner/costmap_model.h>
+
+namespace py = pybind11;
+
+namespace base_local_planner {
+
+  /**
+   * @class PyTrajectoryPlanner
+   * @brief Owns a costmap, the world model checking it and a trajectory planner over both
+   */
+  class PyTrajectoryPlanner {
+    public:
+      PyTrajectoryPlanner(py::array_t<unsigned char, py::array::c_style | py::array::forcecast> costmap,
+          double resolution, double origin_x, double origin_y,
+          py::array_t<double, py::array::c_style | py::array::forcecast> footprint,
+          double acc_lim_x, double acc_lim_y, double acc_lim_theta,
+          double sim_time, double sim_granularity, int vx_samples, int vtheta_samples,
+          double pdist_scale, double gdist_scale, double occdist_scale,
+          bool holonomic_robot, double max_vel_x, double min_vel_x, double max_vel_th, double min_vel_th,
+          double min_in_place_vel_th, double backup_vel)
+        : costmap_(checkedSize(costmap, 1), checkedSize(costmap, 0), resolution, origin_x, origin_y),
+          world_model_(costmap_) {
+        setCostmap(costmap);
+
+        if (footprint.ndim() != 2 || footprint.shape(1) != 2) {
+          throw std::invalid_argument("footprint must be an N x 2 array of points");
+        }
+        std::vector<geometry_msgs::Point> footprint_spec(footprint.shape(0));
+        for (unsigned int i = 0; i < footprint_spec.size(); ++i) {
+          footprint_spec[i].x = footprint.at(i, 0);
+          footprint_spec[i].y = footprint.at(i, 1);
+        }
+
+        planner_.reset(new TrajectoryPlanner(world_model_, costmap_, footprint_spec,
+            acc_lim_x, acc_lim_y, acc_lim_theta, sim_time, sim_granularity, vx_samples, vtheta_samples,
+            pdist_scale, gdist_scale, occdist_scale, 0.8, 0.325, 0.05, 0.10, M_PI_2,
+            holonomic_robot, max_vel_x, min_vel_x, max_vel_th, min_vel_th, min_in_place_vel_th, backup_vel));
+      }
+
+      /**
+       * @brief  Replace the costs, the array must have the shape the planner was created with
+       */
+      void setCostmap(py::array_t<unsigned char, py::array::c_style | py::array::forcecast> costmap) {
+        if (costmap.ndim() != 2 || (unsigned int) costmap.shape(0) != costmap_.getSizeInCellsY()
+            || (unsigned int) costmap.shape(1) != costmap_.getSizeInCellsX()) {
+          throw std::invalid_argument("costmap must be a size_y x size_x array");
+        }
+        //rows of the array are rows of the costmap, so one block copy does
+        memcpy(costmap_.getCharMap(), costmap.data(), costmap.size());
+      }
+
+      /**
+       * @brief  Follow a new plan of N x 2 positions or N x 3 poses, and compute its distance fields
+       */
+      void setPlan(py::array_t<double, py::array::c_style | py::array::forcecast> plan) {
+        if (plan.ndim() != 2 || (plan.shape(1) != 2 && plan.shape(1) != 3)) {
+          throw std::invalid_argument("plan must be an N x 2 or N x 3 array");
+        }
+        std::vector<geometry_msgs::PoseStamped> global_plan(plan.shape(0));
+        for (unsigned int i = 0; i < global_plan.size(); ++i) {
+          global_plan[i].pose.position.x = plan.at(i, 0);
+          global_plan[i].pose.position.y = plan.at(i, 1);
+          double yaw = plan.shape(1) == 3 ? plan.at(i, 2) : 0.0;
+          tf::quaternionTFToMsg(tf::createQuaternionFromYaw(yaw), global_plan[i].pose.orientation);
+        }
+        py::gil_scoped_release release;
+        planner_->updatePlan(global_plan, true);
+      }
+
+      /**
+       * @brief  Score a batch of samples, each row being x, y, theta, vx, vy, vtheta, vx_samp, vy_samp, vtheta_samp
+       * @return The cost of each sample, negative if it is illegal
+       */
+      py::array_t<double> evaluate(py::array_t<double, py::array::c_style | py::array::forcecast> samples) {
+        if (samples.ndim() != 2 || samples.shape(1) != 9) {
+          throw std::invalid_argument("samples must be an N x 9 array");
+        }
+        py::array_t<double> costs(samples.shape(0));
+        const double* in = samples.data();
+        double* out = costs.mutable_data();
+        py::ssize_t num_samples = samples.shape(0);
+        {
+          py::gil_scoped_release release;
+          for (py::ssize_t i = 0; i < num_samples; ++i) {
+            const double* s = in + 9 * i;
+            out[i] = planner_->scoreTrajectory(s[0], s[1], s[2], s[3], s[4], s[5], s[6], s[7], s[8]);
+          }
+        }
+        return costs;
+      }
+
+      /**
+       * @brief  Run a full planning cycle
+       * @return The cost of the chosen trajectory, its command as vx, vy, vtheta and its poses as an M x 3 array
+       */
+      py::tuple findBestPath(double x, double y, double theta, double vx, double vy, double vtheta) {
+        tf::Stamped<tf::Pose> global_pose(tf::Pose(tf::createQuaternionFromYaw(theta), tf::Vector3(x, y, 0)),
+            ros::Time(), "");
+        tf::Stamped<tf::Pose> global_vel(tf::Pose(tf::createQuaternionFromYaw(vtheta), tf::Vector3(vx, vy, 0)),
+            ros::Time(), "");
+        tf::Stamped<tf::Pose> drive_velocities;
+        Trajectory path;
+        {
+          py::gil_scoped_release release;
+          path = planner_->findBestPath(global_pose, global_vel, drive_velocities);
+        }
+
+        py::array_t<double> command(3);
+        command.mutable_at(0) = drive_velocities.getOrigin().getX();
+        command.mutable_at(1) = drive_velocities.getOrigin().getY();
+        command.mutable_at(2) = tf::getYaw(drive_velocities.getRotation());
+
+        py::array_t<double> points(std::vector<py::ssize_t>{(py::ssize_t) path.getPointsSize(), 3});
+        for (unsigned int i = 0; i < path.getPointsSize(); ++i) {
+          path.getPoint(i, points.mutable_at(i, 0), points.mutable_at(i, 1), points.mutable_at(i, 2));
+        }
+        return py::make_tuple(path.cost_, command, points);
+      }
+
+      py::array pathDistances(py::object self) { return distanceView(planner_->getPathMap(), self); }
+
+      py::array goalDistances(py::object self) { return distanceView(planner_->getGoalMap(), self); }
+
+    private:
+      static unsigned int checkedSize(const py::array& costmap, unsigned int axis) {
+        if (costmap.ndim() != 2) {
+          throw std::invalid_argument("costmap must be a size_y x size_x array");
+        }
+        return costmap.shape(axis);
+      }
+
+      /**
+       * @brief  A read only size_y x size_x view onto the target distances of a grid, keeping self alive
+       */
+      static py::array distanceView(const MapGrid& grid, py::object self) {
+        const MapCell* cells = grid.getCells();
+        if (cells == NULL) {
+          return py::array_t<double>(std::vector<py::ssize_t>{0, 0});
+        }
+        std::vector<py::ssize_t> shape{(py::ssize_t) grid.size_y_, (py::ssize_t) grid.size_x_};
+        std::vector<py::ssize_t> strides{(py::ssize_t) (grid.size_x_ * sizeof(MapCell)), (py::ssize_t) sizeof(MapCell)};
+        py::array view(py::dtype::of<double>(), shape, strides, &cells->target_dist, self);
+        view.attr("setflags")(py::arg("write") = false);
+        return view;
+      }
+
+      costmap_2d::Costmap2D costmap_;
+      CostmapModel world_model_;
+      boost::scoped_ptr<TrajectoryPlanner> planner_;
+  };
+
+};
+
+PYBIND11_MODULE(trajectory_planner_py, m) {
+  using base_local_planner::PyTrajectoryPlanner;
+  m.doc() = "Offline access to the base_local_planner trajectory planner";
+
+  py::class_<PyTrajectoryPlanner>(m, "TrajectoryPlanner")
+    .def(py::init<py::array_t<unsigned char, py::array::c_style | py::array::forcecast>, double, double, double,
+            py::array_t<double, py::array::c_style | py::array::forcecast>,
+            double, double, double, double, double, int, int, double, double, double,
+            bool, double, double, double, double, double, double>(),
+        py::arg("costmap"), py::arg("resolution"), py::arg("origin_x"), py::arg("origin_y"),
+        py::arg("footprint"),
+        py::arg("acc_lim_x") = 1.0, py::arg("acc_lim_y") = 1.0, py::arg("acc_lim_theta") = 1.0,
+        py::arg("sim_time") = 1.0, py::arg("sim_granularity") = 0.025,
+        py::arg("vx_samples") = 20, py::arg("vtheta_samples") = 20,
+        py::arg("pdist_scale") = 0.6, py::arg("gdist_scale") = 0.8, py::arg("occdist_scale") = 0.2,
+        py::arg("holonomic_robot") = true, py::arg("max_vel_x") = 0.5, py::arg("min_vel_x") = 0.1,
+        py::arg("max_vel_th") = 1.0, py::arg("min_vel_th") = -1.0, py::arg("min_in_place_vel_th") = 0.4,
+        py::arg("backup_vel") = -0.1)
+    .def("set_costmap", &PyTrajectoryPlanner::setCostmap, py::arg("costmap"))
+    .def("set_plan", &PyTrajectoryPlanner::setPlan, py::arg("plan"))
+    .def("evaluate", &PyTrajectoryPlanner::evaluate, py::arg("samples"))
+    .def("find_best_path", &PyTrajectoryPlanner::findBestPath,
+        py::arg("x"), py::arg("y"), py::arg("theta"), py::arg("vx"), py::arg("vy"), py::arg("vtheta"))
+    .def("path_distances", [](py::object self) { return self.cast<PyTrajectoryPlanner&>().pathDistances(self); })
+    .def("goal_distances", [](py::object self) { return self.cast<PyTrajectoryPlanner&>().goalDistances(self); });
+}
@@ -48,7 +48,13 @@
 #include <pluginlib/class_list_macros.h>
 
 #include <base_local_planner/goal_functions.h>
+#include <costmap_2d/footprint.h>
 #include <nav_msgs/Path.h>
+#include <base_local_planner/InputLatency.h>
+#include <base_local_planner/PlannerMemory.h>
+#include <base_local_planner/SchedulerLane.h>
+#include <base_local_planner/SearchPhase.h>
+#include <base_local_planner/memory_usage.h>
 
 
 
@@ -72,10 +78,10 @@ namespace base_local_planner {
   }
 
   TrajectoryPlannerROS::TrajectoryPlannerROS() :
-      world_model_(NULL), tc_(NULL), costmap_ros_(NULL), tf_(NULL), setup_(false), initialized_(false), odom_helper_("odom") {}
+      world_model_(NULL), voxel_model_(NULL), tc_(NULL), costmap_ros_(NULL), tf_(NULL), stop_background_(false), setup_(false), initialized_(false), odom_helper_("odom") {}
 
   TrajectoryPlannerROS::TrajectoryPlannerROS(std::string name, tf::TransformListener* tf, costmap_2d::Costmap2DROS* costmap_ros) :
-      world_model_(NULL), tc_(NULL), costmap_ros_(NULL), tf_(NULL), setup_(false), initialized_(false), odom_helper_("odom") {
+      world_model_(NULL), voxel_model_(NULL), tc_(NULL), costmap_ros_(NULL), tf_(NULL), stop_background_(false), setup_(false), initialized_(false), odom_helper_("odom") {
 
       //initialize the planner
       initialize(name, tf, costmap_ros);
@@ -90,6 +96,15 @@ namespace base_local_planner {
       ros::NodeHandle private_nh("~/" + name);
       g_plan_pub_ = private_nh.advertise<nav_msgs::Path>("global_plan", 1);
       l_plan_pub_ = private_nh.advertise<nav_msgs::Path>("local_plan", 1);
+      latency_pub_ = private_nh.advertise<InputLatency>("input_latency", 4);
+      memory_pub_ = private_nh.advertise<PlannerMemory>("memory_usage", 1);
+      scheduler_pub_ = private_nh.advertise<SchedulerLane>("scheduler_load", TaskScheduler::NUM_LANES);
+      search_phase_pub_ = private_nh.advertise<SearchPhase>("search_phases", TrajectoryPlanner::NUM_SEARCH_PHASES);
+
+      pose_age_ = LatencyHistogram("pose");
+      odom_age_ = LatencyHistogram("odom");
+      plan_age_ = LatencyHistogram("plan");
+      end_to_end_age_ = LatencyHistogram("end_to_end");
 
 
       tf_ = tf;
@@ -225,8 +240,25 @@ namespace base_local_planner {
       private_nh.param("point_grid/max_obstacle_height", max_obstacle_height, 2.0);
       private_nh.param("point_grid/grid_resolution", grid_resolution, 0.2);
 
-      ROS_ASSERT_MSG(world_model_type == "costmap", "At this time, only costmap world models are supported by this controller");
-      world_model_ = new CostmapModel(*costmap_);
+      if(world_model_type == "voxel"){
+        //the voxel grid is laid over the costmap, and checks the parts of the robot only against the heights they span
+        int size_z;
+        double z_resolution, origin_z;
+        private_nh.param("voxel_grid/size_z", size_z, 10);
+        private_nh.param("voxel_grid/z_resolution", z_resolution, 0.2);
+        private_nh.param("voxel_grid/origin_z", origin_z, 0.0);
+        voxel_model_ = new VoxelGridModel(costmap_->getSizeInCellsX(), costmap_->getSizeInCellsY(), size_z,
+            costmap_->getResolution(), z_resolution, costmap_->getOriginX(), costmap_->getOriginY(), origin_z,
+            max_obstacle_height, max_sensor_range_);
+        voxel_model_->setFootprintSections(loadFootprintSections(private_nh));
+        world_model_ = voxel_model_;
+        scan_sub_ = private_nh.subscribe("voxel_grid/scan", 1, &TrajectoryPlannerROS::scanCB, this);
+      }
+      else{
+        if(world_model_type != "costmap")
+          ROS_ERROR("Unknown world model %s, using the costmap", world_model_type.c_str());
+        world_model_ = new CostmapModel(*costmap_);
+      }
       std::vector<double> y_vels = loadYVels(private_nh);
 
       footprint_spec_ = costmap_ros_->getRobotFootprint();
@@ -273,10 +305,78 @@ namespace base_local_planner {
     return y_vels;
   }
 
+  std::vector<FootprintSection> TrajectoryPlannerROS::loadFootprintSections(ros::NodeHandle node){
+    std::vector<FootprintSection> sections;
+    XmlRpc::XmlRpcValue list;
+    if(!node.getParam("footprint_sections", list))
+      return sections;
+
+    if(list.getType() != XmlRpc::XmlRpcValue::TypeArray){
+      ROS_ERROR("footprint_sections must be a list of entries with a footprint, a min_z and a max_z, ignoring it");
+      return sections;
+    }
+    for(int i = 0; i < list.size(); ++i){
+      XmlRpc::XmlRpcValue& entry = list[i];
+      if(entry.getType() != XmlRpc::XmlRpcValue::TypeStruct || !entry.hasMember("footprint")
+          || !entry.hasMember("min_z") || !entry.hasMember("max_z")){
+        ROS_ERROR("Entry %d of footprint_sections needs a footprint, a min_z and a max_z, ignoring all sections", i);
+        return std::vector<FootprintSection>();
+      }
+      FootprintSection section;
+      try{
+        section.polygon = costmap_2d::makeFootprintFromXMLRPC(entry["footprint"], node.resolveName("footprint_sections"));
+        section.min_z = entry["min_z"].getType() == XmlRpc::XmlRpcValue::TypeInt ? (int) entry["min_z"] : (double) entry["min_z"];
+        section.max_z = entry["max_z"].getType() == XmlRpc::XmlRpcValue::TypeInt ? (int) entry["max_z"] : (double) entry["max_z"];
+      }
+      catch(const std::exception& e){
+        ROS_ERROR("Entry %d of footprint_sections is malformed, ignoring all sections: %s", i, e.what());
+        return std::vector<FootprintSection>();
+      }
+      sections.push_back(section);
+    }
+    return sections;
+  }
+
+  void TrajectoryPlannerROS::scanCB(const sensor_msgs::LaserScan::ConstPtr& scan){
+    boost::mutex::scoped_lock lock(scan_mutex_);
+    pending_scan_ = scan;
+  }
+
+  void TrajectoryPlannerROS::updateVoxelGrid(){
+    //the local costmap rolls with the robot, the voxel grid keeps covering the same area
+    voxel_model_->updateOrigin(costmap_->getOriginX(), costmap_->getOriginY());
+
+    sensor_msgs::LaserScan::ConstPtr scan;
+    {
+      boost::mutex::scoped_lock lock(scan_mutex_);
+      if(!pending_scan_)
+        return;
+      scan.swap(pending_scan_);
+    }
+
+    tf::StampedTransform sensor;
+    try{
+      tf_->lookupTransform(global_frame_, scan->header.frame_id, scan->header.stamp, sensor);
+    }
+    catch(tf::TransformException& ex){
+      ROS_WARN("Could not transform the scan into the frame of the voxel grid: %s", ex.what());
+      return;
+    }
+    geometry_msgs::Point origin;
+    origin.x = sensor.getOrigin().x();
+    origin.y = sensor.getOrigin().y();
+    origin.z = sensor.getOrigin().z();
+    voxel_model_->updateWorld(footprint_spec_, *scan, origin, tf::getYaw(sensor.getRotation()));
+  }
+
   TrajectoryPlannerROS::~TrajectoryPlannerROS() {
     //make sure to clean things up
     delete dsrv_;
 
+    //the background tasks use the controller
+    cancelBackgroundTasks();
+    background_tasks_.reset();
+
     if(tc_ != NULL)
       delete tc_;
 
@@ -364,9 +464,8 @@ namespace base_local_planner {
       return false;
     }
 
-    //reset the global plan
-    global_plan_.clear();
-    global_plan_ = orig_global_plan;
+    //reset the global plan, releasing the previous one
+    global_plan_ = SharedPlan(orig_global_plan);
     
     //when we get a new plan, we also want to clear any latch we may have on goal tolerances
     xy_tolerance_latch_ = false;
@@ -381,22 +480,31 @@ namespace base_local_planner {
       return false;
     }
 
+    uint64_t allocations, allocated_bytes;
+    getAllocationCount(allocations, allocated_bytes);
+
+    //a cost cloud of the last cycle that did not start yet is outdated now, and must not read the maps while they change
+    cancelBackgroundTasks();
+
+    //the footprint checks of this cycle see the newest scan
+    if(voxel_model_ != NULL)
+      updateVoxelGrid();
+
     std::vector<geometry_msgs::PoseStamped> local_plan;
     tf::Stamped<tf::Pose> global_pose;
     if (!costmap_ros_->getRobotPose(global_pose)) {
       return false;
     }
 
-    std::vector<geometry_msgs::PoseStamped> transformed_plan;
     //get the global plan in our frame
-    if (!transformGlobalPlan(*tf_, global_plan_, global_pose, *costmap_, global_frame_, transformed_plan)) {
+    if (!transformGlobalPlan(*tf_, global_plan_, global_pose, *costmap_, global_frame_, transformed_plan_)) {
       ROS_WARN("Could not transform the global plan to the frame of the controller");
       return false;
     }
 
     //now we'll prune the plan based on the position of the robot
     if(prune_plan_)
-      prunePlan(global_pose, transformed_plan, global_plan_);
+      prunePlan(global_pose, transformed_plan_, global_plan_);
 
     tf::Stamped<tf::Pose> drive_cmds;
     drive_cmds.frame_id_ = robot_base_frame_;
@@ -411,9 +519,14 @@ namespace base_local_planner {
     */
 
     //if the global plan passed in is empty... we won't do anything
-    if(transformed_plan.empty())
+    if(transformed_plan_.empty())
       return false;
 
+    //hand the plan to the controller without copying it, the buffer of its previous plan is filled next cycle
+    //we need to do this to make sure that the trajectory planner updates its path distance and goal distance grids
+    tc_->swapPlan(transformed_plan_);
+    const std::vector<geometry_msgs::PoseStamped>& transformed_plan = tc_->getPlan();
+
     tf::Stamped<tf::Pose> goal_point;
     tf::poseStampedMsgToTF(transformed_plan.back(), goal_point);
     //we assume the global goal is the last point in the global plan
@@ -443,30 +556,35 @@ namespace base_local_planner {
         rotating_to_goal_ = false;
         xy_tolerance_latch_ = false;
         reached_goal_ = true;
+        tc_->recordCommand(0.0, 0.0, 0.0);
       } else {
-        //we need to call the next two lines to make sure that the trajectory
-        //planner updates its path distance and goal distance grids
-        tc_->updatePlan(transformed_plan);
         Trajectory path = tc_->findBestPath(global_pose, robot_vel, drive_cmds);
-        map_viz_.publishCostCloud(costmap_);
+        recordInputAges(global_pose, robot_vel, transformed_plan);
+        recordMemoryUsage(allocations, allocated_bytes);
+        recordSchedulerLoad();
+        recordSearchPhases();
+        publishCostCloud();
 
         //copy over the odometry information
         nav_msgs::Odometry base_odom;
         odom_helper_.getOdom(base_odom);
 
         //if we're not stopped yet... we want to stop... taking into account the acceleration limits of the robot
+        bool valid_cmd;
         if ( ! rotating_to_goal_ && !base_local_planner::stopped(base_odom, rot_stopped_velocity_, trans_stopped_velocity_)) {
-          if ( ! stopWithAccLimits(global_pose, robot_vel, cmd_vel)) {
-            return false;
-          }
+          valid_cmd = stopWithAccLimits(global_pose, robot_vel, cmd_vel);
         }
         //if we're stopped... then we want to rotate to goal
         else{
           //set this so that we know its OK to be moving
           rotating_to_goal_ = true;
-          if(!rotateToGoal(global_pose, robot_vel, goal_th, cmd_vel)) {
-            return false;
-          }
+          valid_cmd = rotateToGoal(global_pose, robot_vel, goal_th, cmd_vel);
+        }
+
+        //the base gets this command rather than the one findBestPath chose, so predict the next start state from it
+        tc_->recordCommand(cmd_vel.linear.x, cmd_vel.linear.y, cmd_vel.angular.z);
+        if (!valid_cmd) {
+          return false;
         }
       }
 
@@ -478,12 +596,14 @@ namespace base_local_planner {
       return true;
     }
 
-    tc_->updatePlan(transformed_plan);
-
     //compute what trajectory to drive along
     Trajectory path = tc_->findBestPath(global_pose, robot_vel, drive_cmds);
+    recordInputAges(global_pose, robot_vel, transformed_plan);
+    recordMemoryUsage(allocations, allocated_bytes);
+    recordSchedulerLoad();
+    recordSearchPhases();
 
-    map_viz_.publishCostCloud(costmap_);
+    publishCostCloud();
     /* For timing uncomment
     gettimeofday(&end, NULL);
     start_t = start.tv_sec + double(start.tv_usec) / 1e6;
@@ -531,7 +651,155 @@ namespace base_local_planner {
     return true;
   }
 
+  static void publishInputLatency(const ros::Publisher& pub, const LatencyHistogram& histogram) {
+    InputLatency msg;
+    msg.name = histogram.getName();
+    msg.bucket_bounds = histogram.getBucketBounds();
+    msg.counts.assign(histogram.getCounts().begin(), histogram.getCounts().end());
+    msg.last = histogram.getLast();
+    msg.max = histogram.getMax();
+    pub.publish(msg);
+  }
+
+  void TrajectoryPlannerROS::recordInputAges(const tf::Stamped<tf::Pose>& global_pose, const tf::Stamped<tf::Pose>& robot_vel,
+      const std::vector<geometry_msgs::PoseStamped>& transformed_plan) {
+    ros::Time now = ros::Time::now();
+
+    //inputs that were never stamped, like odometry before the first message, have no age
+    ros::Time newest;
+    if (!global_pose.stamp_.isZero()) {
+      pose_age_.addSample((now - global_pose.stamp_).toSec());
+      newest = global_pose.stamp_;
+    }
+    if (!robot_vel.stamp_.isZero()) {
+      odom_age_.addSample((now - robot_vel.stamp_).toSec());
+      newest = std::max(newest, robot_vel.stamp_);
+    }
+    if (!transformed_plan.empty() && !transformed_plan[0].header.stamp.isZero()) {
+      plan_age_.addSample((now - transformed_plan[0].header.stamp).toSec());
+    }
+    if (!newest.isZero()) {
+      end_to_end_age_.addSample((now - newest).toSec());
+    }
+
+    if (latency_pub_.getNumSubscribers() > 0) {
+      publishInputLatency(latency_pub_, pose_age_);
+      publishInputLatency(latency_pub_, odom_age_);
+      publishInputLatency(latency_pub_, plan_age_);
+      publishInputLatency(latency_pub_, end_to_end_age_);
+    }
+  }
+
+  void TrajectoryPlannerROS::recordMemoryUsage(uint64_t cycle_allocations, uint64_t cycle_allocated_bytes) {
+    //the peak is taken every cycle, so that it only covers this one
+    unsigned int peak_buffers = tc_->takePeakTrajectoryBuffers();
+    if (memory_pub_.getNumSubscribers() == 0) {
+      return;
+    }
+
+    PlannerMemory msg;
+    msg.allocations_counted = allocationsCounted();
+    uint64_t allocations, allocated_bytes;
+    getAllocationCount(allocations, allocated_bytes);
+    msg.allocations = allocations - cycle_allocations;
+    msg.allocated_bytes = allocated_bytes - cycle_allocated_bytes;
+    msg.trajectory_buffers = tc_->getTrajectoryBuffers();
+    msg.peak_trajectory_buffers = peak_buffers;
+    tc_->getMemoryUsage(msg.structures, msg.resident_bytes);
+    memory_pub_.publish(msg);
+  }
+
+  void TrajectoryPlannerROS::cancelBackgroundTasks() {
+    if (!background_tasks_) {
+      return;
+    }
+    {
+      boost::mutex::scoped_lock lock(background_mutex_);
+      stop_background_ = true;
+    }
+    background_tasks_->cancel();
+    boost::mutex::scoped_lock lock(background_mutex_);
+    stop_background_ = false;
+  }
+
+  void TrajectoryPlannerROS::publishCostCloud() {
+    //follow the controller to a new scheduler once the tasks on the old one are done
+    boost::shared_ptr<TaskScheduler> scheduler = tc_->getScheduler();
+    if (scheduler != scheduler_) {
+      background_tasks_.reset();
+      scheduler_ = scheduler;
+      background_tasks_.reset(new TaskGroup(scheduler_.get(), TaskScheduler::BACKGROUND));
+    }
+    background_tasks_->run(boost::bind(&TrajectoryPlannerROS::publishLockedCostCloud, this));
+  }
+
+  void TrajectoryPlannerROS::publishLockedCostCloud() {
+    //the cycle that queued this task may still hold the costmap, and the next one may hold it while it waits
+    //for this task, so poll for the lock and give up once the next cycle asks the background tasks to stop
+    boost::unique_lock<costmap_2d::Costmap2D::mutex_t> lock(*(costmap_->getMutex()), boost::defer_lock);
+    while (!lock.try_lock()) {
+      {
+        boost::mutex::scoped_lock stop_lock(background_mutex_);
+        if (stop_background_) {
+          ROS_DEBUG("Skipping the cost cloud, the next cycle started");
+          return;
+        }
+      }
+      boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+    }
+    map_viz_.publishCostCloud(costmap_);
+  }
+
+  void TrajectoryPlannerROS::recordSchedulerLoad() {
+    boost::shared_ptr<TaskScheduler> scheduler = tc_->getScheduler();
+    ros::WallTime now = ros::WallTime::now();
+    double period = (now - last_lane_stats_time_).toSec();
+
+    //start over on the first cycle, on a new scheduler and after cycles nobody listened to
+    bool publish = scheduler == stats_scheduler_ && !last_lane_stats_time_.isZero() && period > 0.0 &&
+      scheduler_pub_.getNumSubscribers() > 0;
+    static const char* lane_names[TaskScheduler::NUM_LANES] = {"control", "background"};
+    for (unsigned int lane = 0; lane < TaskScheduler::NUM_LANES; ++lane) {
+      TaskScheduler::LaneStats stats = scheduler->getLaneStats((TaskScheduler::Lane) lane);
+      if (publish) {
+        const TaskScheduler::LaneStats& last = last_lane_stats_[lane];
+        SchedulerLane msg;
+        msg.lane = lane_names[lane];
+        msg.threads = scheduler->getNumThreads();
+        msg.tasks = stats.tasks - last.tasks;
+        msg.cancelled = stats.cancelled - last.cancelled;
+        //without workers the tasks run in the planning thread, so that is the one thread they use
+        msg.utilization = (stats.busy_time - last.busy_time) / (period * std::max(1u, scheduler->getNumThreads()));
+        msg.mean_wait = msg.tasks > 0 ? (stats.wait_time - last.wait_time) / msg.tasks : 0.0;
+        scheduler_pub_.publish(msg);
+      }
+      last_lane_stats_[lane] = stats;
+    }
+    stats_scheduler_ = scheduler;
+    last_lane_stats_time_ = now;
+  }
+
+  void TrajectoryPlannerROS::recordSearchPhases() {
+    bool publish = search_phase_pub_.getNumSubscribers() > 0;
+    static const char* phase_names[TrajectoryPlanner::NUM_SEARCH_PHASES] = {"forward", "strafe", "strafe_forward", "rotate"};
+    for (unsigned int phase = 0; phase < TrajectoryPlanner::NUM_SEARCH_PHASES; ++phase) {
+      const TrajectoryPlanner::SearchPhaseStats& stats = tc_->getSearchPhaseStats((TrajectoryPlanner::SearchPhase) phase);
+      if (publish) {
+        const TrajectoryPlanner::SearchPhaseStats& last = last_search_phase_stats_[phase];
+        SearchPhase msg;
+        msg.phase = phase_names[phase];
+        msg.runs = stats.runs - last.runs;
+        msg.accepted = stats.accepted - last.accepted;
+        msg.skipped = stats.skipped - last.skipped;
+        msg.rollouts = stats.rollouts - last.rollouts;
+        search_phase_pub_.publish(msg);
+      }
+      last_search_phase_stats_[phase] = stats;
+    }
+  }
+
   bool TrajectoryPlannerROS::checkTrajectory(double vx_samp, double vy_samp, double vtheta_samp, bool update_map){
+    cancelBackgroundTasks();
     tf::Stamped<tf::Pose> global_pose;
     if(costmap_ros_->getRobotPose(global_pose)){
       if(update_map){
@@ -564,6 +832,7 @@ namespace base_local_planner {
 
   double TrajectoryPlannerROS::scoreTrajectory(double vx_samp, double vy_samp, double vtheta_samp, bool update_map){
     // Copy of checkTrajectory that returns a score instead of True / False
+    cancelBackgroundTasks();
     tf::Stamped<tf::Pose> global_pose;
     if(costmap_ros_->getRobotPose(global_pose)){
       if(update_map){
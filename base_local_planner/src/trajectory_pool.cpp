@@ -0,0 +1,93 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the Willow Garage nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+#include <base_local_planner/trajectory_pool.h>
+#include <base_local_planner/memory_usage.h>
+
+#include <algorithm>
+
+namespace base_local_planner {
+
+  TrajectoryPool::~TrajectoryPool() {
+    for (unsigned int i = 0; i < buffers_.size(); ++i) {
+      delete buffers_[i];
+    }
+  }
+
+  Trajectory* TrajectoryPool::acquire(unsigned int num_pts) {
+    Trajectory* traj;
+    {
+      boost::mutex::scoped_lock lock(mutex_);
+      if (free_.empty()) {
+        traj = new Trajectory();
+        buffers_.push_back(traj);
+      } else {
+        traj = free_.back();
+        free_.pop_back();
+      }
+      peak_in_use_ = std::max(peak_in_use_, (unsigned int) (buffers_.size() - free_.size()));
+    }
+    //reserving outside the lock, buffers only grow so after warm up this does not allocate
+    traj->resetPoints();
+    traj->reservePoints(num_pts);
+    traj->cost_ = -1.0;
+    return traj;
+  }
+
+  void TrajectoryPool::release(Trajectory* traj) {
+    boost::mutex::scoped_lock lock(mutex_);
+    free_.push_back(traj);
+  }
+
+  unsigned int TrajectoryPool::getSize() {
+    boost::mutex::scoped_lock lock(mutex_);
+    return buffers_.size();
+  }
+
+  unsigned int TrajectoryPool::takePeakInUse() {
+    boost::mutex::scoped_lock lock(mutex_);
+    unsigned int peak = peak_in_use_;
+    peak_in_use_ = buffers_.size() - free_.size();
+    return peak;
+  }
+
+  size_t TrajectoryPool::getMemoryUsage() {
+    boost::mutex::scoped_lock lock(mutex_);
+    size_t bytes = vectorBytes(buffers_) + vectorBytes(free_) + buffers_.size() * sizeof(Trajectory);
+    for (unsigned int i = 0; i < buffers_.size(); ++i) {
+      bytes += buffers_[i]->getMemoryUsage();
+    }
+    return bytes;
+  }
+
+};
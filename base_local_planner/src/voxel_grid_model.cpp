@@ -35,6 +35,8 @@
 * Author: Eitan Marder-Eppstein
 *********************************************************************/
 #include <base_local_planner/voxel_grid_model.h>
+#include <base_local_planner/line_iterator.h>
+#include <base_local_planner/memory_usage.h>
 
 using namespace std;
 using namespace costmap_2d;
@@ -90,6 +92,67 @@ namespace base_local_planner {
     return 0.0;
   }
 
+  void VoxelGridModel::setFootprintSections(const std::vector<FootprintSection>& sections){
+    sections_ = sections;
+    section_min_z_.resize(sections_.size());
+    section_max_z_.resize(sections_.size());
+    int size_z = obstacle_grid_.sizeZ();
+    for(unsigned int i = 0; i < sections_.size(); ++i){
+      //a section entirely above or below the grid can not hit anything it knows about
+      int min_z = (int) floor((sections_[i].min_z - origin_z_) / z_resolution_);
+      int max_z = (int) floor((sections_[i].max_z - origin_z_) / z_resolution_);
+      section_min_z_[i] = std::max(min_z, 0);
+      section_max_z_[i] = std::min(max_z, size_z - 1);
+    }
+  }
+
+  double VoxelGridModel::footprintCost(double x, double y, double theta, const std::vector<geometry_msgs::Point>& footprint_spec,
+      double inscribed_radius, double circumscribed_radius){
+    if(sections_.empty())
+      return WorldModel::footprintCost(x, y, theta, footprint_spec, inscribed_radius, circumscribed_radius);
+
+    double cos_th = cos(theta);
+    double sin_th = sin(theta);
+    for(unsigned int i = 0; i < sections_.size(); ++i){
+      if(sectionCost(x, y, cos_th, sin_th, sections_[i].polygon, section_min_z_[i], section_max_z_[i]) < 0)
+        return -1.0;
+    }
+    return 0.0;
+  }
+
+  double VoxelGridModel::sectionCost(double x, double y, double cos_th, double sin_th,
+      const std::vector<geometry_msgs::Point>& polygon, int min_z, int max_z){
+    if(max_z < min_z)
+      return 0.0;
+
+    //lay down the corners of the section in the grid, a section of less than 3 points is checked at the robot center
+    unsigned int size_x = obstacle_grid_.sizeX(), size_y = obstacle_grid_.sizeY();
+    unsigned int num_points = std::max((unsigned int) polygon.size(), 1u);
+    std::vector<int> cells_x(num_points), cells_y(num_points);
+    for(unsigned int i = 0; i < num_points; ++i){
+      double px = x, py = y;
+      if(polygon.size() >= 3){
+        px += polygon[i].x * cos_th - polygon[i].y * sin_th;
+        py += polygon[i].x * sin_th + polygon[i].y * cos_th;
+      }
+      unsigned int cell_x, cell_y;
+      if(!worldToMap2D(px, py, cell_x, cell_y) || cell_x >= size_x || cell_y >= size_y)
+        return -1.0;
+      cells_x[i] = cell_x;
+      cells_y[i] = cell_y;
+    }
+
+    //a marked voxel blocks the section if it is at its height
+    for(unsigned int i = 0; i < num_points; ++i){
+      unsigned int j = (i + 1) % num_points;
+      for(LineIterator line(cells_x[i], cells_y[i], cells_x[j], cells_y[j]); line.isValid(); line.advance()){
+        if(obstacle_grid_.columnOccupied(line.getX(), line.getY(), min_z, max_z))
+          return -1.0;
+      }
+    }
+    return 0.0;
+  }
+
   //calculate the cost of a ray-traced line
   double VoxelGridModel::lineCost(int x0, int x1, 
       int y0, int y1){
@@ -172,7 +235,7 @@ namespace base_local_planner {
 
   double VoxelGridModel::pointCost(int x, int y){
     //if the cell is in an obstacle the path is invalid
-    if(obstacle_grid_.getVoxelColumn(x, y)){
+    if(obstacle_grid_.columnOccupied(x, y, 0, obstacle_grid_.sizeZ())){
       return -1;
     }
 
@@ -261,27 +324,94 @@ namespace base_local_planner {
 
       unsigned int point_x, point_y, point_z;
       if(worldToMap3D(wpx, wpy, wpz, point_x, point_y, point_z)){
-        obstacle_grid_.clearVoxelLine(sensor_x, sensor_y, sensor_z, point_x, point_y, point_z);
+        obstacle_grid_.clearVoxelLine(sensor_x + 0.5, sensor_y + 0.5, sensor_z + 0.5, point_x + 0.5, point_y + 0.5, point_z + 0.5);
       }
     }
   }
 
-  void VoxelGridModel::getPoints(pcl::PointCloud<pcl::PointXYZ>& cloud){
-    for(unsigned int i = 0; i < obstacle_grid_.sizeX(); ++i){
-      for(unsigned int j = 0; j < obstacle_grid_.sizeY(); ++j){
-        for(unsigned int k = 0; k < obstacle_grid_.sizeZ(); ++k){
-          if(obstacle_grid_.getVoxel(i, j, k)){
-            double wx, wy, wz;
-            mapToWorld3D(i, j, k, wx, wy, wz);
-            pcl::PointXYZ pt;
-            pt.x = wx;
-            pt.y = wy;
-            pt.z = wz;
-            cloud.points.push_back(pt);
-          }
-        }
+  void VoxelGridModel::updateWorld(const std::vector<geometry_msgs::Point>& footprint, const sensor_msgs::LaserScan& scan,
+      const geometry_msgs::Point& sensor_origin, double sensor_yaw){
+    //a level scan outside of the heights of the grid has nothing to clear or mark
+    if(sensor_origin.z < 0.0 || sensor_origin.z >= max_z_)
+      return;
+
+    unsigned int sensor_x, sensor_y, sensor_z;
+    if(!worldToMap3D(sensor_origin.x, sensor_origin.y, sensor_origin.z, sensor_x, sensor_y, sensor_z))
+      return;
+
+    unsigned int num_beams = scan.ranges.size();
+    beams_.update(scan.angle_min, scan.angle_increment, num_beams);
+    double cos_yaw = cos(sensor_yaw);
+    double sin_yaw = sin(sensor_yaw);
+    double raytrace_range = 10.0;
+
+    //a single pass over the ranges raytraces every beam and keeps its hit, marking waits until all beams have cleared
+    scan_hits_.clear();
+    for(unsigned int i = 0; i < num_beams; ++i){
+      float range = scan.ranges[i];
+      double clear_range = 0.0;
+      bool hit = false;
+      //readings past the maximum range, infinite ones included, saw no obstacle up to it... NaNs and short readings saw nothing
+      if(range >= scan.range_min && range < scan.range_max){
+        clear_range = range;
+        hit = true;
+      }
+      else if(range >= scan.range_max)
+        clear_range = scan.range_max;
+      else
+        continue;
+
+      double dir_x = beams_.cos(i) * cos_yaw - beams_.sin(i) * sin_yaw;
+      double dir_y = beams_.cos(i) * sin_yaw + beams_.sin(i) * cos_yaw;
+
+      double trace_range = min(clear_range, raytrace_range);
+      unsigned int point_x, point_y, point_z;
+      if(worldToMap3D(sensor_origin.x + trace_range * dir_x, sensor_origin.y + trace_range * dir_y, sensor_origin.z,
+            point_x, point_y, point_z)){
+        obstacle_grid_.clearVoxelLine(sensor_x + 0.5, sensor_y + 0.5, sensor_z + 0.5, point_x + 0.5, point_y + 0.5, point_z + 0.5);
+      }
+
+      if(hit && (double)range * range < sq_obstacle_range_){
+        pcl::PointXYZ pt;
+        pt.x = sensor_origin.x + range * dir_x;
+        pt.y = sensor_origin.y + range * dir_y;
+        pt.z = sensor_origin.z;
+        scan_hits_.push_back(pt);
       }
     }
+
+    for(unsigned int i = 0; i < scan_hits_.size(); ++i)
+      insert(scan_hits_[i]);
+  }
+
+  void VoxelGridModel::updateOrigin(double new_origin_x, double new_origin_y){
+    //project the new origin into the grid, the same way the costmap moves its own
+    int cell_ox = int((new_origin_x - origin_x_) / xy_resolution_);
+    int cell_oy = int((new_origin_y - origin_y_) / xy_resolution_);
+    if(cell_ox == 0 && cell_oy == 0)
+      return;
+
+    origin_x_ += cell_ox * xy_resolution_;
+    origin_y_ += cell_oy * xy_resolution_;
+    obstacle_grid_.shift(cell_ox, cell_oy);
+  }
+
+  void VoxelGridModel::getPoints(pcl::PointCloud<pcl::PointXYZ>& cloud){
+    std::vector<VoxelCell> cells;
+    obstacle_grid_.getMarkedVoxels(cells);
+    for(unsigned int i = 0; i < cells.size(); ++i){
+      double wx, wy, wz;
+      mapToWorld3D(cells[i].x, cells[i].y, cells[i].z, wx, wy, wz);
+      pcl::PointXYZ pt;
+      pt.x = wx;
+      pt.y = wy;
+      pt.z = wz;
+      cloud.points.push_back(pt);
+    }
+  }
+
+  size_t VoxelGridModel::getMemoryUsage(){
+    return obstacle_grid_.getMemoryUsage() + vectorBytes(scan_hits_);
   }
 
 };
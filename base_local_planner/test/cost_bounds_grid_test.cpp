@@ -0,0 +1,122 @@
+/*
+ * cost_bounds_grid_test.cpp
+ */
+#include <cstdlib>
+#include <algorithm>
+
+#include <gtest/gtest.h>
+
+#include <costmap_2d/cost_values.h>
+#include <base_local_planner/cost_bounds_grid.h>
+
+namespace base_local_planner {
+
+TEST(CostBoundsGridTest, footprintRadius){
+  std::vector<geometry_msgs::Point> footprint;
+  EXPECT_EQ(0, CostBoundsGrid::footprintRadius(footprint, 0.1));
+  geometry_msgs::Point pt;
+  pt.x = 0.3; pt.y = 0.4;
+  footprint.push_back(pt);
+  pt.x = 0.3; pt.y = -0.4;
+  footprint.push_back(pt);
+  //less than 3 points is a point robot
+  EXPECT_EQ(0, CostBoundsGrid::footprintRadius(footprint, 0.1));
+  pt.x = -0.3; pt.y = 0.0;
+  footprint.push_back(pt);
+  EXPECT_EQ(5, CostBoundsGrid::footprintRadius(footprint, 0.1));
+}
+
+TEST(CostBoundsGridTest, legalCostLimit){
+  std::vector<geometry_msgs::Point> footprint;
+  geometry_msgs::Point pt;
+  footprint.push_back(pt);
+  //a point robot is in collision on an inscribed cell
+  EXPECT_EQ(costmap_2d::INSCRIBED_INFLATED_OBSTACLE, CostBoundsGrid::legalCostLimit(footprint));
+  pt.x = 0.3;
+  footprint.push_back(pt);
+  pt.y = 0.3;
+  footprint.push_back(pt);
+  EXPECT_EQ(costmap_2d::LETHAL_OBSTACLE, CostBoundsGrid::legalCostLimit(footprint));
+}
+
+TEST(CostBoundsGridTest, boundsMatchBruteForce){
+  srand(42);
+  for (unsigned int radius = 0; radius < 4; ++radius) {
+    costmap_2d::Costmap2D costmap(13, 9, 0.1, 0.0, 0.0);
+    for (unsigned int y = 0; y < 9; ++y) {
+      for (unsigned int x = 0; x < 13; ++x) {
+        costmap.setCost(x, y, rand() % 256);
+      }
+    }
+    CostBoundsGrid bounds;
+    bounds.setRadius(radius);
+    bounds.update(costmap);
+
+    for (int y = 0; y < 9; ++y) {
+      for (int x = 0; x < 13; ++x) {
+        unsigned char max_cost = 0, min_cost = 255;
+        for (int wy = std::max(0, y - (int)radius); wy <= std::min(8, y + (int)radius); ++wy) {
+          for (int wx = std::max(0, x - (int)radius); wx <= std::min(12, x + (int)radius); ++wx) {
+            max_cost = std::max(max_cost, costmap.getCost(wx, wy));
+            min_cost = std::min(min_cost, costmap.getCost(wx, wy));
+          }
+        }
+        unsigned char cost;
+        bool inside = x >= (int)radius && y >= (int)radius && x + (int)radius < 13 && y + (int)radius < 9;
+        EXPECT_EQ(inside, bounds.maxCost(x, y, cost));
+        if (inside) {
+          EXPECT_EQ(max_cost, cost);
+        }
+        EXPECT_EQ(min_cost, bounds.minCost(x, y));
+      }
+    }
+  }
+}
+
+
+TEST(CostBoundsGridTest, regionUpdateMatchesFull){
+  srand(7);
+  costmap_2d::Costmap2D costmap(20, 15, 0.1, 0.0, 0.0);
+  for (unsigned int y = 0; y < 15; ++y) {
+    for (unsigned int x = 0; x < 20; ++x) {
+      costmap.setCost(x, y, rand() % 256);
+    }
+  }
+  CostBoundsGrid incremental, full;
+  incremental.setRadius(2);
+  full.setRadius(2);
+  incremental.update(costmap);
+
+  for (unsigned int i = 0; i < 10; ++i) {
+    unsigned int x0 = rand() % 20, y0 = rand() % 15;
+    unsigned int x1 = std::min(19u, x0 + rand() % 4), y1 = std::min(14u, y0 + rand() % 4);
+    for (unsigned int y = y0; y <= y1; ++y) {
+      for (unsigned int x = x0; x <= x1; ++x) {
+        costmap.setCost(x, y, rand() % 256);
+      }
+    }
+    incremental.updateRegion(costmap, x0, y0, x1, y1);
+    full.update(costmap);
+    for (unsigned int y = 0; y < 15; ++y) {
+      for (unsigned int x = 0; x < 20; ++x) {
+        unsigned char incremental_cost = 0, full_cost = 0;
+        EXPECT_EQ(full.maxCost(x, y, full_cost), incremental.maxCost(x, y, incremental_cost));
+        EXPECT_EQ(full_cost, incremental_cost);
+        EXPECT_EQ(full.minCost(x, y), incremental.minCost(x, y));
+      }
+    }
+  }
+
+  //a new radius needs all the bounds again, even without changed cells
+  incremental.setRadius(3);
+  full.setRadius(3);
+  incremental.updateRegion(costmap, 1, 1, 0, 0);
+  full.update(costmap);
+  for (unsigned int y = 0; y < 15; ++y) {
+    for (unsigned int x = 0; x < 20; ++x) {
+      EXPECT_EQ(full.minCost(x, y), incremental.minCost(x, y));
+    }
+  }
+}
+
+}
@@ -0,0 +1,77 @@
+/*
+ * costmap_mirror_test.cpp
+ */
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <base_local_planner/costmap_mirror.h>
+
+namespace base_local_planner {
+
+TEST(CostmapMirrorTest, occupancyRoundTrip){
+  //the translation costmap_2d applies before publishing
+  for (int cost = 0; cost < 256; ++cost) {
+    int value;
+    if (cost == costmap_2d::NO_INFORMATION) {
+      value = -1;
+    } else if (cost == costmap_2d::LETHAL_OBSTACLE) {
+      value = 100;
+    } else if (cost == costmap_2d::INSCRIBED_INFLATED_OBSTACLE) {
+      value = 99;
+    } else if (cost == costmap_2d::FREE_SPACE) {
+      value = 0;
+    } else {
+      value = 1 + (97 * (cost - 1)) / 251;
+    }
+    unsigned char mirrored = CostmapMirror::occupancyToCost(value);
+    EXPECT_GE(mirrored, cost);
+    if (cost >= costmap_2d::INSCRIBED_INFLATED_OBSTACLE || cost == costmap_2d::FREE_SPACE) {
+      EXPECT_EQ(cost, mirrored);
+    } else {
+      EXPECT_EQ(value, 1 + (97 * (mirrored - 1)) / 251);
+    }
+  }
+}
+
+TEST(CostmapMirrorTest, patchesTrackChanges){
+  CostmapMirror mirror;
+  std::vector<unsigned char> costs(10 * 8, costmap_2d::FREE_SPACE);
+  mirror.setMap(10, 8, 0.05, 1.0, 2.0, &costs[0]);
+
+  unsigned int x0, y0, x1, y1;
+  bool resized;
+  ASSERT_TRUE(mirror.takeChanges(x0, y0, x1, y1, resized));
+  EXPECT_TRUE(resized);
+  EXPECT_EQ(0u, x0);
+  EXPECT_EQ(7u, y1);
+  EXPECT_FALSE(mirror.takeChanges(x0, y0, x1, y1, resized));
+
+  //the patch hangs over the lower left corner of the map
+  std::vector<unsigned char> patch(3 * 3, costmap_2d::LETHAL_OBSTACLE);
+  EXPECT_TRUE(mirror.applyPatch(-1, -1, 3, 3, &patch[0]));
+  EXPECT_TRUE(mirror.applyPatch(6, 4, 2, 1, &patch[0]));
+  EXPECT_FALSE(mirror.applyPatch(10, 0, 3, 3, &patch[0]));
+  ASSERT_TRUE(mirror.takeChanges(x0, y0, x1, y1, resized));
+  EXPECT_FALSE(resized);
+  EXPECT_EQ(0u, x0);
+  EXPECT_EQ(0u, y0);
+  EXPECT_EQ(7u, x1);
+  EXPECT_EQ(4u, y1);
+  EXPECT_EQ(costmap_2d::LETHAL_OBSTACLE, mirror.getCostmap().getCost(1, 1));
+  EXPECT_EQ(costmap_2d::FREE_SPACE, mirror.getCostmap().getCost(2, 1));
+  EXPECT_EQ(costmap_2d::LETHAL_OBSTACLE, mirror.getCostmap().getCost(7, 4));
+
+  //the same map again only changes the cells that differ
+  costs[5 * 10 + 3] = costmap_2d::INSCRIBED_INFLATED_OBSTACLE;
+  mirror.setMap(10, 8, 0.05, 1.0, 2.0, &costs[0]);
+  ASSERT_TRUE(mirror.takeChanges(x0, y0, x1, y1, resized));
+  EXPECT_FALSE(resized);
+  EXPECT_EQ(0u, x0);
+  EXPECT_EQ(0u, y0);
+  EXPECT_EQ(7u, x1);
+  EXPECT_EQ(5u, y1);
+  EXPECT_EQ(costmap_2d::FREE_SPACE, mirror.getCostmap().getCost(1, 1));
+}
+
+}
@@ -0,0 +1,131 @@
+/*
+ * footprint_set_test.cpp
+ */
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <base_local_planner/footprint_set.h>
+#include <base_local_planner/costmap_model.h>
+
+#include "scenario_generator.h"
+
+namespace base_local_planner {
+
+TEST(FootprintSetTest, noOutlinesForPointRobot){
+  std::vector<geometry_msgs::Point> footprint(1);
+  FootprintSet footprint_set(footprint, 0.05, 16);
+  EXPECT_EQ(0u, footprint_set.getHeadingBins());
+  EXPECT_FALSE(footprint_set.hasOutlines(0.05));
+}
+
+TEST(FootprintSetTest, headingBins){
+  std::vector<geometry_msgs::Point> footprint;
+  geometry_msgs::Point pt;
+  pt.x = 0.4; pt.y = 0.1;
+  footprint.push_back(pt);
+  pt.x = 0.4; pt.y = -0.1;
+  footprint.push_back(pt);
+  pt.x = -0.4; pt.y = -0.1;
+  footprint.push_back(pt);
+  pt.x = -0.4; pt.y = 0.1;
+  footprint.push_back(pt);
+  FootprintSet footprint_set(footprint, 0.05, 8);
+  EXPECT_EQ(8u, footprint_set.getHeadingBins());
+  EXPECT_TRUE(footprint_set.hasOutlines(0.05));
+  EXPECT_FALSE(footprint_set.hasOutlines(0.1));
+
+  //the same bin however the heading is wrapped, long along x at heading 0 and along y a quarter turn later
+  EXPECT_EQ(&footprint_set.getOutline(0.0), &footprint_set.getOutline(2.0 * M_PI));
+  EXPECT_EQ(&footprint_set.getOutline(-0.1), &footprint_set.getOutline(0.1));
+  EXPECT_EQ(&footprint_set.getOutline(M_PI_2), &footprint_set.getOutline(-3.0 * M_PI_2));
+  const FootprintOutline& along_x = footprint_set.getOutline(0.0);
+  const FootprintOutline& along_y = footprint_set.getOutline(M_PI_2);
+  EXPECT_GT(along_x.max_dx - along_x.min_dx, along_x.max_dy - along_x.min_dy);
+  EXPECT_GT(along_y.max_dy - along_y.min_dy, along_y.max_dx - along_y.min_dx);
+}
+
+//the outline cells have to catch every collision the polygon rasterization catches
+TEST(FootprintSetTest, outlineAsStrictAsPolygon){
+  ScenarioParams params;
+  params.type = CLUTTERED_ROOM;
+  params.obstacle_density = 0.1;
+  params.seed = 3;
+  ScenarioGenerator generator(params);
+  boost::shared_ptr<costmap_2d::Costmap2D> costmap = generator.createCostmap();
+  std::vector<geometry_msgs::PoseStamped> plan;
+  generator.generate(*costmap, plan);
+  CostmapModel model(*costmap);
+
+  std::vector<geometry_msgs::Point> footprint;
+  geometry_msgs::Point pt;
+  pt.x = 0.3; pt.y = 0.2;
+  footprint.push_back(pt);
+  pt.x = 0.3; pt.y = -0.2;
+  footprint.push_back(pt);
+  pt.x = -0.25; pt.y = -0.25;
+  footprint.push_back(pt);
+  pt.x = -0.25; pt.y = 0.25;
+  footprint.push_back(pt);
+  FootprintSet footprint_set(footprint, params.resolution, 32);
+
+  unsigned int num_legal = 0;
+  for (unsigned int i = 0; i < 2000; ++i) {
+    double x = 0.4 + 4.2 * ((i * 7919) % 1000) / 1000.0;
+    double y = 0.4 + 4.2 * ((i * 104729) % 997) / 997.0;
+    double theta = 2.0 * M_PI * ((i * 31) % 360) / 360.0 - M_PI;
+    double polygon_cost = model.footprintCost(x, y, theta, footprint, 0.2, 0.4);
+    unsigned int cell_x, cell_y;
+    ASSERT_TRUE(costmap->worldToMap(x, y, cell_x, cell_y));
+    double outline_cost = model.outlineCost(cell_x, cell_y, footprint_set.getOutline(theta));
+    if (polygon_cost < 0) {
+      EXPECT_LT(outline_cost, 0) << x << " " << y << " " << theta;
+    } else if (outline_cost >= 0) {
+      EXPECT_GE(outline_cost, polygon_cost);
+      ++num_legal;
+    }
+  }
+  //and not reject everything
+  EXPECT_GT(num_legal, 0u);
+}
+
+//the polygon check must not touch a cell outside the outline, for any heading and any position of the robot within its cell
+TEST(FootprintSetTest, outlineHoldsPolygonCells){
+  std::vector<geometry_msgs::Point> footprint;
+  geometry_msgs::Point pt;
+  pt.x = 0.35; pt.y = 0.0;
+  footprint.push_back(pt);
+  pt.x = 0.12; pt.y = -0.27;
+  footprint.push_back(pt);
+  pt.x = -0.23; pt.y = -0.19;
+  footprint.push_back(pt);
+  pt.x = -0.26; pt.y = 0.17;
+  footprint.push_back(pt);
+  pt.x = 0.09; pt.y = 0.29;
+  footprint.push_back(pt);
+  FootprintSet footprint_set(footprint, 0.05, 16);
+
+  //every cell is an obstacle except the outline cells of the pose being checked
+  costmap_2d::Costmap2D costmap(40, 40, 0.05, 0.0, 0.0, costmap_2d::LETHAL_OBSTACLE);
+  CostmapModel model(costmap);
+  srand(17);
+  for (unsigned int i = 0; i < 200000; ++i) {
+    double x = 0.95 + 0.1 * rand() / (double) RAND_MAX;
+    double y = 0.95 + 0.1 * rand() / (double) RAND_MAX;
+    double theta = 2.0 * M_PI * rand() / (double) RAND_MAX - M_PI;
+    unsigned int cell_x, cell_y;
+    ASSERT_TRUE(costmap.worldToMap(x, y, cell_x, cell_y));
+    const FootprintOutline& outline = footprint_set.getOutline(theta);
+    for (unsigned int j = 0; j < outline.dx.size(); ++j) {
+      costmap.setCost(cell_x + outline.dx[j], cell_y + outline.dy[j], costmap_2d::FREE_SPACE);
+    }
+    ASSERT_GE(model.footprintCost(x, y, theta, footprint, 0.0, 0.0), 0.0) << x << " " << y << " " << theta;
+    for (unsigned int j = 0; j < outline.dx.size(); ++j) {
+      costmap.setCost(cell_x + outline.dx[j], cell_y + outline.dy[j], costmap_2d::LETHAL_OBSTACLE);
+    }
+  }
+}
+
+}
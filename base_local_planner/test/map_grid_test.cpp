@@ -5,11 +5,18 @@
  *      Author: tkruse
  */
 #include <queue>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <cstdio>
 
 #include <gtest/gtest.h>
+#include <boost/date_time/posix_time/posix_time.hpp>
 
 #include <base_local_planner/map_grid.h>
 #include <base_local_planner/map_cell.h>
+#include <base_local_planner/rollout_field.h>
 
 #include "wavefront_map_accessor.h"
 
@@ -159,4 +166,305 @@ TEST(MapGridTest, distancePropagation){
   EXPECT_EQ(18.0, mg(9, 9).target_dist);
 }
 
+TEST(MapGridTest, regionOfInterestPropagation){
+  MapGrid mg(20, 20);
+  WavefrontMapAccessor* wa = new WavefrontMapAccessor(&mg, .25);
+  std::vector<geometry_msgs::PoseStamped> plan;
+  geometry_msgs::PoseStamped goal;
+  goal.pose.position.x = 19.5;
+  goal.pose.position.y = 19.5;
+  plan.push_back(goal);
+
+  // a coarse factor of 1 computes full resolution distances everywhere
+  CoarseGraph graph;
+  graph.update(*wa, 1);
+  mg.setRegionOfInterest(0, 0, 5, 5, &graph);
+  mg.setLocalGoal(*wa, plan);
+  EXPECT_EQ(0.0,  mg(19, 19).target_dist);
+  EXPECT_EQ(36.0, mg(1, 1).target_dist);
+
+  mg.resetPathDist();
+  graph.update(*wa, 4);
+  mg.setLocalGoal(*wa, plan);
+  EXPECT_EQ(0.0,  mg(19, 19).target_dist);
+  for (unsigned int x = 0; x < 20; ++x) {
+    for (unsigned int y = 0; y < 20; ++y) {
+      EXPECT_EQ(true, mg(x, y).target_mark);
+      // coarse distances may be off by up to two coarse cells
+      EXPECT_NEAR(38.0 - x - y, mg(x, y).target_dist, 8.0);
+    }
+  }
+  // inside the region the gradient is exact
+  for (unsigned int x = 0; x < 5; ++x) {
+    for (unsigned int y = 0; y < 5; ++y) {
+      EXPECT_EQ(1.0, mg(x, y).target_dist - mg(x + 1, y).target_dist);
+      EXPECT_EQ(1.0, mg(x, y).target_dist - mg(x, y + 1).target_dist);
+    }
+  }
+}
+
+
+TEST(MapGridTest, regionOfInterestNarrowCorridor){
+  // a wall one cell thick in the middle of the coarse cells, with a gap one cell wide
+  costmap_2d::Costmap2D costmap(20, 20, 1.0, 0.0, 0.0);
+  for (unsigned int y = 0; y < 20; ++y) {
+    costmap.setCost(9, y, costmap_2d::LETHAL_OBSTACLE);
+  }
+  costmap.setCost(9, 17, 0);
+  std::vector<geometry_msgs::PoseStamped> plan;
+  geometry_msgs::PoseStamped goal;
+  goal.pose.position.x = 19.5;
+  goal.pose.position.y = 19.5;
+  plan.push_back(goal);
+
+  MapGrid full(20, 20), coarse(20, 20);
+  full.setLocalGoal(costmap, plan);
+  CoarseGraph graph;
+  graph.update(costmap, 4);
+  coarse.setRegionOfInterest(0, 0, 5, 5, &graph);
+  coarse.setLocalGoal(costmap, plan);
+  for (unsigned int x = 0; x < 20; ++x) {
+    for (unsigned int y = 0; y < 20; ++y) {
+      if (x == 9 && y != 17) {
+        EXPECT_EQ(coarse.obstacleCosts(), coarse(x, y).target_dist);
+        continue;
+      }
+      // the gap is narrower than a coarse cell, but still lets the distances through
+      EXPECT_LT(coarse(x, y).target_dist, coarse.obstacleCosts());
+      EXPECT_NEAR(full(x, y).target_dist, coarse(x, y).target_dist, 8.0);
+    }
+  }
+
+  // closing the gap must not let the distances leak through the wall inside the coarse cells
+  costmap.setCost(9, 17, costmap_2d::LETHAL_OBSTACLE);
+  graph.update(costmap, 4);
+  coarse.resetPathDist();
+  coarse.setLocalGoal(costmap, plan);
+  for (unsigned int x = 0; x < 9; ++x) {
+    for (unsigned int y = 0; y < 20; ++y) {
+      EXPECT_EQ(coarse.unreachableCellCosts(), coarse(x, y).target_dist);
+    }
+  }
+}
+
+//times the distance grids of a cycle with three plans, at full resolution and on a coarse graph built per grid or shared
+TEST(MapGridTest, regionOfInterestBenchmark){
+  const unsigned int size = 400, passes = 10;
+  costmap_2d::Costmap2D costmap(size, size, 0.05, 0.0, 0.0);
+  srand(5);
+  for (unsigned int i = 0; i < 30; ++i) {
+    unsigned int x0 = rand() % (size - 80), y0 = rand() % size;
+    for (unsigned int x = x0; x < x0 + 80; ++x) {
+      costmap.setCost(x, y0, costmap_2d::LETHAL_OBSTACLE);
+    }
+  }
+  for (unsigned int i = 0; i < 2000; ++i) {
+    costmap.setCost(rand() % size, rand() % size, costmap_2d::LETHAL_OBSTACLE);
+  }
+  std::vector<std::vector<geometry_msgs::PoseStamped> > plans(3);
+  for (unsigned int p = 0; p < plans.size(); ++p) {
+    for (unsigned int i = 0; i < 300; ++i) {
+      geometry_msgs::PoseStamped pose;
+      pose.pose.position.x = 10.0 + 0.03 * i;
+      pose.pose.position.y = 10.0 + (0.01 + 0.01 * p) * i;
+      plans[p].push_back(pose);
+    }
+  }
+  std::vector<MapGrid> grids(2 * plans.size(), MapGrid(size, size));
+
+  //the region the rollouts reach around a robot in the middle of the map
+  const unsigned int x0 = 170, y0 = 170, x1 = 230, y1 = 230;
+  CoarseGraph graph;
+  double ms[3];
+  for (unsigned int mode = 0; mode < 3; ++mode) {
+    boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+    for (unsigned int pass = 0; pass < passes; ++pass) {
+      if (mode == 2) {
+        graph.update(costmap, 4);
+      }
+      for (unsigned int g = 0; g < grids.size(); ++g) {
+        if (mode == 1) {
+          graph.update(costmap, 4);
+        }
+        grids[g].resetPathDist();
+        grids[g].setRegionOfInterest(x0, y0, x1, y1, mode == 0 ? NULL : &graph);
+        if (g % 2 == 0) {
+          grids[g].setTargetCells(costmap, plans[g / 2]);
+        } else {
+          grids[g].setLocalGoal(costmap, plans[g / 2]);
+        }
+      }
+    }
+    ms[mode] = (boost::posix_time::microsec_clock::universal_time() - start).total_microseconds() / (1000.0 * passes);
+  }
+
+  //inside the region the distances are close to the full resolution ones
+  MapGrid full(size, size);
+  full.setLocalGoal(costmap, plans[0]);
+  for (unsigned int x = x0; x <= x1; ++x) {
+    for (unsigned int y = y0; y <= y1; ++y) {
+      if (full(x, y).target_dist < full.obstacleCosts()) {
+        EXPECT_NEAR(full(x, y).target_dist, grids[1](x, y).target_dist, 8.0);
+      }
+    }
+  }
+  printf("%u distance grids: full resolution %.2f ms, coarse graph per grid %.2f ms, shared coarse graph %.2f ms\n",
+      (unsigned int) grids.size(), ms[0], ms[1], ms[2]);
+}
+
+TEST(MapGridTest, weightedDistancePropagation){
+  srand(3);
+  const unsigned int size = 30;
+  costmap_2d::Costmap2D costmap(size, size, 0.05, 0.0, 0.0);
+  for (unsigned int y = 0; y < size; ++y) {
+    for (unsigned int x = 0; x < size; ++x) {
+      int r = rand() % 10;
+      costmap.setCost(x, y, r == 0 ? costmap_2d::LETHAL_OBSTACLE : r < 5 ? rand() % costmap_2d::INSCRIBED_INFLATED_OBSTACLE : 0);
+    }
+  }
+  costmap.setCost(0, 0, 0);
+
+  //without a weight, the weighted wavefront counts cells like the plain one
+  MapGrid plain(size, size), unit(size, size);
+  unit.setCostWeight(1e-9);
+  std::queue<MapCell*> dist_queue;
+  plain.resetPathDist();
+  plain(0, 0).target_dist = 0.0;
+  plain(0, 0).target_mark = true;
+  dist_queue.push(&plain.getCell(0, 0));
+  plain.computeTargetDistance(dist_queue, costmap);
+  unit.resetPathDist();
+  unit(0, 0).target_dist = 0.0;
+  unit(0, 0).target_mark = true;
+  dist_queue.push(&unit.getCell(0, 0));
+  unit.computeTargetDistance(dist_queue, costmap);
+  for (unsigned int i = 0; i < size * size; ++i) {
+    EXPECT_EQ(plain.getCells()[i].target_dist, unit.getCells()[i].target_dist);
+  }
+
+  //with a weight, the distances match Dijkstra over the same steps
+  double weight = 3.0;
+  MapGrid mg(size, size);
+  mg.setCostWeight(weight);
+  mg.resetPathDist();
+  mg(0, 0).target_dist = 0.0;
+  mg(0, 0).target_mark = true;
+  dist_queue.push(&mg.getCell(0, 0));
+  mg.computeTargetDistance(dist_queue, costmap);
+
+  std::vector<unsigned int> dist(size * size, 0xffffffff);
+  typedef std::pair<unsigned int, unsigned int> Entry;
+  std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry> > heap;
+  dist[0] = 0;
+  heap.push(Entry(0, 0));
+  while (!heap.empty()) {
+    Entry top = heap.top();
+    heap.pop();
+    if (top.first != dist[top.second]) {
+      continue;
+    }
+    int cx = top.second % size, cy = top.second / size;
+    int dx[4] = {-1, 1, 0, 0}, dy[4] = {0, 0, -1, 1};
+    for (unsigned int n = 0; n < 4; ++n) {
+      int x = cx + dx[n], y = cy + dy[n];
+      if (x < 0 || y < 0 || x >= (int) size || y >= (int) size || costmap.getCost(x, y) == costmap_2d::LETHAL_OBSTACLE) {
+        continue;
+      }
+      unsigned int step = 16 + (unsigned int) (16 * weight * costmap.getCost(x, y) / 252.0 + 0.5);
+      if (top.first + step < dist[y * size + x]) {
+        dist[y * size + x] = top.first + step;
+        heap.push(Entry(dist[y * size + x], y * size + x));
+      }
+    }
+  }
+
+  for (unsigned int y = 0; y < size; ++y) {
+    for (unsigned int x = 0; x < size; ++x) {
+      if (costmap.getCost(x, y) == costmap_2d::LETHAL_OBSTACLE) {
+        EXPECT_TRUE(mg(x, y).target_dist == mg.obstacleCosts() || mg(x, y).target_dist == mg.unreachableCellCosts());
+      } else if (dist[y * size + x] == 0xffffffff) {
+        EXPECT_EQ(mg.unreachableCellCosts(), mg(x, y).target_dist);
+      } else {
+        EXPECT_DOUBLE_EQ(dist[y * size + x] / 16.0, mg(x, y).target_dist);
+        EXPECT_GE(mg(x, y).target_dist, plain(x, y).target_dist);
+      }
+    }
+  }
+}
+
+
+//weighted distances past the obstacle costs still read as reachable
+TEST(MapGridTest, weightedDistanceClampedBelowObstacles){
+  const unsigned int size = 10;
+  costmap_2d::Costmap2D costmap(size, size, 0.05, 0.0, 0.0, costmap_2d::INSCRIBED_INFLATED_OBSTACLE - 1);
+  costmap.setCost(4, 4, costmap_2d::LETHAL_OBSTACLE);
+  MapGrid mg(size, size);
+  //every step costs more than the obstacle costs of the grid
+  mg.setCostWeight(200.0);
+  mg.resetPathDist();
+  mg(0, 0).target_dist = 0.0;
+  mg(0, 0).target_mark = true;
+  std::queue<MapCell*> dist_queue;
+  dist_queue.push(&mg.getCell(0, 0));
+  mg.computeTargetDistance(dist_queue, costmap);
+
+  EXPECT_EQ(0.0, mg(0, 0).target_dist);
+  EXPECT_EQ(mg.obstacleCosts(), mg(4, 4).target_dist);
+  for (unsigned int i = 1; i < size * size; ++i) {
+    if (i != 4 * size + 4) {
+      EXPECT_LT(mg.getCells()[i].target_dist, mg.obstacleCosts());
+      EXPECT_GT(mg.getCells()[i].target_dist, 0.0);
+    }
+  }
+}
+
+//the rollout field holds the weighted distances exactly, fractions of a cell included
+TEST(MapGridTest, rolloutFieldKeepsWeightedDistances){
+  const unsigned int size = 20;
+  costmap_2d::Costmap2D costmap(size, size, 0.05, 0.0, 0.0);
+  for (unsigned int i = 0; i < size; ++i) {
+    costmap.setCost(i, 10, 100);
+    costmap.setCost(10, i, 37);
+  }
+  costmap.setCost(15, 15, costmap_2d::LETHAL_OBSTACLE);
+
+  MapGrid path_map(size, size), goal_map(size, size);
+  path_map.setCostWeight(1.3);
+  goal_map.setCostWeight(1.3);
+  std::queue<MapCell*> dist_queue;
+  path_map.resetPathDist();
+  path_map(0, 0).target_dist = 0.0;
+  path_map(0, 0).target_mark = true;
+  dist_queue.push(&path_map.getCell(0, 0));
+  path_map.computeTargetDistance(dist_queue, costmap);
+  goal_map.resetPathDist();
+  goal_map(19, 0).target_dist = 0.0;
+  goal_map(19, 0).target_mark = true;
+  dist_queue.push(&goal_map.getCell(19, 0));
+  goal_map.computeTargetDistance(dist_queue, costmap);
+
+  RolloutField field;
+  field.update(costmap, path_map, goal_map, 0.0);
+  double impossible = path_map.obstacleCosts();
+  unsigned int fractions = 0;
+  for (unsigned int y = 0; y < size; ++y) {
+    for (unsigned int x = 0; x < size; ++x) {
+      if (path_map(x, y).target_dist < impossible) {
+        EXPECT_EQ(path_map(x, y).target_dist, RolloutField::distance(field(x, y).path_dist, impossible));
+      } else {
+        EXPECT_EQ(RolloutField::IMPOSSIBLE_DIST, field(x, y).path_dist);
+      }
+      if (goal_map(x, y).target_dist < impossible) {
+        EXPECT_EQ(goal_map(x, y).target_dist, RolloutField::distance(field(x, y).goal_dist, impossible));
+      } else {
+        EXPECT_EQ(RolloutField::IMPOSSIBLE_DIST, field(x, y).goal_dist);
+      }
+      if (path_map(x, y).target_dist != floor(path_map(x, y).target_dist)) {
+        ++fractions;
+      }
+    }
+  }
+  EXPECT_GT(fractions, 0u);
+}
+
 }
@@ -0,0 +1,210 @@
+/*
+ * point_grid_test.cpp
+ */
+#include <cmath>
+#include <limits>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <base_local_planner/point_grid.h>
+#include <base_local_planner/planar_laser_scan.h>
+
+namespace base_local_planner {
+
+//the planar scan a scan clears the same free space with, readings that saw nothing end at the scanner
+static PlanarLaserScan planarScan(const sensor_msgs::LaserScan& scan, const geometry_msgs::Point& sensor_origin, double sensor_yaw) {
+  PlanarLaserScan planar;
+  planar.origin.x = sensor_origin.x;
+  planar.origin.y = sensor_origin.y;
+  planar.origin.z = sensor_origin.z;
+  planar.angle_min = scan.angle_min;
+  planar.angle_increment = scan.angle_increment;
+  planar.angle_max = scan.angle_min + (scan.ranges.size() - 1) * scan.angle_increment;
+  for (unsigned int i = 0; i < scan.ranges.size(); ++i) {
+    float range = scan.ranges[i];
+    double clear_range = 0.0;
+    if (range >= scan.range_min && range < scan.range_max) {
+      clear_range = range;
+    } else if (range >= scan.range_max) {
+      clear_range = scan.range_max;
+    }
+    double angle = sensor_yaw + scan.angle_min + i * scan.angle_increment;
+    geometry_msgs::Point32 pt;
+    pt.x = sensor_origin.x + clear_range * cos(angle);
+    pt.y = sensor_origin.y + clear_range * sin(angle);
+    pt.z = sensor_origin.z;
+    planar.cloud.points.push_back(pt);
+  }
+  return planar;
+}
+
+//a point at an angle from the first beam and a distance from the scanner
+static pcl::PointXYZ beamPoint(const sensor_msgs::LaserScan& scan, const geometry_msgs::Point& sensor_origin, double sensor_yaw,
+    double beam, double dist) {
+  double angle = sensor_yaw + scan.angle_min + beam * scan.angle_increment;
+  pcl::PointXYZ pt;
+  pt.x = sensor_origin.x + dist * cos(angle);
+  pt.y = sensor_origin.y + dist * sin(angle);
+  pt.z = 0.0;
+  return pt;
+}
+
+//the lattice cells of the points left in a grid
+static std::set<std::pair<int, int> > latticeCells(PointGrid& grid, double spacing) {
+  pcl::PointCloud<pcl::PointXYZ> cloud;
+  grid.getPoints(cloud);
+  std::set<std::pair<int, int> > cells;
+  for (unsigned int i = 0; i < cloud.points.size(); ++i) {
+    cells.insert(std::make_pair((int) floor(cloud.points[i].x / spacing + 0.5), (int) floor(cloud.points[i].y / spacing + 0.5)));
+  }
+  return cells;
+}
+
+//a scan read straight from its ranges clears no point the planar scan of the same readings keeps, and nearly all it clears
+TEST(PointGridTest, scanClearsWithinPlanarScan){
+  geometry_msgs::Point origin;
+  origin.x = 0.0; origin.y = 0.0; origin.z = 0.0;
+  //obstacles closer than the shortest reading, so the scans only clear
+  PointGrid scan_grid(10.0, 10.0, 0.2, origin, 2.0, 0.05, 0.01);
+  PointGrid planar_grid(10.0, 10.0, 0.2, origin, 2.0, 0.05, 0.01);
+  const double spacing = 0.07;
+  for (double x = 2.0; x < 8.0; x += spacing) {
+    for (double y = 2.0; y < 8.0; y += spacing) {
+      pcl::PointXYZ pt;
+      pt.x = x; pt.y = y; pt.z = 0.0;
+      scan_grid.insert(pt);
+      planar_grid.insert(pt);
+    }
+  }
+
+  //the beams start away from the heading of the scanner and cross the wrap-around of the angles in the grid
+  sensor_msgs::LaserScan scan;
+  scan.angle_min = -0.6;
+  scan.angle_increment = 0.04;
+  scan.range_min = 0.05;
+  scan.range_max = 2.5;
+  for (unsigned int i = 0; i < 100; ++i) {
+    scan.ranges.push_back(1.5 + 0.8 * sin(0.15 * i));
+  }
+  scan.ranges[40] = std::numeric_limits<float>::infinity();
+  scan.ranges[41] = 7.0;
+  scan.ranges[70] = std::numeric_limits<float>::quiet_NaN();
+  scan.ranges[71] = std::numeric_limits<float>::quiet_NaN();
+  scan.ranges[85] = 0.01;
+  geometry_msgs::Point sensor;
+  sensor.x = 5.0; sensor.y = 5.0; sensor.z = 0.1;
+  double yaw = 2.8;
+  PlanarLaserScan planar = planarScan(scan, sensor, yaw);
+
+  std::vector<geometry_msgs::Point> footprint;
+  std::vector<costmap_2d::Observation> observations;
+  std::vector<PlanarLaserScan> planar_scans(1, planar);
+  scan_grid.updateWorld(footprint, scan, sensor, yaw);
+  planar_grid.updateWorld(footprint, observations, planar_scans);
+
+  std::set<std::pair<int, int> > scan_left = latticeCells(scan_grid, spacing);
+  std::set<std::pair<int, int> > planar_left = latticeCells(planar_grid, spacing);
+  for (std::set<std::pair<int, int> >::const_iterator it = planar_left.begin(); it != planar_left.end(); ++it) {
+    EXPECT_TRUE(scan_left.count(*it)) << it->first * spacing << " " << it->second * spacing;
+  }
+  unsigned int num_points = 86 * 86;
+  unsigned int scan_cleared = num_points - scan_left.size(), planar_cleared = num_points - planar_left.size();
+  EXPECT_GT(planar_cleared, 1000u);
+  EXPECT_GT(scan_cleared, 0.9 * planar_cleared);
+
+  //across the wrap-around of the angles, at PI in the grid
+  double wrap_beam = (M_PI - yaw - scan.angle_min) / scan.angle_increment;
+  EXPECT_TRUE(scan_grid.ptInScan(beamPoint(scan, sensor, yaw, wrap_beam, 0.5), scan, sensor, yaw));
+  EXPECT_TRUE(planar_grid.ptInScan(beamPoint(scan, sensor, yaw, wrap_beam, 0.5), planar));
+  //outside of the field of view on either side
+  EXPECT_FALSE(scan_grid.ptInScan(beamPoint(scan, sensor, yaw, -2.0, 0.5), scan, sensor, yaw));
+  EXPECT_FALSE(planar_grid.ptInScan(beamPoint(scan, sensor, yaw, -2.0, 0.5), planar));
+  EXPECT_FALSE(scan_grid.ptInScan(beamPoint(scan, sensor, yaw, 101.0, 0.5), scan, sensor, yaw));
+  EXPECT_FALSE(planar_grid.ptInScan(beamPoint(scan, sensor, yaw, 101.0, 0.5), planar));
+  //infinite and over range readings saw free space up to the maximum range, and not beyond it
+  EXPECT_TRUE(scan_grid.ptInScan(beamPoint(scan, sensor, yaw, 40.5, 2.4), scan, sensor, yaw));
+  EXPECT_TRUE(planar_grid.ptInScan(beamPoint(scan, sensor, yaw, 40.5, 2.4), planar));
+  EXPECT_FALSE(scan_grid.ptInScan(beamPoint(scan, sensor, yaw, 40.5, 2.6), scan, sensor, yaw));
+  EXPECT_FALSE(planar_grid.ptInScan(beamPoint(scan, sensor, yaw, 40.5, 2.6), planar));
+  //NaNs and short readings saw nothing, on both sides of them
+  for (double beam = 69.5; beam < 72.0; beam += 1.0) {
+    EXPECT_FALSE(scan_grid.ptInScan(beamPoint(scan, sensor, yaw, beam, 0.3), scan, sensor, yaw));
+    EXPECT_FALSE(planar_grid.ptInScan(beamPoint(scan, sensor, yaw, beam, 0.3), planar));
+  }
+  EXPECT_FALSE(scan_grid.ptInScan(beamPoint(scan, sensor, yaw, 84.5, 0.3), scan, sensor, yaw));
+  EXPECT_FALSE(planar_grid.ptInScan(beamPoint(scan, sensor, yaw, 84.5, 0.3), planar));
+  EXPECT_FALSE(scan_grid.ptInScan(beamPoint(scan, sensor, yaw, 85.5, 0.3), scan, sensor, yaw));
+  EXPECT_FALSE(planar_grid.ptInScan(beamPoint(scan, sensor, yaw, 85.5, 0.3), planar));
+}
+
+//only the readings that hit something within the obstacle range are inserted, where they hit
+TEST(PointGridTest, scanInsertsHits){
+  geometry_msgs::Point origin;
+  origin.x = 0.0; origin.y = 0.0; origin.z = 0.0;
+  PointGrid grid(10.0, 10.0, 0.2, origin, 2.0, 2.0, 0.01);
+  sensor_msgs::LaserScan scan;
+  scan.angle_min = 0.3;
+  scan.angle_increment = 0.5;
+  scan.range_min = 0.05;
+  scan.range_max = 4.0;
+  scan.ranges.push_back(1.0);
+  scan.ranges.push_back(std::numeric_limits<float>::quiet_NaN());
+  scan.ranges.push_back(std::numeric_limits<float>::infinity());
+  scan.ranges.push_back(5.0);
+  scan.ranges.push_back(0.01);
+  scan.ranges.push_back(3.0);
+  scan.ranges.push_back(1.5);
+  geometry_msgs::Point sensor;
+  sensor.x = 5.0; sensor.y = 5.0; sensor.z = 0.1;
+  std::vector<geometry_msgs::Point> footprint;
+  grid.updateWorld(footprint, scan, sensor, 0.5);
+
+  pcl::PointCloud<pcl::PointXYZ> cloud;
+  grid.getPoints(cloud);
+  ASSERT_EQ(2u, cloud.points.size());
+  std::vector<pcl::PointXYZ> expected;
+  expected.push_back(beamPoint(scan, sensor, 0.5, 0.0, 1.0));
+  expected.push_back(beamPoint(scan, sensor, 0.5, 6.0, 1.5));
+  for (unsigned int i = 0; i < expected.size(); ++i) {
+    bool found = false;
+    for (unsigned int j = 0; j < cloud.points.size(); ++j) {
+      found = found || (fabs(cloud.points[j].x - expected[i].x) < 1e-4 && fabs(cloud.points[j].y - expected[i].y) < 1e-4);
+    }
+    EXPECT_TRUE(found) << expected[i].x << " " << expected[i].y;
+  }
+}
+
+//between two beams the planar scan clears up to the chord joining their ends, the scan up to its closest point
+TEST(PointGridTest, scanClearsInsideChord){
+  geometry_msgs::Point origin;
+  origin.x = 0.0; origin.y = 0.0; origin.z = 0.0;
+  PointGrid grid(10.0, 10.0, 0.2, origin, 2.0, 0.05, 0.01);
+  sensor_msgs::LaserScan scan;
+  scan.angle_min = -0.5;
+  scan.angle_increment = 0.5;
+  scan.range_min = 0.05;
+  scan.range_max = 4.0;
+  scan.ranges.assign(3, 2.0);
+  geometry_msgs::Point sensor;
+  sensor.x = 5.0; sensor.y = 5.0; sensor.z = 0.1;
+  std::vector<geometry_msgs::Point> footprint;
+  grid.updateWorld(footprint, scan, sensor, 0.0);
+  PlanarLaserScan planar = planarScan(scan, sensor, 0.0);
+
+  //halfway between the beams the chord is closest to the scanner
+  double chord = 2.0 * cos(0.25);
+  EXPECT_TRUE(grid.ptInScan(beamPoint(scan, sensor, 0.0, 0.5, 0.99 * chord), scan, sensor, 0.0));
+  EXPECT_TRUE(grid.ptInScan(beamPoint(scan, sensor, 0.0, 0.5, 0.99 * chord), planar));
+  EXPECT_FALSE(grid.ptInScan(beamPoint(scan, sensor, 0.0, 0.5, 1.01 * chord), scan, sensor, 0.0));
+  EXPECT_FALSE(grid.ptInScan(beamPoint(scan, sensor, 0.0, 0.5, 1.01 * chord), planar));
+
+  //near a beam the chord is further out, only the planar scan clears up to it
+  EXPECT_FALSE(grid.ptInScan(beamPoint(scan, sensor, 0.0, 0.1, 1.95), scan, sensor, 0.0));
+  EXPECT_TRUE(grid.ptInScan(beamPoint(scan, sensor, 0.0, 0.1, 1.95), planar));
+  EXPECT_FALSE(grid.ptInScan(beamPoint(scan, sensor, 0.0, 0.1, 2.05), planar));
+}
+
+}
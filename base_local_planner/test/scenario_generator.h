@@ -0,0 +1,248 @@
+/*
+ * scenario_generator.h
+ *
+ * Seeded, parameterised costmaps with matching global plans, to exercise the planner
+ * in the same environments on every run.
+ */
+
+#ifndef SCENARIO_GENERATOR_H_
+#define SCENARIO_GENERATOR_H_
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+
+#include <boost/shared_ptr.hpp>
+
+#include <costmap_2d/costmap_2d.h>
+#include <costmap_2d/cost_values.h>
+#include <geometry_msgs/PoseStamped.h>
+
+namespace base_local_planner {
+
+enum ScenarioType {
+  OPEN_FLOOR,       ///< scattered single obstacles
+  WAREHOUSE_AISLES, ///< rows of shelves the plan runs between
+  CLUTTERED_ROOM,   ///< random round obstacles of varying size
+  NARROW_DOORWAY    ///< a wall across the map with one door for the plan
+};
+
+struct ScenarioParams {
+  ScenarioParams()
+    : type(OPEN_FLOOR), size_x(100), size_y(100), resolution(0.05),
+      obstacle_density(0.05), plan_curvature(0.0), plan_length(4.0),
+      clearance(0.3), inflation_radius(0.2), door_width(0.8), seed(1) {}
+
+  ScenarioType type;
+  unsigned int size_x, size_y; ///< size of the map in cells
+  double resolution;           ///< meters per cell
+  double obstacle_density;     ///< fraction of the cells that are obstacles, before the plan is cleared
+  double plan_curvature;       ///< 1/m, the plan bends left and right alternately with this curvature
+  double plan_length;          ///< meters, clipped where the plan would leave the map
+  double clearance;            ///< meters kept free of obstacles on both sides of the plan
+  double inflation_radius;     ///< meters around obstacles that get a cost decaying from INSCRIBED_INFLATED_OBSTACLE
+  double door_width;           ///< meters, NARROW_DOORWAY only
+  unsigned int seed;
+};
+
+/**
+ * Generates the same costmap and plan for the same parameters, on every platform.
+ */
+class ScenarioGenerator {
+  public:
+    explicit ScenarioGenerator(const ScenarioParams& params) : params_(params), state_(params.seed ? params.seed : 1) {}
+
+    boost::shared_ptr<costmap_2d::Costmap2D> createCostmap() const {
+      return boost::shared_ptr<costmap_2d::Costmap2D>(new costmap_2d::Costmap2D(
+          params_.size_x, params_.size_y, params_.resolution, 0.0, 0.0, costmap_2d::FREE_SPACE));
+    }
+
+    /**
+     * Fills a costmap made by createCostmap, and the plan through it in the frame of the costmap
+     */
+    void generate(costmap_2d::Costmap2D& costmap, std::vector<geometry_msgs::PoseStamped>& plan) {
+      state_ = params_.seed ? params_.seed : 1;
+      generatePlan(plan);
+      switch (params_.type) {
+        case OPEN_FLOOR:
+          scatterObstacles(costmap, 0);
+          break;
+        case CLUTTERED_ROOM:
+          scatterObstacles(costmap, std::max(1, (int) (0.3 / params_.resolution)));
+          break;
+        case WAREHOUSE_AISLES:
+          placeShelves(costmap);
+          break;
+        case NARROW_DOORWAY:
+          placeWall(costmap, plan);
+          break;
+      }
+      clearAlongPlan(costmap, plan);
+      inflate(costmap);
+    }
+
+  private:
+    // xorshift32, std::rand differs between standard libraries
+    unsigned int next() {
+      state_ ^= state_ << 13;
+      state_ ^= state_ >> 17;
+      state_ ^= state_ << 5;
+      return state_;
+    }
+
+    double uniform() {
+      return next() / 4294967296.0;
+    }
+
+    void generatePlan(std::vector<geometry_msgs::PoseStamped>& plan) {
+      plan.clear();
+      double step = params_.resolution;
+      double x = 0.1 * params_.size_x * params_.resolution;
+      double y = 0.5 * params_.size_y * params_.resolution;
+      double theta = 0.0;
+      //bend one way for a quarter of the plan, then the other, so the plan stays near the middle of the map
+      double segment = std::max(params_.plan_length / 4.0, step);
+      for (double s = 0.0; s <= params_.plan_length; s += step) {
+        if (x < 0 || y < 0 || x >= params_.size_x * params_.resolution || y >= params_.size_y * params_.resolution) {
+          break;
+        }
+        geometry_msgs::PoseStamped pose;
+        pose.pose.position.x = x;
+        pose.pose.position.y = y;
+        pose.pose.orientation.z = sin(theta / 2.0);
+        pose.pose.orientation.w = cos(theta / 2.0);
+        plan.push_back(pose);
+        double sign = ((int) ((s + segment / 2.0) / segment)) % 2 == 0 ? 1.0 : -1.0;
+        theta += sign * params_.plan_curvature * step;
+        x += step * cos(theta);
+        y += step * sin(theta);
+      }
+    }
+
+    void scatterObstacles(costmap_2d::Costmap2D& costmap, int max_radius) {
+      unsigned int num_cells = params_.size_x * params_.size_y;
+      unsigned int target = (unsigned int) (params_.obstacle_density * num_cells);
+      unsigned int placed = 0;
+      //every attempt marks at least one cell or hits a marked one, bound them in case the density cannot be reached
+      for (unsigned int attempt = 0; placed < target && attempt < 4 * num_cells; ++attempt) {
+        int cx = next() % params_.size_x;
+        int cy = next() % params_.size_y;
+        int r = max_radius > 0 ? next() % (max_radius + 1) : 0;
+        for (int y = cy - r; y <= cy + r; ++y) {
+          for (int x = cx - r; x <= cx + r; ++x) {
+            if (x < 0 || y < 0 || x >= (int) params_.size_x || y >= (int) params_.size_y ||
+                (x - cx) * (x - cx) + (y - cy) * (y - cy) > r * r) {
+              continue;
+            }
+            if (costmap.getCost(x, y) != costmap_2d::LETHAL_OBSTACLE) {
+              costmap.setCost(x, y, costmap_2d::LETHAL_OBSTACLE);
+              ++placed;
+            }
+          }
+        }
+      }
+    }
+
+    void placeShelves(costmap_2d::Costmap2D& costmap) {
+      //shelves along x, one aisle between each pair, the aisle around the plan is cleared later
+      unsigned int shelf = std::max(1, (int) (0.6 / params_.resolution));
+      unsigned int aisle = std::max(1, (int) (1.2 / params_.resolution));
+      unsigned int gap = std::max(1, (int) (1.0 / params_.resolution));
+      unsigned int offset = next() % (shelf + aisle);
+      //cross aisles through the shelves at random, fewer the denser the warehouse
+      unsigned int num_shelves = params_.size_y / (shelf + aisle) + 2;
+      unsigned int num_cross = params_.size_x / (4 * gap) + 1;
+      std::vector<bool> cross_open(num_shelves * num_cross);
+      for (unsigned int i = 0; i < cross_open.size(); ++i) {
+        cross_open[i] = uniform() > params_.obstacle_density;
+      }
+      for (unsigned int y = 0; y < params_.size_y; ++y) {
+        if ((y + offset) % (shelf + aisle) >= shelf) {
+          continue;
+        }
+        unsigned int shelf_index = (y + offset) / (shelf + aisle);
+        for (unsigned int x = 0; x < params_.size_x; ++x) {
+          if (x % (4 * gap) < gap && cross_open[shelf_index * num_cross + x / (4 * gap)]) {
+            continue;
+          }
+          costmap.setCost(x, y, costmap_2d::LETHAL_OBSTACLE);
+        }
+      }
+    }
+
+    void placeWall(costmap_2d::Costmap2D& costmap, const std::vector<geometry_msgs::PoseStamped>& plan) {
+      //the wall crosses the plan half way along it, the door is centered on the plan
+      unsigned int wall_x = params_.size_x / 2, door_y = params_.size_y / 2;
+      if (!plan.empty()) {
+        const geometry_msgs::PoseStamped& middle = plan[plan.size() / 2];
+        costmap.worldToMap(middle.pose.position.x, middle.pose.position.y, wall_x, door_y);
+      }
+      int thickness = std::max(1, (int) (0.1 / params_.resolution));
+      int half_door = (int) (params_.door_width / (2.0 * params_.resolution));
+      for (unsigned int y = 0; y < params_.size_y; ++y) {
+        if (abs((int) y - (int) door_y) <= half_door) {
+          continue;
+        }
+        for (int x = wall_x; x < (int) wall_x + thickness && x < (int) params_.size_x; ++x) {
+          costmap.setCost(x, y, costmap_2d::LETHAL_OBSTACLE);
+        }
+      }
+      //clutter on both sides of the wall
+      scatterObstacles(costmap, 0);
+    }
+
+    void clearAlongPlan(costmap_2d::Costmap2D& costmap, const std::vector<geometry_msgs::PoseStamped>& plan) {
+      int r = (int) ceil(params_.clearance / params_.resolution);
+      for (unsigned int i = 0; i < plan.size(); ++i) {
+        unsigned int cx, cy;
+        if (!costmap.worldToMap(plan[i].pose.position.x, plan[i].pose.position.y, cx, cy)) {
+          continue;
+        }
+        for (int y = (int) cy - r; y <= (int) cy + r; ++y) {
+          for (int x = (int) cx - r; x <= (int) cx + r; ++x) {
+            if (x >= 0 && y >= 0 && x < (int) params_.size_x && y < (int) params_.size_y &&
+                (x - (int) cx) * (x - (int) cx) + (y - (int) cy) * (y - (int) cy) <= r * r) {
+              costmap.setCost(x, y, costmap_2d::FREE_SPACE);
+            }
+          }
+        }
+      }
+    }
+
+    void inflate(costmap_2d::Costmap2D& costmap) {
+      int r = (int) ceil(params_.inflation_radius / params_.resolution);
+      if (r <= 0) {
+        return;
+      }
+      std::vector<unsigned char> inflated(costmap.getCharMap(), costmap.getCharMap() + params_.size_x * params_.size_y);
+      for (int cy = 0; cy < (int) params_.size_y; ++cy) {
+        for (int cx = 0; cx < (int) params_.size_x; ++cx) {
+          if (costmap.getCost(cx, cy) != costmap_2d::LETHAL_OBSTACLE) {
+            continue;
+          }
+          for (int y = std::max(0, cy - r); y <= std::min((int) params_.size_y - 1, cy + r); ++y) {
+            for (int x = std::max(0, cx - r); x <= std::min((int) params_.size_x - 1, cx + r); ++x) {
+              double d = sqrt((double) ((x - cx) * (x - cx) + (y - cy) * (y - cy)));
+              if (d > r || d == 0) {
+                continue;
+              }
+              unsigned char cost = (unsigned char) ((costmap_2d::INSCRIBED_INFLATED_OBSTACLE - 1) * (1.0 - d / (r + 1)));
+              unsigned char& cell = inflated[y * params_.size_x + x];
+              if (cell != costmap_2d::LETHAL_OBSTACLE && cost > cell) {
+                cell = cost;
+              }
+            }
+          }
+        }
+      }
+      std::copy(inflated.begin(), inflated.end(), costmap.getCharMap());
+    }
+
+    ScenarioParams params_;
+    unsigned int state_;
+};
+
+}
+
+#endif /* SCENARIO_GENERATOR_H_ */
@@ -0,0 +1,337 @@
+/*
+ * scenario_test.cpp
+ *
+ * Runs the distance grids, the costmap model and the rollouts over the generated scenarios.
+ */
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <base_local_planner/map_grid.h>
+#include <base_local_planner/costmap_model.h>
+#include <base_local_planner/trajectory_planner.h>
+
+#include "scenario_generator.h"
+
+namespace base_local_planner {
+
+static std::vector<ScenarioParams> scenarioCorpus() {
+  std::vector<ScenarioParams> corpus;
+  ScenarioParams params;
+  params.type = OPEN_FLOOR;
+  params.obstacle_density = 0.02;
+  corpus.push_back(params);
+  params.type = WAREHOUSE_AISLES;
+  params.size_x = 160;
+  params.size_y = 120;
+  params.obstacle_density = 0.3;
+  params.plan_length = 6.0;
+  corpus.push_back(params);
+  params.type = CLUTTERED_ROOM;
+  params.size_x = 100;
+  params.size_y = 100;
+  params.obstacle_density = 0.15;
+  params.plan_curvature = 0.5;
+  params.plan_length = 4.0;
+  params.seed = 7;
+  corpus.push_back(params);
+  params.type = NARROW_DOORWAY;
+  params.obstacle_density = 0.01;
+  params.plan_curvature = 0.0;
+  params.resolution = 0.025;
+  params.size_x = 200;
+  params.size_y = 200;
+  params.door_width = 0.7;
+  corpus.push_back(params);
+  return corpus;
+}
+
+static std::vector<geometry_msgs::Point> squareFootprint(double half_width) {
+  std::vector<geometry_msgs::Point> footprint;
+  geometry_msgs::Point pt;
+  pt.x = half_width; pt.y = half_width;
+  footprint.push_back(pt);
+  pt.x = half_width; pt.y = -half_width;
+  footprint.push_back(pt);
+  pt.x = -half_width; pt.y = -half_width;
+  footprint.push_back(pt);
+  pt.x = -half_width; pt.y = half_width;
+  footprint.push_back(pt);
+  return footprint;
+}
+
+static std::vector<geometry_msgs::PoseStamped> linePlan(double x0, double y0, double x1, double y1) {
+  std::vector<geometry_msgs::PoseStamped> plan;
+  unsigned int steps = (unsigned int) (hypot(x1 - x0, y1 - y0) / 0.05);
+  for (unsigned int i = 0; i <= steps; ++i) {
+    geometry_msgs::PoseStamped pose;
+    pose.pose.position.x = x0 + (x1 - x0) * i / steps;
+    pose.pose.position.y = y0 + (y1 - y0) * i / steps;
+    pose.pose.orientation.w = 1.0;
+    plan.push_back(pose);
+  }
+  return plan;
+}
+
+TEST(ScenarioTest, reproducible){
+  std::vector<ScenarioParams> corpus = scenarioCorpus();
+  for (unsigned int i = 0; i < corpus.size(); ++i) {
+    ScenarioGenerator first_generator(corpus[i]), second_generator(corpus[i]);
+    boost::shared_ptr<costmap_2d::Costmap2D> first = first_generator.createCostmap();
+    boost::shared_ptr<costmap_2d::Costmap2D> second = second_generator.createCostmap();
+    std::vector<geometry_msgs::PoseStamped> first_plan, second_plan;
+    first_generator.generate(*first, first_plan);
+    second_generator.generate(*second, second_plan);
+
+    unsigned int num_cells = corpus[i].size_x * corpus[i].size_y;
+    EXPECT_TRUE(std::equal(first->getCharMap(), first->getCharMap() + num_cells, second->getCharMap()));
+    ASSERT_EQ(first_plan.size(), second_plan.size());
+    for (unsigned int j = 0; j < first_plan.size(); ++j) {
+      EXPECT_EQ(first_plan[j].pose.position.x, second_plan[j].pose.position.x);
+      EXPECT_EQ(first_plan[j].pose.position.y, second_plan[j].pose.position.y);
+    }
+  }
+
+  //another seed, another room
+  ScenarioParams params = corpus[2];
+  ScenarioGenerator generator(params);
+  params.seed += 1;
+  ScenarioGenerator other_generator(params);
+  boost::shared_ptr<costmap_2d::Costmap2D> costmap = generator.createCostmap();
+  boost::shared_ptr<costmap_2d::Costmap2D> other = other_generator.createCostmap();
+  std::vector<geometry_msgs::PoseStamped> plan;
+  generator.generate(*costmap, plan);
+  other_generator.generate(*other, plan);
+  EXPECT_FALSE(std::equal(costmap->getCharMap(), costmap->getCharMap() + params.size_x * params.size_y, other->getCharMap()));
+}
+
+TEST(ScenarioTest, planDistances){
+  std::vector<ScenarioParams> corpus = scenarioCorpus();
+  for (unsigned int i = 0; i < corpus.size(); ++i) {
+    ScenarioGenerator generator(corpus[i]);
+    boost::shared_ptr<costmap_2d::Costmap2D> costmap = generator.createCostmap();
+    std::vector<geometry_msgs::PoseStamped> plan;
+    generator.generate(*costmap, plan);
+    ASSERT_FALSE(plan.empty());
+
+    MapGrid path_map(corpus[i].size_x, corpus[i].size_y);
+    MapGrid goal_map(corpus[i].size_x, corpus[i].size_y);
+    path_map.setTargetCells(*costmap, plan);
+    goal_map.setLocalGoal(*costmap, plan);
+
+    //the plan is kept clear, so every cell of it is a target and the goal is reachable from its start
+    for (unsigned int j = 0; j < plan.size(); ++j) {
+      unsigned int x, y;
+      ASSERT_TRUE(costmap->worldToMap(plan[j].pose.position.x, plan[j].pose.position.y, x, y));
+      EXPECT_LT(costmap->getCost(x, y), costmap_2d::INSCRIBED_INFLATED_OBSTACLE);
+      EXPECT_EQ(0.0, path_map(x, y).target_dist);
+    }
+    unsigned int start_x, start_y;
+    costmap->worldToMap(plan[0].pose.position.x, plan[0].pose.position.y, start_x, start_y);
+    EXPECT_LT(goal_map(start_x, start_y).target_dist, goal_map.obstacleCosts());
+  }
+}
+
+TEST(ScenarioTest, footprintAlongPlan){
+  std::vector<ScenarioParams> corpus = scenarioCorpus();
+  std::vector<geometry_msgs::Point> footprint = squareFootprint(0.15);
+  for (unsigned int i = 0; i < corpus.size(); ++i) {
+    ScenarioGenerator generator(corpus[i]);
+    boost::shared_ptr<costmap_2d::Costmap2D> costmap = generator.createCostmap();
+    std::vector<geometry_msgs::PoseStamped> plan;
+    generator.generate(*costmap, plan);
+    CostmapModel model(*costmap);
+    for (unsigned int j = 0; j < plan.size(); ++j) {
+      EXPECT_GE(model.footprintCost(plan[j].pose.position.x, plan[j].pose.position.y,
+          tf::getYaw(plan[j].pose.orientation), footprint, 0.15, 0.22), 0.0);
+    }
+  }
+}
+
+TEST(ScenarioTest, rolloutsFollowPlan){
+  std::vector<ScenarioParams> corpus = scenarioCorpus();
+  std::vector<geometry_msgs::Point> footprint = squareFootprint(0.15);
+  for (unsigned int i = 0; i < corpus.size(); ++i) {
+    ScenarioGenerator generator(corpus[i]);
+    boost::shared_ptr<costmap_2d::Costmap2D> costmap = generator.createCostmap();
+    std::vector<geometry_msgs::PoseStamped> plan;
+    generator.generate(*costmap, plan);
+    CostmapModel model(*costmap);
+    TrajectoryPlanner planner(model, *costmap, footprint);
+    planner.updatePlan(plan);
+
+    tf::Stamped<tf::Pose> pose(tf::Pose(tf::createQuaternionFromYaw(tf::getYaw(plan[0].pose.orientation)),
+        tf::Point(plan[0].pose.position.x, plan[0].pose.position.y, 0.0)), ros::Time(), "map");
+    tf::Stamped<tf::Pose> vel(tf::Pose(tf::createQuaternionFromYaw(0.0), tf::Point(0.0, 0.0, 0.0)), ros::Time(), "base_link");
+    tf::Stamped<tf::Pose> drive_cmds;
+    Trajectory best = planner.findBestPath(pose, vel, drive_cmds);
+    EXPECT_GE(best.cost_, 0.0);
+    EXPECT_GT(best.xv_, 0.0);
+  }
+}
+
+TEST(ScenarioTest, searchPhaseGates){
+  ScenarioParams params = scenarioCorpus()[0];
+  std::vector<geometry_msgs::Point> footprint = squareFootprint(0.15);
+  ScenarioGenerator generator(params);
+  boost::shared_ptr<costmap_2d::Costmap2D> costmap = generator.createCostmap();
+  std::vector<geometry_msgs::PoseStamped> plan;
+  generator.generate(*costmap, plan);
+  CostmapModel model(*costmap);
+  TrajectoryPlanner planner(model, *costmap, footprint);
+  planner.updatePlan(plan);
+
+  tf::Stamped<tf::Pose> pose(tf::Pose(tf::createQuaternionFromYaw(tf::getYaw(plan[0].pose.orientation)),
+      tf::Point(plan[0].pose.position.x, plan[0].pose.position.y, 0.0)), ros::Time(), "map");
+  tf::Stamped<tf::Pose> vel(tf::Pose(tf::createQuaternionFromYaw(0.0), tf::Point(0.0, 0.0, 0.0)), ros::Time(), "base_link");
+  tf::Stamped<tf::Pose> drive_cmds;
+  Trajectory full = planner.findBestPath(pose, vel, drive_cmds);
+  uint64_t full_rollouts = planner.getSearchPhaseStats(TrajectoryPlanner::FORWARD_PHASE).rollouts;
+  for (int phase = 0; phase < TrajectoryPlanner::NUM_SEARCH_PHASES; ++phase) {
+    const TrajectoryPlanner::SearchPhaseStats& stats = planner.getSearchPhaseStats((TrajectoryPlanner::SearchPhase) phase);
+    EXPECT_EQ(1u, stats.runs);
+    EXPECT_EQ(0u, stats.accepted);
+    EXPECT_EQ(0u, stats.skipped);
+  }
+
+  //a forward trajectory along the open plan passes, the holonomic phases are skipped
+  TrajectoryPlanner::SearchPhaseGate gate;
+  gate.max_cost = 2.0 * full.cost_;
+  gate.min_progress = 0.1;
+  gate.max_samples = 50;
+  planner.setSearchPhaseGate(TrajectoryPlanner::FORWARD_PHASE, gate);
+  Trajectory gated = planner.findBestPath(pose, vel, drive_cmds);
+  const TrajectoryPlanner::SearchPhaseStats& forward = planner.getSearchPhaseStats(TrajectoryPlanner::FORWARD_PHASE);
+  EXPECT_EQ(2u, forward.runs);
+  EXPECT_EQ(1u, forward.accepted);
+  EXPECT_LE(forward.rollouts - full_rollouts, 50u);
+  for (int phase = TrajectoryPlanner::STRAFE_PHASE; phase < TrajectoryPlanner::NUM_SEARCH_PHASES; ++phase) {
+    const TrajectoryPlanner::SearchPhaseStats& stats = planner.getSearchPhaseStats((TrajectoryPlanner::SearchPhase) phase);
+    EXPECT_EQ(1u, stats.runs);
+    EXPECT_EQ(1u, stats.skipped);
+  }
+  EXPECT_GE(gated.cost_, 0.0);
+  EXPECT_GT(gated.xv_, 0.0);
+}
+
+//the simple attractor scores squared distances in meters, so the progress of the gate must not be read off the goal costs
+TEST(ScenarioTest, searchPhaseGateSimpleAttractor){
+  costmap_2d::Costmap2D costmap(100, 100, 0.05, 0.0, 0.0, costmap_2d::FREE_SPACE);
+  std::vector<geometry_msgs::PoseStamped> plan = linePlan(1.0, 2.5, 3.0, 2.5);
+  std::vector<geometry_msgs::Point> footprint = squareFootprint(0.15);
+  CostmapModel model(costmap);
+  TrajectoryPlanner planner(model, costmap, footprint,
+      1.0, 1.0, 1.0, 1.0, 0.025, 20, 20, 0.6, 0.8, 0.01, 0.8, 0.325, 0.05, 0.10, M_PI_2, true,
+      0.5, 0.1, 1.0, -1.0, 0.4, -0.1, false, false, 0.1, true, true);
+  planner.updatePlan(plan);
+
+  tf::Stamped<tf::Pose> pose(tf::Pose(tf::createQuaternionFromYaw(0.0), tf::Point(1.0, 2.5, 0.0)), ros::Time(), "map");
+  tf::Stamped<tf::Pose> vel(tf::Pose(tf::createQuaternionFromYaw(0.0), tf::Point(0.0, 0.0, 0.0)), ros::Time(), "base_link");
+  tf::Stamped<tf::Pose> drive_cmds;
+  Trajectory full = planner.findBestPath(pose, vel, drive_cmds);
+  ASSERT_GE(full.cost_, 0.0);
+  ASSERT_GT(full.xv_, 0.0);
+
+  //accelerating from a standstill, the trajectories fall short of the 0.5m reach of max_vel_x * sim_time
+  TrajectoryPlanner::SearchPhaseGate gate;
+  gate.max_cost = 2.0 * full.cost_;
+  gate.min_progress = 0.5;
+  planner.setSearchPhaseGate(TrajectoryPlanner::FORWARD_PHASE, gate);
+  Trajectory gated = planner.findBestPath(pose, vel, drive_cmds);
+  EXPECT_EQ(1u, planner.getSearchPhaseStats(TrajectoryPlanner::FORWARD_PHASE).accepted);
+  EXPECT_EQ(1u, planner.getSearchPhaseStats(TrajectoryPlanner::STRAFE_PHASE).skipped);
+  EXPECT_GE(gated.cost_, 0.0);
+  EXPECT_GT(gated.xv_, 0.0);
+
+  gate.min_progress = 0.9;
+  planner.setSearchPhaseGate(TrajectoryPlanner::FORWARD_PHASE, gate);
+  planner.findBestPath(pose, vel, drive_cmds);
+  EXPECT_EQ(1u, planner.getSearchPhaseStats(TrajectoryPlanner::FORWARD_PHASE).accepted);
+}
+
+//the cost bounds of a point robot are its center cell, which must not be inscribed. The simple attractor does not
+//read the distance grids, which would mark the inscribed cells as unreachable, and without an occupancy cost nothing
+//steers around them, so only the footprint check guards them
+TEST(ScenarioTest, pointRobotAvoidsInscribedCells){
+  costmap_2d::Costmap2D costmap(100, 100, 0.05, 0.0, 0.0, costmap_2d::FREE_SPACE);
+  for (unsigned int y = 48; y < 53; ++y) {
+    costmap.setCost(26, y, costmap_2d::INSCRIBED_INFLATED_OBSTACLE);
+  }
+  std::vector<geometry_msgs::PoseStamped> plan;
+  for (unsigned int i = 0; i <= 30; ++i) {
+    geometry_msgs::PoseStamped pose;
+    pose.pose.position.x = 1.0 + 0.1 * i;
+    pose.pose.position.y = 2.5;
+    pose.pose.orientation.w = 1.0;
+    plan.push_back(pose);
+  }
+  std::vector<geometry_msgs::Point> footprint(1);
+  CostmapModel model(costmap);
+  TrajectoryPlanner planner(model, costmap, footprint,
+      1.0, 1.0, 1.0, 1.0, 0.025, 20, 20, 0.6, 0.8, 0.0, 0.8, 0.325, 0.05, 0.10, M_PI_2, true,
+      0.5, 0.1, 1.0, -1.0, 0.4, -0.1, false, false, 0.1, true, true);
+  planner.updatePlan(plan);
+
+  tf::Stamped<tf::Pose> pose(tf::Pose(tf::createQuaternionFromYaw(0.0), tf::Point(1.0, 2.5, 0.0)), ros::Time(), "map");
+  tf::Stamped<tf::Pose> vel(tf::Pose(tf::createQuaternionFromYaw(0.0), tf::Point(0.0, 0.0, 0.0)), ros::Time(), "base_link");
+  tf::Stamped<tf::Pose> drive_cmds;
+  Trajectory best = planner.findBestPath(pose, vel, drive_cmds);
+  ASSERT_GE(best.cost_, 0.0);
+  for (unsigned int i = 0; i < best.getPointsSize(); ++i) {
+    double x, y, th;
+    unsigned int mx, my;
+    best.getPoint(i, x, y, th);
+    ASSERT_TRUE(costmap.worldToMap(x, y, mx, my));
+    EXPECT_LT(costmap.getCost(mx, my), costmap_2d::INSCRIBED_INFLATED_OBSTACLE);
+  }
+}
+
+//every alternative plan gets the best sample making progress along it, never the robot standing still or backing up
+TEST(ScenarioTest, corridorsScoreProgressingSamples){
+  costmap_2d::Costmap2D costmap(100, 100, 0.05, 0.0, 0.0, costmap_2d::FREE_SPACE);
+  std::vector<geometry_msgs::Point> footprint = squareFootprint(0.15);
+  CostmapModel model(costmap);
+  TrajectoryPlanner planner(model, costmap, footprint);
+
+  std::vector<std::vector<geometry_msgs::PoseStamped> > plans;
+  plans.push_back(linePlan(1.0, 2.5, 4.0, 2.5));
+  plans.push_back(linePlan(1.0, 2.5, 3.0, 4.5));
+  //straight behind the robot, no forward sample gets closer to it
+  plans.push_back(linePlan(1.0, 2.5, 0.2, 2.5));
+
+  tf::Stamped<tf::Pose> pose(tf::Pose(tf::createQuaternionFromYaw(0.0), tf::Point(1.0, 2.5, 0.0)), ros::Time(), "map");
+  tf::Stamped<tf::Pose> vel(tf::Pose(tf::createQuaternionFromYaw(0.0), tf::Point(0.0, 0.0, 0.0)), ros::Time(), "base_link");
+  std::vector<Trajectory> best_trajs;
+  EXPECT_EQ(0, planner.findBestCorridorPaths(pose, vel, plans, best_trajs));
+  ASSERT_EQ(3u, best_trajs.size());
+  EXPECT_GE(best_trajs[0].cost_, 0.0);
+  EXPECT_GT(best_trajs[0].xv_, 0.0);
+  EXPECT_GE(best_trajs[1].cost_, 0.0);
+  EXPECT_GT(best_trajs[1].xv_, 0.0);
+  EXPECT_GT(best_trajs[1].thetav_, 0.0);
+  EXPECT_LT(best_trajs[2].cost_, 0.0);
+}
+
+//heading scoring only scores the followed plan
+TEST(ScenarioTest, corridorsRejectHeadingScoring){
+  costmap_2d::Costmap2D costmap(100, 100, 0.05, 0.0, 0.0, costmap_2d::FREE_SPACE);
+  std::vector<geometry_msgs::Point> footprint = squareFootprint(0.15);
+  CostmapModel model(costmap);
+  TrajectoryPlanner planner(model, costmap, footprint,
+      1.0, 1.0, 1.0, 1.0, 0.025, 20, 20, 0.6, 0.8, 0.2, 0.8, 0.325, 0.05, 0.10, M_PI_2, true,
+      0.5, 0.1, 1.0, -1.0, 0.4, -0.1, false, true);
+
+  std::vector<std::vector<geometry_msgs::PoseStamped> > plans;
+  plans.push_back(linePlan(1.0, 2.5, 4.0, 2.5));
+  plans.push_back(linePlan(1.0, 2.5, 3.0, 4.5));
+
+  tf::Stamped<tf::Pose> pose(tf::Pose(tf::createQuaternionFromYaw(0.0), tf::Point(1.0, 2.5, 0.0)), ros::Time(), "map");
+  tf::Stamped<tf::Pose> vel(tf::Pose(tf::createQuaternionFromYaw(0.0), tf::Point(0.0, 0.0, 0.0)), ros::Time(), "base_link");
+  std::vector<Trajectory> best_trajs;
+  planner.findBestCorridorPaths(pose, vel, plans, best_trajs);
+  ASSERT_EQ(2u, best_trajs.size());
+  EXPECT_LT(best_trajs[1].cost_, 0.0);
+  EXPECT_EQ(0u, best_trajs[1].getPointsSize());
+}
+
+}
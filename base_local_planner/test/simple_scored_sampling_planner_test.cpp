@@ -0,0 +1,248 @@
+/*
+ * simple_scored_sampling_planner_test.cpp
+ */
+#include <cmath>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <costmap_2d/costmap_2d.h>
+#include <costmap_2d/cost_values.h>
+
+#include <base_local_planner/simple_scored_sampling_planner.h>
+#include <base_local_planner/simple_trajectory_generator.h>
+#include <base_local_planner/obstacle_cost_function.h>
+#include <base_local_planner/prefer_forward_cost_function.h>
+#include <base_local_planner/task_scheduler.h>
+
+namespace base_local_planner {
+
+/**
+ * Passes the samples of a SimpleTrajectoryGenerator through, and records the velocities of those it simulates
+ */
+class RecordingGenerator : public TrajectorySampleGenerator {
+  public:
+    RecordingGenerator(SimpleTrajectoryGenerator& generator) : generator_(generator) {}
+
+    bool hasMoreTrajectories() { return generator_.hasMoreTrajectories(); }
+
+    bool nextTrajectory(Trajectory& traj) {
+      recordNext();
+      return generator_.nextTrajectory(traj);
+    }
+
+    bool nextTrajectory(Trajectory& traj, TrajectoryPoseObserver& observer) {
+      recordNext();
+      bool complete = generator_.nextTrajectory(traj, observer);
+      if (!complete && traj.getPointsSize() > 0) {
+        stopped.push_back(traj);
+      }
+      return complete;
+    }
+
+    bool peekNextVelocities(Trajectory& traj) { return generator_.peekNextVelocities(traj); }
+
+    void skipTrajectory() {
+      ++skipped;
+      generator_.skipTrajectory();
+    }
+
+    unsigned int getMaxNumPoints() { return generator_.getMaxNumPoints(); }
+
+    std::vector<Trajectory> simulated; ///< only the velocities are set
+    std::vector<Trajectory> stopped; ///< the poses a streaming critic let through, up to the one it rejected
+    unsigned int skipped;
+
+  private:
+    void recordNext() {
+      Trajectory sample;
+      if (generator_.peekNextVelocities(sample)) {
+        simulated.push_back(sample);
+      }
+    }
+
+    SimpleTrajectoryGenerator& generator_;
+};
+
+/**
+ * The distance from the last pose to a goal, a critic that needs the whole trajectory
+ */
+class EndpointDistanceCostFunction : public TrajectoryCostFunction {
+  public:
+    EndpointDistanceCostFunction(double goal_x, double goal_y) : goal_x_(goal_x), goal_y_(goal_y) {}
+
+    bool prepare() { return true; }
+
+    double scoreTrajectory(Trajectory& traj) {
+      if (traj.getPointsSize() == 0) {
+        return -1.0;
+      }
+      double x, y, th;
+      traj.getEndpoint(x, y, th);
+      return hypot(goal_x_ - x, goal_y_ - y);
+    }
+
+  private:
+    double goal_x_, goal_y_;
+};
+
+class SimpleScoredSamplingPlannerTest : public testing::Test {
+  public:
+    SimpleScoredSamplingPlannerTest()
+      : costmap(100, 100, 0.05, 0.0, 0.0, costmap_2d::FREE_SPACE),
+        limits(0.5, 0.05, 0.5, -0.2, 0.0, 0.0, 1.0, 0.2, 2.5, 2.5, 3.2, -1, 0.1, 0.1),
+        obstacle_critic(&costmap), prefer_forward_critic(-1.0), endpoint_critic(3.0, 2.5) {
+      //a wall across the way straight ahead, the robot has to turn to get past it
+      for (unsigned int y = 40; y < 60; ++y) {
+        for (unsigned int x = 32; x < 35; ++x) {
+          costmap.setCost(x, y, costmap_2d::LETHAL_OBSTACLE);
+        }
+      }
+      geometry_msgs::Point pt;
+      pt.x = 0.1; pt.y = 0.1;
+      footprint.push_back(pt);
+      pt.x = 0.1; pt.y = -0.1;
+      footprint.push_back(pt);
+      pt.x = -0.1; pt.y = -0.1;
+      footprint.push_back(pt);
+      pt.x = -0.1; pt.y = 0.1;
+      footprint.push_back(pt);
+      obstacle_critic.setFootprint(footprint);
+      obstacle_critic.setParams(0.5, 0.0, 0.25);
+      endpoint_critic.setScale(10.0);
+
+      critics.push_back(&prefer_forward_critic);
+      critics.push_back(&obstacle_critic);
+      critics.push_back(&endpoint_critic);
+      generator.setParameters(1.7, 0.025, 0.025);
+    }
+
+    void initialiseGenerator() {
+      generator.initialise(Eigen::Vector3f(1.0, 2.5, 0.0), Eigen::Vector3f::Zero(), Eigen::Vector3f(3.0, 2.5, 0.0),
+          &limits, Eigen::Vector3f(8, 1, 11));
+    }
+
+    costmap_2d::Costmap2D costmap;
+    LocalPlannerLimits limits;
+    std::vector<geometry_msgs::Point> footprint;
+    ObstacleCostFunction obstacle_critic;
+    PreferForwardCostFunction prefer_forward_critic;
+    EndpointDistanceCostFunction endpoint_critic;
+    std::vector<TrajectoryCostFunction*> critics;
+    SimpleTrajectoryGenerator generator;
+};
+
+//collecting all explored trajectories simulates and scores every sample, gating must not change the result
+TEST_F(SimpleScoredSamplingPlannerTest, velocityGateKeepsBestTrajectory){
+  RecordingGenerator recorder(generator);
+  std::vector<TrajectorySampleGenerator*> generators(1, &recorder);
+  SimpleScoredSamplingPlanner planner(generators, critics);
+
+  initialiseGenerator();
+  recorder.skipped = 0;
+  Trajectory ungated;
+  std::vector<Trajectory> all_explored;
+  ASSERT_TRUE(planner.findBestTrajectory(ungated, &all_explored));
+
+  initialiseGenerator();
+  recorder.simulated.clear();
+  recorder.skipped = 0;
+  Trajectory gated;
+  ASSERT_TRUE(planner.findBestTrajectory(gated));
+
+  EXPECT_FLOAT_EQ(ungated.xv_, gated.xv_);
+  EXPECT_FLOAT_EQ(ungated.yv_, gated.yv_);
+  EXPECT_FLOAT_EQ(ungated.thetav_, gated.thetav_);
+  EXPECT_FLOAT_EQ(ungated.cost_, gated.cost_);
+  EXPECT_EQ(ungated.getPointsSize(), gated.getPointsSize());
+  //the best trajectory has to turn past the wall
+  EXPECT_GT(gated.xv_, 0.0);
+  EXPECT_NE(0.0, gated.thetav_);
+}
+
+//samples the velocity-only critics reject are skipped, not simulated
+TEST_F(SimpleScoredSamplingPlannerTest, rejectedSamplesAreNotSimulated){
+  RecordingGenerator recorder(generator);
+  std::vector<TrajectorySampleGenerator*> generators(1, &recorder);
+  SimpleScoredSamplingPlanner planner(generators, critics);
+
+  initialiseGenerator();
+  recorder.skipped = 0;
+  Trajectory best;
+  ASSERT_TRUE(planner.findBestTrajectory(best));
+
+  EXPECT_GT(recorder.skipped, 0u);
+  EXPECT_FALSE(recorder.simulated.empty());
+  for (unsigned int i = 0; i < recorder.simulated.size(); ++i) {
+    EXPECT_GE(prefer_forward_critic.scoreTrajectory(recorder.simulated[i]), 0.0);
+  }
+}
+
+//a streaming critic rejecting a pose stops the simulation of that sample right there
+TEST_F(SimpleScoredSamplingPlannerTest, streamingStopsAtFirstCollision){
+  RecordingGenerator recorder(generator);
+  std::vector<TrajectorySampleGenerator*> generators(1, &recorder);
+  SimpleScoredSamplingPlanner planner(generators, critics);
+
+  initialiseGenerator();
+  Trajectory best;
+  std::vector<Trajectory> all_explored;
+  ASSERT_TRUE(planner.findBestTrajectory(best, &all_explored));
+
+  initialiseGenerator();
+  recorder.stopped.clear();
+  ASSERT_TRUE(planner.findBestTrajectory(best));
+  ASSERT_FALSE(recorder.stopped.empty());
+
+  CostmapModel model(costmap);
+  unsigned int stopped_early = 0;
+  for (unsigned int i = 0; i < recorder.stopped.size(); ++i) {
+    const Trajectory& stopped = recorder.stopped[i];
+    const Trajectory* full = NULL;
+    for (unsigned int j = 0; j < all_explored.size(); ++j) {
+      if (all_explored[j].xv_ == stopped.xv_ && all_explored[j].yv_ == stopped.yv_ && all_explored[j].thetav_ == stopped.thetav_) {
+        full = &all_explored[j];
+      }
+    }
+    ASSERT_TRUE(full != NULL);
+    EXPECT_LT(full->cost_, 0.0);
+    EXPECT_LE(stopped.getPointsSize(), full->getPointsSize());
+    if (stopped.getPointsSize() < full->getPointsSize()) {
+      ++stopped_early;
+    }
+
+    //every pose but the last one is legal, the rest of the trajectory was never simulated
+    double x, y, th;
+    for (unsigned int j = 0; j + 1 < stopped.getPointsSize(); ++j) {
+      stopped.getPoint(j, x, y, th);
+      EXPECT_GE(model.footprintCost(x, y, th, footprint), 0.0);
+    }
+    stopped.getEndpoint(x, y, th);
+    EXPECT_LT(model.footprintCost(x, y, th, footprint), 0.0);
+  }
+  EXPECT_GT(stopped_early, 0u);
+}
+
+//preparing the critics on a scheduler runs one control task per critic and finds the same trajectory
+TEST_F(SimpleScoredSamplingPlannerTest, criticsPrepareOnScheduler){
+  std::vector<TrajectorySampleGenerator*> generators(1, &generator);
+  SimpleScoredSamplingPlanner planner(generators, critics);
+
+  initialiseGenerator();
+  Trajectory inline_best;
+  ASSERT_TRUE(planner.findBestTrajectory(inline_best));
+
+  boost::shared_ptr<TaskScheduler> scheduler(new TaskScheduler(2));
+  planner.setScheduler(scheduler);
+  initialiseGenerator();
+  Trajectory scheduled_best;
+  ASSERT_TRUE(planner.findBestTrajectory(scheduled_best));
+
+  EXPECT_EQ(critics.size(), scheduler->getLaneStats(TaskScheduler::CONTROL).tasks);
+  EXPECT_EQ(0u, scheduler->getLaneStats(TaskScheduler::BACKGROUND).tasks);
+  EXPECT_FLOAT_EQ(inline_best.xv_, scheduled_best.xv_);
+  EXPECT_FLOAT_EQ(inline_best.thetav_, scheduled_best.thetav_);
+  EXPECT_FLOAT_EQ(inline_best.cost_, scheduled_best.cost_);
+}
+
+}
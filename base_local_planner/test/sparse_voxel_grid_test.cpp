@@ -0,0 +1,196 @@
+/*
+ * sparse_voxel_grid_test.cpp
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <stdint.h>
+
+#include <gtest/gtest.h>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <base_local_planner/sparse_voxel_grid.h>
+
+namespace base_local_planner {
+
+TEST(SparseVoxelGridTest, markAndClear){
+  //taller than a column word
+  SparseVoxelGrid grid(20, 20, 100);
+  EXPECT_EQ(0u, grid.numBricks());
+  grid.markVoxel(3, 4, 90);
+  grid.markVoxel(3, 4, 91);
+  grid.markVoxel(19, 19, 0);
+  grid.markVoxel(20, 0, 0);
+  grid.markVoxel(0, 0, 100);
+  EXPECT_EQ(2u, grid.numBricks());
+  EXPECT_TRUE(grid.getVoxel(3, 4, 90));
+  EXPECT_FALSE(grid.getVoxel(3, 4, 89));
+  EXPECT_FALSE(grid.getVoxel(4, 4, 90));
+
+  EXPECT_TRUE(grid.columnOccupied(3, 4, 0, 1000));
+  EXPECT_TRUE(grid.columnOccupied(3, 4, 91, 91));
+  EXPECT_FALSE(grid.columnOccupied(3, 4, 0, 89));
+  EXPECT_FALSE(grid.columnOccupied(3, 4, 92, 99));
+  EXPECT_FALSE(grid.columnOccupied(3, 5, 0, 99));
+  //nothing is known outside the grid
+  EXPECT_TRUE(grid.columnOccupied(20, 4, 0, 99));
+
+  std::vector<VoxelCell> cells;
+  grid.getMarkedVoxels(cells);
+  EXPECT_EQ(3u, cells.size());
+
+  //the brick is released with its last voxel
+  grid.clearVoxel(3, 4, 90);
+  EXPECT_EQ(2u, grid.numBricks());
+  grid.clearVoxel(3, 4, 91);
+  EXPECT_EQ(1u, grid.numBricks());
+  EXPECT_FALSE(grid.columnOccupied(3, 4, 0, 99));
+}
+
+TEST(SparseVoxelGridTest, shift){
+  SparseVoxelGrid grid(20, 20, 100);
+  grid.markVoxel(3, 4, 90);
+  grid.markVoxel(10, 10, 5);
+  grid.markVoxel(19, 0, 0);
+
+  //the voxels move against the grid, across bricks, and those that leave it are dropped
+  grid.shift(5, -3);
+  EXPECT_TRUE(grid.getVoxel(5, 13, 5));
+  EXPECT_TRUE(grid.getVoxel(14, 3, 0));
+  EXPECT_FALSE(grid.getVoxel(10, 10, 5));
+  EXPECT_FALSE(grid.columnOccupied(3, 4, 0, 99));
+  EXPECT_TRUE(grid.columnOccupied(5, 13, 0, 99));
+  std::vector<VoxelCell> cells;
+  grid.getMarkedVoxels(cells);
+  EXPECT_EQ(2u, cells.size());
+
+  grid.shift(0, 0);
+  EXPECT_TRUE(grid.getVoxel(5, 13, 5));
+
+  grid.shift(-10, 10);
+  EXPECT_TRUE(grid.getVoxel(15, 3, 5));
+  grid.getMarkedVoxels(cells);
+  EXPECT_EQ(1u, cells.size());
+  EXPECT_EQ(1u, grid.numBricks());
+}
+
+TEST(SparseVoxelGridTest, clearVoxelLine){
+  SparseVoxelGrid grid(40, 40, 40);
+  for (unsigned int i = 0; i < 40; ++i) {
+    grid.markVoxel(i, i, i);
+    grid.markVoxel(i, 20, 5);
+  }
+  grid.markVoxel(39, 0, 0);
+
+  //the diagonal through the grid, clipped where it leaves it
+  grid.clearVoxelLine(-10.5, -10.5, -10.5, 45.5, 45.5, 45.5);
+  for (unsigned int i = 0; i < 40; ++i) {
+    EXPECT_FALSE(grid.getVoxel(i, i, i));
+  }
+  EXPECT_TRUE(grid.getVoxel(39, 0, 0));
+
+  //a ray along the row clears up to its end and no further
+  grid.clearVoxelLine(0.5, 20.5, 5.5, 29.5, 20.5, 5.5);
+  for (unsigned int i = 0; i < 40; ++i) {
+    EXPECT_EQ(i >= 30, grid.getVoxel(i, 20, 5));
+  }
+
+  std::vector<VoxelCell> cells;
+  grid.getMarkedVoxels(cells);
+  EXPECT_EQ(11u, cells.size());
+  //only the bricks of the rest of the row and the corner are left
+  EXPECT_EQ(3u, grid.numBricks());
+}
+
+//whether a voxel in the range is marked, checking every voxel
+static bool anyVoxel(const SparseVoxelGrid& grid, unsigned int x, unsigned int y, unsigned int min_z, unsigned int max_z) {
+  for (unsigned int z = min_z; z <= max_z; ++z) {
+    if (grid.getVoxel(x, y, z)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+//the brick column summary has to follow the bricks as they are stored and released
+TEST(SparseVoxelGridTest, columnOccupiedMatchesVoxels){
+  //bricks above the 63rd layer share a bit of the summary
+  SparseVoxelGrid grid(24, 24, 600);
+  srand(7);
+  for (unsigned int round = 0; round < 4; ++round) {
+    for (unsigned int i = 0; i < 300; ++i) {
+      unsigned int x = rand() % 24, y = rand() % 24, z = rand() % 600;
+      if (rand() % 3 == 0) {
+        grid.clearVoxel(x, y, z);
+      } else {
+        grid.markVoxel(x, y, z);
+      }
+    }
+    //clear most of the volume again so bricks get released
+    for (unsigned int i = 0; i < 40; ++i) {
+      grid.clearVoxelLine(rand() % 24 + 0.5, rand() % 24 + 0.5, rand() % 600 + 0.5, rand() % 24 + 0.5, rand() % 24 + 0.5, rand() % 600 + 0.5);
+    }
+
+    for (unsigned int x = 0; x < 24; ++x) {
+      for (unsigned int y = 0; y < 24; ++y) {
+        unsigned int min_z = rand() % 600, max_z = min_z + rand() % 300;
+        EXPECT_EQ(anyVoxel(grid, x, y, min_z, max_z), grid.columnOccupied(x, y, min_z, max_z));
+        EXPECT_EQ(anyVoxel(grid, x, y, 0, max_z), grid.columnOccupied(x, y, 0, max_z));
+      }
+    }
+  }
+  grid.reset();
+  EXPECT_FALSE(grid.columnOccupied(5, 5, 0, 599));
+}
+
+//times the footprint checks on a sparse scene against the column words of voxel_grid::VoxelGrid::getVoxelColumn
+TEST(SparseVoxelGridTest, columnOccupiedBenchmark){
+  const unsigned int size_x = 400, size_y = 400, size_z = 16;
+  SparseVoxelGrid grid(size_x, size_y, size_z);
+  std::vector<uint32_t> columns(size_x * size_y, 0);
+  srand(11);
+  //a few walls and scattered clutter, the way a local costmap usually looks
+  for (unsigned int i = 0; i < 20; ++i) {
+    unsigned int x0 = rand() % (size_x - 60), y0 = rand() % size_y, height = 4 + rand() % 12;
+    for (unsigned int x = x0; x < x0 + 60; ++x) {
+      for (unsigned int z = 0; z < height; ++z) {
+        grid.markVoxel(x, y0, z);
+        columns[y0 * size_x + x] |= 1u << z;
+      }
+    }
+  }
+  for (unsigned int i = 0; i < 500; ++i) {
+    unsigned int x = rand() % size_x, y = rand() % size_y, z = rand() % size_z;
+    grid.markVoxel(x, y, z);
+    columns[y * size_x + x] |= 1u << z;
+  }
+
+  const unsigned int min_z = 0, max_z = 6;
+  const uint32_t mask = ((2u << max_z) - 1) & ~((1u << min_z) - 1);
+  unsigned int sparse_hits = 0, column_hits = 0;
+
+  boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+  for (unsigned int pass = 0; pass < 20; ++pass) {
+    for (unsigned int y = 0; y < size_y; ++y) {
+      for (unsigned int x = 0; x < size_x; ++x) {
+        sparse_hits += grid.columnOccupied(x, y, min_z, max_z);
+      }
+    }
+  }
+  boost::posix_time::ptime sparse_end = boost::posix_time::microsec_clock::universal_time();
+  for (unsigned int pass = 0; pass < 20; ++pass) {
+    for (unsigned int y = 0; y < size_y; ++y) {
+      for (unsigned int x = 0; x < size_x; ++x) {
+        column_hits += (columns[y * size_x + x] & mask) != 0;
+      }
+    }
+  }
+  boost::posix_time::ptime column_end = boost::posix_time::microsec_clock::universal_time();
+
+  EXPECT_EQ(column_hits, sparse_hits);
+  printf("columnOccupied: %.2f ns per column, column words: %.2f ns per column\n",
+      (sparse_end - start).total_microseconds() * 1000.0 / (20.0 * size_x * size_y),
+      (column_end - sparse_end).total_microseconds() * 1000.0 / (20.0 * size_x * size_y));
+}
+
+}
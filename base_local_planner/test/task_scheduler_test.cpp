@@ -0,0 +1,77 @@
+/*
+ * task_scheduler_test.cpp
+ */
+#include <gtest/gtest.h>
+
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
+#include <base_local_planner/task_scheduler.h>
+
+namespace base_local_planner {
+
+static void addTo(boost::mutex* mutex, int* sum, int value) {
+  boost::mutex::scoped_lock lock(*mutex);
+  *sum += value;
+}
+
+static void waitForGroup(TaskScheduler* scheduler, boost::mutex* mutex, int* sum) {
+  //a task that waits for tasks of its own must not block a worker forever
+  TaskGroup inner(scheduler, TaskScheduler::CONTROL);
+  for (int i = 0; i < 10; ++i) {
+    inner.run(boost::bind(&addTo, mutex, sum, 1));
+  }
+  inner.wait();
+}
+
+TEST(TaskScheduler, runsEveryTask){
+  for (unsigned int num_threads = 0; num_threads < 4; ++num_threads) {
+    TaskScheduler scheduler(num_threads);
+    boost::mutex mutex;
+    int sum = 0;
+    TaskGroup group(&scheduler, TaskScheduler::CONTROL);
+    for (int i = 1; i <= 100; ++i) {
+      group.run(boost::bind(&addTo, &mutex, &sum, i));
+    }
+    group.wait();
+    EXPECT_EQ(5050, sum);
+    EXPECT_EQ(100u, scheduler.getLaneStats(TaskScheduler::CONTROL).tasks);
+
+    //nested groups on every worker at once
+    sum = 0;
+    for (unsigned int i = 0; i < 2 * num_threads + 1; ++i) {
+      group.run(boost::bind(&waitForGroup, &scheduler, &mutex, &sum));
+    }
+    group.wait();
+    EXPECT_EQ(10 * (2 * (int) num_threads + 1), sum);
+  }
+
+  //without a scheduler the tasks run right away
+  int sum = 0;
+  boost::mutex mutex;
+  TaskGroup group(NULL, TaskScheduler::BACKGROUND);
+  group.run(boost::bind(&addTo, &mutex, &sum, 3));
+  EXPECT_EQ(3, sum);
+}
+
+TEST(TaskScheduler, cancelDropsQueuedTasks){
+  TaskScheduler scheduler(2);
+  boost::mutex mutex;
+  int sum = 0;
+  TaskGroup group(&scheduler, TaskScheduler::BACKGROUND);
+  for (int i = 0; i < 1000; ++i) {
+    group.run(boost::bind(&addTo, &mutex, &sum, 1));
+  }
+  group.cancel();
+
+  TaskScheduler::LaneStats stats = scheduler.getLaneStats(TaskScheduler::BACKGROUND);
+  EXPECT_EQ(1000u, stats.tasks + stats.cancelled);
+  EXPECT_EQ((int) stats.tasks, sum);
+
+  //the group takes new tasks after a cancel
+  group.run(boost::bind(&addTo, &mutex, &sum, 1));
+  group.wait();
+  EXPECT_EQ((int) stats.tasks + 1, sum);
+}
+
+}
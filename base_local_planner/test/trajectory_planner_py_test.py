@@ -0,0 +1,47 @@
+#!/usr/bin/env python
+#
+# trajectory_planner_py_test.py
+#
+# Smoke test of the optional python bindings over the trajectory planner.
+
+import unittest
+
+import numpy
+
+from trajectory_planner_py import TrajectoryPlanner
+
+
+class TrajectoryPlannerPyTest(unittest.TestCase):
+
+    def setUp(self):
+        costmap = numpy.zeros((100, 100), dtype=numpy.uint8)
+        footprint = numpy.array([[0.15, 0.15], [0.15, -0.15], [-0.15, -0.15], [-0.15, 0.15]])
+        self.planner = TrajectoryPlanner(costmap, 0.05, 0.0, 0.0, footprint)
+        self.planner.set_plan(numpy.array([[1.0 + 0.05 * i, 2.5] for i in range(60)]))
+
+    def test_find_best_path(self):
+        cost, command, points = self.planner.find_best_path(1.0, 2.5, 0.0, 0.0, 0.0, 0.0)
+        self.assertGreaterEqual(cost, 0.0)
+        self.assertEqual((3,), command.shape)
+        self.assertGreater(command[0], 0.0)
+        self.assertEqual(3, points.shape[1])
+
+    def test_evaluate(self):
+        samples = numpy.array([[1.0, 2.5, 0.0, 0.0, 0.0, 0.0, 0.3, 0.0, 0.0],
+                               [1.0, 2.5, 0.0, 0.0, 0.0, 0.0, 0.3, 0.0, 0.5]])
+        costs = self.planner.evaluate(samples)
+        self.assertEqual((2,), costs.shape)
+        self.assertTrue((costs >= 0.0).all())
+
+    def test_distances_are_read_only(self):
+        self.planner.find_best_path(1.0, 2.5, 0.0, 0.0, 0.0, 0.0)
+        for distances in (self.planner.path_distances(), self.planner.goal_distances()):
+            self.assertEqual((100, 100), distances.shape)
+            self.assertFalse(distances.flags.writeable)
+            with self.assertRaises(ValueError):
+                distances[0, 0] = 0.0
+
+
+if __name__ == '__main__':
+    import rosunit
+    rosunit.unitrun('base_local_planner', 'trajectory_planner_py', TrajectoryPlannerPyTest)
@@ -41,6 +41,7 @@
 #include <base_local_planner/trajectory.h>
 #include <base_local_planner/trajectory_planner.h>
 #include <base_local_planner/costmap_model.h>
+#include <base_local_planner/cost_bounds_grid.h>
 #include <costmap_2d/costmap_2d.h>
 #include <math.h>
 
@@ -48,6 +49,7 @@
 #include <base_local_planner/Position2DInt.h>
 
 #include "wavefront_map_accessor.h"
+#include "scenario_generator.h"
 
 using namespace std;
 
@@ -60,6 +62,10 @@ class TrajectoryPlannerTest : public testing::Test {
     void footprintObstacles();
     void checkGoalDistance();
     void checkPathDistance();
+    void endpointGate();
+    void blockedSearch();
+    void footprintSwitching();
+    void predictStartState();
     virtual void TestBody(){}
 
     MapGrid* map_;
@@ -165,6 +171,279 @@ void TrajectoryPlannerTest::checkPathDistance(){
 
 }
 
+void TrajectoryPlannerTest::endpointGate(){
+  ScenarioParams params;
+  params.obstacle_density = 0.02;
+  ScenarioGenerator generator(params);
+  boost::shared_ptr<costmap_2d::Costmap2D> costmap = generator.createCostmap();
+  std::vector<geometry_msgs::PoseStamped> plan;
+  generator.generate(*costmap, plan);
+  std::vector<geometry_msgs::Point> footprint;
+  geometry_msgs::Point pt;
+  pt.x = 0.15; pt.y = 0.15;
+  footprint.push_back(pt);
+  pt.x = 0.15; pt.y = -0.15;
+  footprint.push_back(pt);
+  pt.x = -0.15; pt.y = -0.15;
+  footprint.push_back(pt);
+  pt.x = -0.15; pt.y = 0.15;
+  footprint.push_back(pt);
+  CostmapModel model(*costmap);
+  TrajectoryPlanner planner(model, *costmap, footprint);
+  planner.updatePlan(plan);
+
+  //a first search computes the path and goal distances the samples below are scored on
+  double x = plan[0].pose.position.x, y = plan[0].pose.position.y, theta = M_PI_4;
+  tf::Stamped<tf::Pose> pose(tf::Pose(tf::createQuaternionFromYaw(theta), tf::Point(x, y, 0.0)), ros::Time(), "map");
+  tf::Stamped<tf::Pose> vel(tf::Pose(tf::createQuaternionFromYaw(0.0), tf::Point(0.0, 0.0, 0.0)), ros::Time(), "base_link");
+  tf::Stamped<tf::Pose> drive_cmds;
+  planner.findBestPath(pose, vel, drive_cmds);
+
+  //facing diagonally away from the plan, turning towards it makes progress and turning away does not
+  double impossible_cost = planner.path_map_.obstacleCosts();
+  Trajectory reference, full, gated;
+  planner.generateTrajectory(x, y, theta, 0, 0, 0, 0, 0, 0,
+      planner.acc_lim_x_, planner.acc_lim_y_, planner.acc_lim_theta_, impossible_cost, reference);
+  ASSERT_GE(reference.cost_, 0.0);
+
+  unsigned int rejected = 0;
+  double best_full_cost = -1.0, best_gated_cost = -1.0;
+  double best_full_vtheta = 0.0, best_gated_vtheta = 0.0;
+  for (int i = 0; i < 5; ++i) {
+    double vx_samp = 0.1 + 0.1 * i;
+    for (int j = 0; j < 11; ++j) {
+      double vtheta_samp = -1.0 + 0.2 * j;
+      planner.generateTrajectory(x, y, theta, 0, 0, 0, vx_samp, 0, vtheta_samp,
+          planner.acc_lim_x_, planner.acc_lim_y_, planner.acc_lim_theta_, impossible_cost, full);
+      planner.generateProgressingTrajectory(x, y, theta, 0, 0, 0, vx_samp, 0, vtheta_samp,
+          planner.acc_lim_x_, planner.acc_lim_y_, planner.acc_lim_theta_, impossible_cost, reference, gated);
+      bool full_selectable = full.cost_ >= 0 && full.goal_cost_traj_ < reference.goal_cost_traj_;
+      if (gated.cost_ == -6.0 && gated.getPointsSize() == 0) {
+        //the gate only drops samples the search would not have selected, without rolling them out
+        EXPECT_FALSE(full_selectable);
+        ++rejected;
+      } else {
+        EXPECT_FLOAT_EQ(full.cost_, gated.cost_);
+        EXPECT_EQ(full.getPointsSize(), gated.getPointsSize());
+      }
+      if (full_selectable && (best_full_cost < 0 || full.cost_ < best_full_cost)) {
+        best_full_cost = full.cost_;
+        best_full_vtheta = vtheta_samp;
+      }
+      if (gated.cost_ >= 0 && gated.goal_cost_traj_ < reference.goal_cost_traj_
+          && (best_gated_cost < 0 || gated.cost_ < best_gated_cost)) {
+        best_gated_cost = gated.cost_;
+        best_gated_vtheta = vtheta_samp;
+      }
+    }
+  }
+  EXPECT_GT(rejected, 0u);
+  ASSERT_GE(best_full_cost, 0.0);
+  EXPECT_FLOAT_EQ(best_full_cost, best_gated_cost);
+  EXPECT_FLOAT_EQ(best_full_vtheta, best_gated_vtheta);
+}
+
+//a plan from (1.0, 2.5) to (2.0, 2.5) through the given height halfway
+static std::vector<geometry_msgs::PoseStamped> bentPlan(double mid_y) {
+  std::vector<geometry_msgs::PoseStamped> plan;
+  for (unsigned int i = 0; i <= 20; ++i) {
+    geometry_msgs::PoseStamped pose;
+    pose.pose.position.x = 1.0 + 0.05 * i;
+    pose.pose.position.y = 2.5 + (mid_y - 2.5) * (1.0 - fabs(i - 10.0) / 10.0);
+    pose.pose.orientation.w = 1.0;
+    plan.push_back(pose);
+  }
+  return plan;
+}
+
+void TrajectoryPlannerTest::blockedSearch(){
+  //a robot boxed in so closely that it can neither drive nor turn
+  costmap_2d::Costmap2D costmap(100, 100, 0.05, 0.0, 0.0, costmap_2d::FREE_SPACE);
+  for (unsigned int i = 45; i <= 55; ++i) {
+    costmap.setCost(i, 45, costmap_2d::LETHAL_OBSTACLE);
+    costmap.setCost(i, 55, costmap_2d::LETHAL_OBSTACLE);
+    costmap.setCost(45, i, costmap_2d::LETHAL_OBSTACLE);
+    costmap.setCost(55, i, costmap_2d::LETHAL_OBSTACLE);
+  }
+  std::vector<geometry_msgs::Point> footprint;
+  geometry_msgs::Point pt;
+  pt.x = 0.15; pt.y = 0.15;
+  footprint.push_back(pt);
+  pt.x = 0.15; pt.y = -0.15;
+  footprint.push_back(pt);
+  pt.x = -0.15; pt.y = -0.15;
+  footprint.push_back(pt);
+  pt.x = -0.15; pt.y = 0.15;
+  footprint.push_back(pt);
+  CostmapModel model(costmap);
+  TrajectoryPlanner planner(model, costmap, footprint);
+  planner.blocked_cycles_ = 2;
+  planner.updatePlan(bentPlan(2.5));
+
+  tf::Stamped<tf::Pose> pose(tf::Pose(tf::createQuaternionFromYaw(0.0), tf::Point(2.5, 2.5, 0.0)), ros::Time(), "map");
+  tf::Stamped<tf::Pose> vel(tf::Pose(tf::createQuaternionFromYaw(0.0), tf::Point(0.0, 0.0, 0.0)), ros::Time(), "base_link");
+  tf::Stamped<tf::Pose> drive_cmds;
+  const TrajectoryPlanner::SearchPhaseStats& searches = planner.getSearchPhaseStats(TrajectoryPlanner::FORWARD_PHASE);
+
+  //the search stops after the second failure in a row, and keeps commanding a stop
+  EXPECT_LT(planner.findBestPath(pose, vel, drive_cmds).cost_, 0.0);
+  EXPECT_LT(planner.findBestPath(pose, vel, drive_cmds).cost_, 0.0);
+  EXPECT_EQ(2u, searches.runs);
+  EXPECT_TRUE(planner.blocked_);
+  EXPECT_LT(planner.findBestPath(pose, vel, drive_cmds).cost_, 0.0);
+  EXPECT_EQ(2u, searches.runs);
+  EXPECT_EQ(0.0, drive_cmds.getOrigin().x());
+
+  //a rerouted plan with the same goal and length
+  planner.updatePlan(bentPlan(2.0));
+  planner.findBestPath(pose, vel, drive_cmds);
+  EXPECT_EQ(3u, searches.runs);
+  planner.findBestPath(pose, vel, drive_cmds);
+  EXPECT_EQ(3u, searches.runs);
+
+  //a cell the robot could reach changing
+  costmap.setCost(50, 45, costmap_2d::INSCRIBED_INFLATED_OBSTACLE);
+  planner.findBestPath(pose, vel, drive_cmds);
+  EXPECT_EQ(4u, searches.runs);
+
+  //the robot moving
+  tf::Stamped<tf::Pose> moved(tf::Pose(tf::createQuaternionFromYaw(0.0), tf::Point(2.55, 2.5, 0.0)), ros::Time(), "map");
+  planner.findBestPath(moved, vel, drive_cmds);
+  EXPECT_EQ(5u, searches.runs);
+
+  //the search runs every cycle without the threshold
+  planner.blocked_cycles_ = 0;
+  planner.blocked_ = false;
+  planner.findBestPath(moved, vel, drive_cmds);
+  planner.findBestPath(moved, vel, drive_cmds);
+  EXPECT_EQ(7u, searches.runs);
+}
+
+//a rectangle centered on the robot
+static std::vector<geometry_msgs::Point> rectangle(double half_length, double half_width) {
+  std::vector<geometry_msgs::Point> footprint;
+  geometry_msgs::Point pt;
+  pt.x = half_length; pt.y = half_width;
+  footprint.push_back(pt);
+  pt.x = half_length; pt.y = -half_width;
+  footprint.push_back(pt);
+  pt.x = -half_length; pt.y = -half_width;
+  footprint.push_back(pt);
+  pt.x = -half_length; pt.y = half_width;
+  footprint.push_back(pt);
+  return footprint;
+}
+
+void TrajectoryPlannerTest::footprintSwitching(){
+  costmap_2d::Costmap2D costmap(100, 100, 0.05, 0.0, 0.0, costmap_2d::FREE_SPACE);
+  CostmapModel model(costmap);
+  TrajectoryPlanner planner(model, costmap, rectangle(0.15, 0.15));
+  EXPECT_NEAR(0.15, planner.footprint_->getInscribedRadius(), 1e-9);
+
+  //a registered footprint is only used once selected, and from the next cycle on
+  planner.registerFootprint(1, rectangle(0.3, 0.3));
+  EXPECT_FALSE(planner.selectFootprint(2));
+  EXPECT_TRUE(planner.selectFootprint(1));
+  EXPECT_NEAR(0.15, planner.footprint_->getInscribedRadius(), 1e-9);
+  planner.switchFootprint();
+  EXPECT_EQ(planner.footprint_sets_[1], planner.footprint_);
+  EXPECT_NEAR(0.3, planner.footprint_->getInscribedRadius(), 1e-9);
+  EXPECT_NEAR(hypot(0.3, 0.3), planner.footprint_->getCircumscribedRadius(), 1e-9);
+
+  //a new footprint brings its own radii
+  planner.setFootprint(rectangle(0.4, 0.1));
+  planner.switchFootprint();
+  EXPECT_NEAR(0.1, planner.footprint_->getInscribedRadius(), 1e-9);
+  EXPECT_NEAR(hypot(0.4, 0.1), planner.footprint_->getCircumscribedRadius(), 1e-9);
+  EXPECT_EQ(CostBoundsGrid::footprintRadius(rectangle(0.4, 0.1), 0.05), planner.footprint_->getCellRadius(0.05));
+
+  //other heading bins rebuild the footprint in use and the registered ones, without the configuration lock
+  {
+    boost::mutex::scoped_lock l(planner.configuration_mutex_);
+    planner.rebuildFootprints(8);
+  }
+  EXPECT_EQ(8u, planner.footprint_sets_[1]->getHeadingBins());
+  EXPECT_EQ(0u, planner.footprint_->getHeadingBins());
+  planner.switchFootprint();
+  EXPECT_EQ(8u, planner.footprint_->getHeadingBins());
+  EXPECT_NEAR(0.1, planner.footprint_->getInscribedRadius(), 1e-9);
+
+  //footprints set or registered later are built for the bins in use
+  planner.registerFootprint(2, rectangle(0.2, 0.2));
+  EXPECT_EQ(8u, planner.footprint_sets_[2]->getHeadingBins());
+  planner.setFootprint(rectangle(0.2, 0.1));
+  planner.switchFootprint();
+  EXPECT_EQ(8u, planner.footprint_->getHeadingBins());
+  EXPECT_TRUE(planner.footprint_->hasOutlines(0.05));
+}
+
+void TrajectoryPlannerTest::predictStartState(){
+  costmap_2d::Costmap2D costmap(100, 100, 0.05, 0.0, 0.0, costmap_2d::FREE_SPACE);
+  CostmapModel model(costmap);
+  TrajectoryPlanner planner(model, costmap, rectangle(0.15, 0.15));
+
+  //no time to predict leaves the state alone
+  planner.recordCommand(0.3, 0.0, 0.0);
+  Eigen::Vector3f pos(1.0, 1.0, 0.0), vel(0.0, 0.0, 0.0);
+  planner.predictStartState(pos, vel, 0.0);
+  EXPECT_FLOAT_EQ(1.0, pos[0]);
+  EXPECT_FLOAT_EQ(0.0, vel[0]);
+
+  //from rest the base reaches the command after 0.3s at 1m/s^2, in 0.05s steps
+  planner.predictStartState(pos, vel, 0.5);
+  EXPECT_NEAR(0.3, vel[0], 1e-6);
+  EXPECT_NEAR(1.0 + 0.05 * (0.05 + 0.1 + 0.15 + 0.2 + 0.25 + 5 * 0.3), pos[0], 1e-6);
+  EXPECT_NEAR(1.0, pos[1], 1e-6);
+
+  //facing along y, the base moves along y
+  pos = Eigen::Vector3f(1.0, 1.0, M_PI_2);
+  vel = Eigen::Vector3f(0.3, 0.0, 0.0);
+  planner.predictStartState(pos, vel, 0.5);
+  EXPECT_NEAR(1.0, pos[0], 1e-6);
+  EXPECT_NEAR(1.15, pos[1], 1e-6);
+
+  //a stop decelerates within the limits rather than at once
+  planner.recordCommand(0.0, 0.0, 0.0);
+  pos = Eigen::Vector3f(1.0, 1.0, 0.0);
+  vel = Eigen::Vector3f(0.5, 0.0, 0.0);
+  planner.predictStartState(pos, vel, 0.25);
+  EXPECT_NEAR(0.25, vel[0], 1e-6);
+  EXPECT_NEAR(1.0 + 0.05 * (0.45 + 0.4 + 0.35 + 0.3 + 0.25), pos[0], 1e-6);
+
+  //the rotation is capped by its acceleration limit
+  planner.recordCommand(0.0, 0.0, 2.0);
+  pos = Eigen::Vector3f(1.0, 1.0, 0.0);
+  vel = Eigen::Vector3f(0.0, 0.0, 0.0);
+  planner.predictStartState(pos, vel, 0.5);
+  EXPECT_NEAR(0.5, vel[2], 1e-6);
+  EXPECT_NEAR(0.05 * 0.05 * 55, pos[2], 1e-6);
+  EXPECT_NEAR(1.0, pos[0], 1e-6);
+
+  //a cycle records the command it chose, until the command actually sent replaces it
+  std::vector<geometry_msgs::PoseStamped> plan;
+  for (int i = 0; i <= 20; ++i) {
+    geometry_msgs::PoseStamped pose;
+    pose.pose.position.x = 1.0 + 0.1 * i;
+    pose.pose.position.y = 2.5;
+    pose.pose.orientation.w = 1.0;
+    plan.push_back(pose);
+  }
+  planner.updatePlan(plan);
+  tf::Stamped<tf::Pose> pose(tf::Pose(tf::createQuaternionFromYaw(0.0), tf::Point(1.0, 2.5, 0.0)), ros::Time(), "map");
+  tf::Stamped<tf::Pose> robot_vel(tf::Pose(tf::createQuaternionFromYaw(0.0), tf::Point(0.0, 0.0, 0.0)), ros::Time(), "base_link");
+  tf::Stamped<tf::Pose> drive_cmds;
+  EXPECT_GE(planner.findBestPath(pose, robot_vel, drive_cmds).cost_, 0.0);
+  EXPECT_GT(drive_cmds.getOrigin().x(), 0.0);
+  EXPECT_FLOAT_EQ(drive_cmds.getOrigin().x(), planner.last_cmd_vel_[0]);
+  planner.recordCommand(0.0, 0.0, 0.4);
+  pos = Eigen::Vector3f(1.0, 2.5, 0.0);
+  vel = Eigen::Vector3f(0.0, 0.0, 0.0);
+  planner.predictStartState(pos, vel, 0.5);
+  EXPECT_NEAR(1.0, pos[0], 1e-6);
+  EXPECT_NEAR(0.0, vel[0], 1e-6);
+  EXPECT_NEAR(0.4, vel[2], 1e-6);
+}
+
 
 TrajectoryPlannerTest* tct = NULL;
 
@@ -212,4 +491,28 @@ TEST(TrajectoryPlannerTest, checkPathDistance){
   tct->checkPathDistance();
 }
 
+//make sure that gating samples on their endpoint selects the same trajectory as rolling all of them out
+TEST(TrajectoryPlannerTest, endpointGate){
+  TrajectoryPlannerTest* tct = setup_testclass_singleton();
+  tct->endpointGate();
+}
+
+//make sure that a blocked robot only searches again once its plan, surroundings or pose change
+TEST(TrajectoryPlannerTest, blockedSearch){
+  TrajectoryPlannerTest* tct = setup_testclass_singleton();
+  tct->blockedSearch();
+}
+
+//make sure that footprints switch between cycles, with their radii, and are rebuilt for other heading bins
+TEST(TrajectoryPlannerTest, footprintSwitching){
+  TrajectoryPlannerTest* tct = setup_testclass_singleton();
+  tct->footprintSwitching();
+}
+
+//make sure that the start state is predicted from the last command sent, within the acceleration limits
+TEST(TrajectoryPlannerTest, predictStartState){
+  TrajectoryPlannerTest* tct = setup_testclass_singleton();
+  tct->predictStartState();
+}
+
 }; //namespace
@@ -0,0 +1,196 @@
+/*
+ * voxel_grid_model_test.cpp
+ */
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <set>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <base_local_planner/voxel_grid_model.h>
+
+namespace base_local_planner {
+
+static std::vector<geometry_msgs::Point> squarePolygon(double half_width) {
+  std::vector<geometry_msgs::Point> polygon;
+  geometry_msgs::Point pt;
+  pt.x = half_width; pt.y = half_width;
+  polygon.push_back(pt);
+  pt.x = half_width; pt.y = -half_width;
+  polygon.push_back(pt);
+  pt.x = -half_width; pt.y = -half_width;
+  polygon.push_back(pt);
+  pt.x = -half_width; pt.y = half_width;
+  polygon.push_back(pt);
+  return polygon;
+}
+
+//the voxels left in a grid
+static std::set<std::vector<float> > markedVoxels(VoxelGridModel& model) {
+  pcl::PointCloud<pcl::PointXYZ> cloud;
+  model.getPoints(cloud);
+  std::set<std::vector<float> > voxels;
+  for (unsigned int i = 0; i < cloud.points.size(); ++i) {
+    std::vector<float> voxel(3);
+    voxel[0] = cloud.points[i].x; voxel[1] = cloud.points[i].y; voxel[2] = cloud.points[i].z;
+    voxels.insert(voxel);
+  }
+  return voxels;
+}
+
+//a low obstacle only blocks the parts of the robot at its height
+TEST(VoxelGridModelTest, sectionsAboveObstaclesPass){
+  VoxelGridModel model(60, 60, 10, 0.05, 0.2, 0.0, 0.0, 0.0, 2.0, 10.0);
+  sensor_msgs::LaserScan scan;
+  scan.angle_min = 0.0;
+  scan.angle_increment = 0.01;
+  scan.range_min = 0.0;
+  scan.range_max = 5.0;
+  scan.ranges.push_back(1.02);
+  geometry_msgs::Point sensor;
+  sensor.x = 0.5; sensor.y = 1.5; sensor.z = 0.1;
+  std::vector<geometry_msgs::Point> footprint = squarePolygon(0.2);
+  model.updateWorld(footprint, scan, sensor, 0.0);
+
+  //the front edge of the robot crosses the column of the obstacle
+  double x = 1.31, y = 1.5;
+  EXPECT_LT(model.footprintCost(x, y, 0.0, footprint), 0.0);
+
+  FootprintSection base, mast;
+  base.polygon = footprint;
+  base.min_z = 0.0;
+  base.max_z = 0.3;
+  mast.polygon = footprint;
+  mast.min_z = 0.5;
+  mast.max_z = 1.5;
+
+  std::vector<FootprintSection> sections(1, mast);
+  model.setFootprintSections(sections);
+  EXPECT_GE(model.footprintCost(x, y, 0.0, footprint), 0.0);
+
+  sections.push_back(base);
+  model.setFootprintSections(sections);
+  EXPECT_LT(model.footprintCost(x, y, 0.0, footprint), 0.0);
+
+  //away from the obstacle every section passes
+  EXPECT_GE(model.footprintCost(0.8, y, 0.0, footprint), 0.0);
+}
+
+//the grid rolls along with the local costmap, keeping what it saw of the area both cover
+TEST(VoxelGridModelTest, followsRollingWindow){
+  //a 2m window centered on the robot
+  VoxelGridModel model(40, 40, 10, 0.05, 0.2, 0.0, 0.0, 0.0, 2.0, 10.0);
+  sensor_msgs::LaserScan scan;
+  scan.angle_min = 0.0;
+  scan.angle_increment = 0.01;
+  scan.range_min = 0.0;
+  scan.range_max = 5.0;
+  scan.ranges.push_back(0.0);
+  std::vector<geometry_msgs::Point> footprint = squarePolygon(0.2);
+
+  //the robot drives along x out of the starting window, towards a wall at 3.5m
+  double wall_x = 3.52;
+  for(double robot_x = 1.0; robot_x <= 3.0 + 1e-9; robot_x += 0.25){
+    model.updateOrigin(robot_x - 1.0, 0.0);
+    geometry_msgs::Point sensor;
+    sensor.x = robot_x; sensor.y = 1.0; sensor.z = 0.1;
+    scan.ranges[0] = wall_x - robot_x;
+    model.updateWorld(footprint, scan, sensor, 0.0);
+    EXPECT_GE(model.footprintCost(robot_x, 1.0, 0.0, footprint), 0.0) << "robot at " << robot_x;
+  }
+
+  //the wall was marked once it came into the window, and stays where it is in the world... the front edge of the robot crosses it
+  EXPECT_LT(model.footprintCost(wall_x - 0.21, 1.0, 0.0, footprint), 0.0);
+  pcl::PointCloud<pcl::PointXYZ> cloud;
+  model.getPoints(cloud);
+  ASSERT_EQ(1u, cloud.points.size());
+  EXPECT_NEAR(wall_x, cloud.points[0].x, 0.05);
+  EXPECT_NEAR(1.0, cloud.points[0].y, 0.05);
+
+  //moving on without seeing it, the wall stays until it leaves the window
+  model.updateOrigin(3.0, 0.0);
+  cloud.points.clear();
+  model.getPoints(cloud);
+  EXPECT_EQ(1u, cloud.points.size());
+  EXPECT_GE(model.footprintCost(4.5, 1.0, 0.0, footprint), 0.0);
+  model.updateOrigin(4.0, 0.0);
+  cloud.points.clear();
+  model.getPoints(cloud);
+  EXPECT_EQ(0u, cloud.points.size());
+}
+
+//a scan read straight from its ranges clears and marks the same voxels as its planar scan and cloud
+TEST(VoxelGridModelTest, scanMatchesPlanarScan){
+  VoxelGridModel scan_model(120, 120, 10, 0.05, 0.2, 0.0, 0.0, 0.0, 2.0, 1.8);
+  VoxelGridModel planar_model(120, 120, 10, 0.05, 0.2, 0.0, 0.0, 0.0, 2.0, 1.8);
+  std::vector<geometry_msgs::Point> footprint;
+  std::vector<PlanarLaserScan> no_scans;
+
+  geometry_msgs::Point sensor;
+  sensor.x = 3.0; sensor.y = 3.0; sensor.z = 0.1;
+  std::vector<costmap_2d::Observation> seen(1);
+  seen[0].origin_ = sensor;
+  for (double x = 1.0; x < 5.0; x += 0.07) {
+    for (double y = 1.0; y < 5.0; y += 0.07) {
+      pcl::PointXYZ pt;
+      pt.x = x; pt.y = y; pt.z = 0.1;
+      seen[0].cloud_->push_back(pt);
+    }
+  }
+  scan_model.updateWorld(footprint, seen, no_scans);
+  planar_model.updateWorld(footprint, seen, no_scans);
+  unsigned int num_seen = markedVoxels(scan_model).size();
+
+  //the beams start away from the heading of the scanner and cross the wrap-around of the angles in the grid
+  sensor_msgs::LaserScan scan;
+  scan.angle_min = -0.6;
+  scan.angle_increment = 0.04;
+  scan.range_min = 0.05;
+  scan.range_max = 2.5;
+  for (unsigned int i = 0; i < 100; ++i) {
+    scan.ranges.push_back(1.5 + 0.8 * sin(0.15 * i));
+  }
+  scan.ranges[40] = std::numeric_limits<float>::infinity();
+  scan.ranges[41] = 7.0;
+  scan.ranges[70] = std::numeric_limits<float>::quiet_NaN();
+  scan.ranges[85] = 0.01;
+  double yaw = 2.8;
+
+  //the planar scan ends where each beam saw free space to, the cloud holds the hits
+  std::vector<PlanarLaserScan> planar(1);
+  planar[0].origin.x = sensor.x; planar[0].origin.y = sensor.y; planar[0].origin.z = sensor.z;
+  std::vector<costmap_2d::Observation> hits(1);
+  hits[0].origin_ = sensor;
+  for (unsigned int i = 0; i < scan.ranges.size(); ++i) {
+    float range = scan.ranges[i];
+    if (!(range >= scan.range_min))
+      continue;
+    double clear_range = std::min((double) range, (double) scan.range_max);
+    double angle = yaw + scan.angle_min + i * scan.angle_increment;
+    geometry_msgs::Point32 end;
+    end.x = sensor.x + clear_range * cos(angle);
+    end.y = sensor.y + clear_range * sin(angle);
+    end.z = sensor.z;
+    planar[0].cloud.points.push_back(end);
+    if (range < scan.range_max) {
+      pcl::PointXYZ pt;
+      pt.x = end.x; pt.y = end.y; pt.z = end.z;
+      hits[0].cloud_->push_back(pt);
+    }
+  }
+
+  scan_model.updateWorld(footprint, scan, sensor, yaw);
+  planar_model.updateWorld(footprint, hits, planar);
+
+  std::set<std::vector<float> > scan_voxels = markedVoxels(scan_model);
+  std::set<std::vector<float> > planar_voxels = markedVoxels(planar_model);
+  EXPECT_LT(planar_voxels.size() + 500, num_seen);
+  EXPECT_EQ(planar_voxels.size(), scan_voxels.size());
+  for (std::set<std::vector<float> >::const_iterator it = planar_voxels.begin(); it != planar_voxels.end(); ++it) {
+    EXPECT_TRUE(scan_voxels.count(*it)) << (*it)[0] << " " << (*it)[1] << " " << (*it)[2];
+  }
+}
+
+}